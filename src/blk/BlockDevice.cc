@@ -163,7 +163,7 @@ BlockDevice* BlockDevice::create_with_type(block_device_t device_type,
 #endif
 #if defined(HAVE_SPDK)
   case block_device_t::spdk:
-    return new NVMEDevice(cct, cb, cbpriv);
+    return new NVMEDevice(cct, cb, cbpriv, d_cb, d_cbpriv);
 #endif
 #if defined(HAVE_BLUESTORE_PMEM)
   case block_device_t::pmem:
@@ -181,9 +181,11 @@ BlockDevice* BlockDevice::create_with_type(block_device_t device_type,
 
 BlockDevice *BlockDevice::create(
     CephContext* cct, const string& path, aio_callback_t cb,
-    void *cbpriv, aio_callback_t d_cb, void *d_cbpriv)
+    void *cbpriv, aio_callback_t d_cb, void *d_cbpriv,
+    const string& dev_type)
 {
-  const string blk_dev_name = cct->_conf.get_val<string>("bdev_type");
+  const string blk_dev_name = dev_type.empty() ?
+    cct->_conf.get_val<string>("bdev_type") : dev_type;
   block_device_t device_type = block_device_t::unknown;
   if (blk_dev_name.empty()) {
     device_type = detect_device_type(path);
@@ -200,8 +200,10 @@ public:
  {}
   virtual ~BlockDevice() = default;
 
+  /// dev_type selects the driver by name, overriding bdev_type, if not empty
   static BlockDevice *create(
-    CephContext* cct, const std::string& path, aio_callback_t cb, void *cbpriv, aio_callback_t d_cb, void *d_cbpriv);
+    CephContext* cct, const std::string& path, aio_callback_t cb, void *cbpriv, aio_callback_t d_cb, void *d_cbpriv,
+    const std::string& dev_type = std::string());
   virtual bool supported_bdev_label() { return true; }
   virtual bool is_rotational() { return rotational; }
 
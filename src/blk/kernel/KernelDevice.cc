@@ -39,6 +39,7 @@
 #endif
 #include "common/debug.h"
 #include "common/numa.h"
+#include "common/perf_counters.h"
 
 #include "global/global_context.h"
 #include "io_uring.h"
@@ -255,6 +256,7 @@ int KernelDevice::open(const string& p)
   if (r < 0) {
     goto out_fail;
   }
+  _create_logger();
   _discard_start();
 
   // round size down to an even block
@@ -303,6 +305,7 @@ void KernelDevice::close()
   dout(1) << __func__ << dendl;
   _aio_stop();
   _discard_stop();
+  _destroy_logger();
   _pre_close();
 
   if (vdo_fd >= 0) {
@@ -543,9 +546,48 @@ void KernelDevice::discard_drain()
 {
   dout(10) << __func__ << dendl;
   std::unique_lock l(discard_lock);
+  // do not wait for the queued extents to age
+  ++discard_draining;
+  discard_cond.notify_all();
   while (!discard_queued.empty() || discard_running) {
     discard_cond.wait(l);
   }
+  --discard_draining;
+}
+
+void KernelDevice::_create_logger()
+{
+  std::string name = path;
+  if (auto slash = name.rfind('/'); slash != std::string::npos) {
+    name = name.substr(slash + 1);
+  }
+  PerfCountersBuilder b(cct, "bdev-" + name, l_bdev_first, l_bdev_last);
+  b.add_u64(l_bdev_discard_queued_bytes, "discard_queued_bytes",
+	    "Bytes waiting to be discarded", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64(l_bdev_discard_queued_extents, "discard_queued_extents",
+	    "Extents waiting to be discarded");
+  b.add_u64_counter(l_bdev_discard_bytes, "discard_bytes",
+		    "Bytes discarded", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bdev_discard_ops, "discard_ops",
+		    "Discard requests issued");
+  b.add_time_avg(l_bdev_discard_lat, "discard_lat",
+		 "Average latency of a discard request");
+  b.add_u64_counter(l_bdev_discard_throttled, "discard_throttled",
+		    "Discard rounds slowed down by the device latency");
+  b.add_u64(l_bdev_discard_budget, "discard_budget",
+	    "Bytes the discard thread may issue in a round", NULL, 0,
+	    unit_t(UNIT_BYTES));
+  logger = b.create_perf_counters();
+  cct->get_perfcounters_collection()->add(logger);
+}
+
+void KernelDevice::_destroy_logger()
+{
+  if (logger) {
+    cct->get_perfcounters_collection()->remove(logger);
+    delete logger;
+    logger = nullptr;
+  }
 }
 
 static bool is_expected_ioerr(const int r)
@@ -699,24 +741,114 @@ void KernelDevice::_discard_thread()
       discard_cond.wait(l);
       dout(20) << __func__ << " wake" << dendl;
     } else {
-      discard_finishing.swap(discard_queued);
+      // let the freed extents pile up for a while, so that the adjacent
+      // ones are merged into fewer and larger discards
+      auto delay = make_timespan(
+	cct->_conf.get_val<double>("bdev_async_discard_delay"));
+      auto until = std::max(discard_queued_since + delay, discard_resume_at);
+      if (!discard_stop && !discard_draining && mono_clock::now() < until) {
+	dout(20) << __func__ << " waiting for the queue to age" << dendl;
+	discard_cond.wait_until(l, until);
+	continue;
+      }
+
+      uint64_t max_bytes =
+	cct->_conf.get_val<Option::size_t>("bdev_async_discard_max_bytes");
+      double target_lat =
+	cct->_conf.get_val<double>("bdev_async_discard_target_latency");
+      if (!max_bytes) {
+	max_bytes = std::numeric_limits<uint64_t>::max();
+      }
+      if (!discard_budget || discard_budget > max_bytes || !target_lat) {
+	discard_budget = max_bytes;
+      }
+      _discard_take(discard_stop || discard_draining ?
+		    std::numeric_limits<uint64_t>::max() : discard_budget);
       discard_running = true;
       l.unlock();
-      dout(20) << __func__ << " finishing" << dendl;
+      dout(20) << __func__ << " finishing 0x" << std::hex
+	       << discard_finishing.size() << std::dec << " bytes in "
+	       << discard_finishing.num_intervals() << " extents" << dendl;
+      auto start = mono_clock::now();
       for (auto p = discard_finishing.begin();p != discard_finishing.end(); ++p) {
+	auto t0 = mono_clock::now();
 	discard(p.get_start(), p.get_len());
+	logger->tinc(l_bdev_discard_lat, mono_clock::now() - t0);
       }
+      auto elapsed = mono_clock::now() - start;
+      logger->inc(l_bdev_discard_bytes, discard_finishing.size());
+      logger->inc(l_bdev_discard_ops, discard_finishing.num_intervals());
 
       discard_callback(discard_callback_priv, static_cast<void*>(&discard_finishing));
+      auto avg_lat = elapsed / std::max<uint64_t>(discard_finishing.num_intervals(), 1);
+      uint64_t round_bytes = discard_finishing.size();
       discard_finishing.clear();
       l.lock();
       discard_running = false;
+      logger->set(l_bdev_discard_queued_bytes, discard_queued.size());
+      logger->set(l_bdev_discard_queued_extents, discard_queued.num_intervals());
+
+      if (target_lat > 0) {
+	_discard_throttle(round_bytes, avg_lat, max_bytes, target_lat);
+	if (avg_lat > make_timespan(target_lat)) {
+	  // leave the device to the foreground io for as long as the
+	  // discards kept it busy
+	  logger->inc(l_bdev_discard_throttled);
+	  discard_resume_at = mono_clock::now() + elapsed;
+	}
+      }
     }
   }
   dout(10) << __func__ << " finish" << dendl;
   discard_started = false;
 }
 
+void KernelDevice::_discard_take(uint64_t budget)
+{
+  ceph_assert(ceph_mutex_is_locked(discard_lock));
+  ceph_assert(discard_finishing.empty());
+  if (discard_queued.size() <= budget) {
+    discard_finishing.swap(discard_queued);
+    return;
+  }
+  // the lowest extents go first, the others keep their place in the queue
+  while (budget > 0 && !discard_queued.empty()) {
+    auto p = discard_queued.begin();
+    uint64_t off = p.get_start();
+    uint64_t len = std::min(p.get_len(), budget);
+    discard_queued.erase(off, len);
+    discard_finishing.insert(off, len);
+    budget -= len;
+  }
+}
+
+void KernelDevice::_discard_throttle(uint64_t round_bytes,
+				     ceph::timespan avg_lat,
+				     uint64_t max_bytes,
+				     double target_lat)
+{
+  // halve the bytes of the last round when the device gets slow, grow the
+  // budget back by an eighth of the maximum otherwise. a round issues at
+  // least 1 MiB.
+  const uint64_t min_bytes = std::min<uint64_t>(max_bytes, 1 << 20);
+  uint64_t budget = std::min(discard_budget, max_bytes);
+  if (avg_lat > make_timespan(target_lat)) {
+    budget = std::max(std::min(budget, round_bytes) / 2, min_bytes);
+  } else if (max_bytes == std::numeric_limits<uint64_t>::max()) {
+    budget = max_bytes;
+  } else {
+    budget = std::min(budget + std::max(max_bytes / 8, min_bytes), max_bytes);
+  }
+  if (budget != discard_budget) {
+    dout(10) << __func__ << " average latency " << avg_lat
+	     << " budget 0x" << std::hex << discard_budget << " -> 0x" << budget
+	     << std::dec << dendl;
+  }
+  discard_budget = budget;
+  logger->set(l_bdev_discard_budget,
+	      std::min<uint64_t>(budget, std::numeric_limits<int64_t>::max()));
+}
+
 int KernelDevice::queue_discard(interval_set<uint64_t> &to_release)
 {
   if (!support_discard)
@@ -726,7 +858,12 @@ int KernelDevice::queue_discard(interval_set<uint64_t> &to_release)
     return 0;
 
   std::lock_guard l(discard_lock);
+  if (discard_queued.empty()) {
+    discard_queued_since = mono_clock::now();
+  }
   discard_queued.insert(to_release);
+  logger->set(l_bdev_discard_queued_bytes, discard_queued.size());
+  logger->set(l_bdev_discard_queued_extents, discard_queued.num_intervals());
   discard_cond.notify_all();
   return 0;
 }
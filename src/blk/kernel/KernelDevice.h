@@ -27,6 +27,20 @@
 
 #define RW_IO_MAX (INT_MAX & CEPH_PAGE_MASK)
 
+class PerfCounters;
+
+enum {
+  l_bdev_first = 733100,
+  l_bdev_discard_queued_bytes,
+  l_bdev_discard_queued_extents,
+  l_bdev_discard_bytes,
+  l_bdev_discard_ops,
+  l_bdev_discard_lat,
+  l_bdev_discard_throttled,
+  l_bdev_discard_budget,
+  l_bdev_last
+};
+
 class KernelDevice : public BlockDevice {
 protected:
   std::string path;
@@ -56,8 +70,17 @@ private:
   ceph::mutex discard_lock = ceph::make_mutex("KernelDevice::discard_lock");
   ceph::condition_variable discard_cond;
   bool discard_running = false;
+  int discard_draining = 0;
   interval_set<uint64_t> discard_queued;
   interval_set<uint64_t> discard_finishing;
+  /// when the oldest of the queued extents was queued
+  ceph::mono_time discard_queued_since;
+  /// how many bytes the discard thread may issue in a round
+  uint64_t discard_budget = 0;
+  /// the discard thread is paused until then, to let the foreground io in
+  ceph::mono_time discard_resume_at;
+
+  PerfCounters *logger = nullptr;
 
   struct AioCompletionThread : public Thread {
     KernelDevice *bdev;
@@ -91,6 +114,14 @@ private:
 
   int _discard_start();
   void _discard_stop();
+  /// move up to @p budget bytes of the queued extents to discard_finishing
+  void _discard_take(uint64_t budget);
+  /// adjust the discard budget to the latency of the last round
+  void _discard_throttle(uint64_t round_bytes, ceph::timespan avg_lat,
+			 uint64_t max_bytes, double target_lat);
+
+  void _create_logger();
+  void _destroy_logger();
 
   void _aio_log_start(IOContext *ioc, uint64_t offset, uint64_t length);
   void _aio_log_finish(IOContext *ioc, uint64_t offset, uint64_t length);
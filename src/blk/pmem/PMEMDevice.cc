@@ -150,14 +150,20 @@ int PMEMDevice::open(const std::string& p)
   }
 
   size_t map_len;
+  int pmem;
   addr = (char *)pmem_map_file(path.c_str(), 0,
                                devdax_device ? 0: PMEM_FILE_EXCL, O_RDWR,
-			       &map_len, NULL);
+			       &map_len, &pmem);
   if (addr == NULL) {
     derr << __func__ << " pmem_map_file failed: " << pmem_errormsg() << dendl;
     goto out_fail;
   }
   size = map_len;
+  is_pmem = pmem;
+  if (!is_pmem) {
+    dout(1) << __func__ << " " << path << " is not persistent memory,"
+	    << " emulating DAX with msync" << dendl;
+  }
 
   // Operate as though the block size is 4 KB.  The backing file
   // blksize doesn't strictly matter except that some file systems may
@@ -192,7 +198,9 @@ void PMEMDevice::close()
   if (devdax_device) {
     devdax_device = false;
   }
+  flush();
   pmem_unmap(addr, size);
+  is_pmem = false;
 
   ceph_assert(fd >= 0);
   VOID_TEMP_FAILURE_RETRY(::close(fd));
@@ -273,7 +281,24 @@ bool PMEMDevice::support(const std::string &path)
 
 int PMEMDevice::flush()
 {
-  //Because all write is persist. So no need
+  // every write to real pmem is already persistent
+  if (is_pmem) {
+    return 0;
+  }
+  interval_set<uint64_t> to_sync;
+  {
+    std::lock_guard l(dirty_lock);
+    to_sync.swap(dirty);
+  }
+  for (auto p = to_sync.begin(); p != to_sync.end(); ++p) {
+    dout(20) << __func__ << " msync 0x" << std::hex << p.get_start() << "~"
+	     << p.get_len() << std::dec << dendl;
+    if (pmem_msync(addr + p.get_start(), p.get_len()) < 0) {
+      int r = -errno;
+      derr << __func__ << " msync got: " << cpp_strerror(r) << dendl;
+      return r;
+    }
+  }
   return 0;
 }
 
@@ -309,6 +334,21 @@ int PMEMDevice::write(uint64_t off, bufferlist& bl, bool buffered, int write_hin
 
   bufferlist::iterator p = bl.begin();
   uint64_t off1 = off;
+  if (!is_pmem) {
+    // emulated DAX: copy now, persist on flush()
+    {
+      std::lock_guard l(dirty_lock);
+      dirty.union_insert(off, len);
+    }
+    while (len) {
+      const char *data;
+      uint32_t l = p.get_ptr_and_advance(len, &data);
+      memcpy(addr + off1, data, l);
+      len -= l;
+      off1 += l;
+    }
+    return 0;
+  }
   while (len) {
     const char *data;
     uint32_t l = p.get_ptr_and_advance(len, &data);
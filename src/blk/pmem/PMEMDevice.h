@@ -31,6 +31,12 @@ class PMEMDevice : public BlockDevice {
   char *addr; //the address of mmap
   std::string path;
   bool devdax_device = false;
+  /// the mapping is real persistent memory; otherwise it is an emulated
+  /// DAX mapping of a regular file, persisted by msync() on flush()
+  bool is_pmem = false;
+
+  ceph::mutex dirty_lock = ceph::make_mutex("PMEMDevice::dirty_lock");
+  interval_set<uint64_t> dirty;  ///< written but not yet msync'ed
 
   ceph::mutex debug_lock = ceph::make_mutex("PMEMDevice::debug_lock");
   interval_set<uint64_t> debug_inflight;
@@ -114,6 +114,9 @@ class SharedDriverData {
   uint32_t get_block_size() {
     return block_size;
   }
+  uint32_t get_ns_flags() {
+    return spdk_nvme_ns_get_flags(ns);
+  }
   uint64_t get_size() {
     return size;
   }
@@ -183,6 +186,8 @@ struct Task {
   int64_t return_code;
   Task *primary = nullptr;
   IORequest io_request = {};
+  /// the ranges to deallocate, for a discard
+  std::vector<spdk_nvme_dsm_range> dsm_ranges;
   SharedDriverQueueData *queue = nullptr;
   // reference count by subtasks.
   int ref = 0;
@@ -345,7 +350,8 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
       }
     }
 
-    for (; t; t = t->next) {
+    for (Task *next; t; t = next) {
+      next = t->next;
       if (current_queue_depth == max_queue_depth) {
         // no slots
         goto again;
@@ -406,6 +412,24 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
           }
           break;
         }
+        case IOCommand::DISCARD_COMMAND:
+        {
+          dout(20) << __func__ << " discard command issued "
+                   << t->dsm_ranges.size() << " ranges" << dendl;
+          r = spdk_nvme_ns_cmd_dataset_management(
+              ns, qpair, SPDK_NVME_DSM_ATTR_DEALLOCATE,
+              t->dsm_ranges.data(), t->dsm_ranges.size(), io_complete, t);
+          if (r < 0) {
+            // the deallocation is only a hint, complete it as io_complete()
+            // does for a failed one
+            derr << __func__ << " failed to discard: " << cpp_strerror(r) << dendl;
+            t->ctx->set_return_value(r);
+            t->ctx->try_aio_wake();
+            delete t;
+            continue;
+          }
+          break;
+        }
       }
       current_queue_depth++;
     }
@@ -664,11 +688,24 @@ void io_complete(void *t, const struct spdk_nvme_cpl *completion)
       }
       --ctx->num_running;
     }
-  } else {
-    ceph_assert(task->command == IOCommand::FLUSH_COMMAND);
+  } else if (task->command == IOCommand::FLUSH_COMMAND) {
     ceph_assert(!spdk_nvme_cpl_is_error(completion));
     dout(20) << __func__ << " flush op successfully" << dendl;
-    task->return_code = 0;
+    ctx->try_aio_wake();
+    delete task;
+  } else {
+    ceph_assert(task->command == IOCommand::DISCARD_COMMAND);
+    // the deallocation is only a hint, a failure loses no data
+    if (spdk_nvme_cpl_is_error(completion)) {
+      derr << __func__ << " discard of " << task->dsm_ranges.size()
+           << " ranges failed: " << spdk_nvme_cpl_get_status_string(&completion->status)
+           << dendl;
+      ctx->set_return_value(-EIO);
+    } else {
+      dout(20) << __func__ << " discard op successfully" << dendl;
+    }
+    ctx->try_aio_wake();
+    delete task;
   }
 }
 
@@ -676,9 +713,13 @@ void io_complete(void *t, const struct spdk_nvme_cpl *completion)
 #undef dout_prefix
 #define dout_prefix *_dout << "bdev(" << name << ") "
 
-NVMEDevice::NVMEDevice(CephContext* cct, aio_callback_t cb, void *cbpriv)
+NVMEDevice::NVMEDevice(CephContext* cct, aio_callback_t cb, void *cbpriv,
+                       aio_callback_t d_cb, void *d_cbpriv)
   :   BlockDevice(cct, cb, cbpriv),
-      driver(nullptr)
+      driver(nullptr),
+      discard_callback(d_cb),
+      discard_callback_priv(d_cbpriv),
+      discard_thread(this)
 {
 }
 
@@ -726,12 +767,20 @@ int NVMEDevice::open(const string& p)
   //nvme is non-rotational device.
   rotational = false;
 
+  uint32_t ns_flags = driver->get_ns_flags();
+  support_discard = ns_flags & SPDK_NVME_NS_DEALLOCATE_SUPPORTED;
+  support_flush = ns_flags & SPDK_NVME_NS_FLUSH_SUPPORTED;
+  discard_thread.create("bstore_discard");
+
   // round size down to an even block
   size &= ~(block_size - 1);
 
   dout(1) << __func__ << " size " << size << " (" << byte_u_t(size) << ")"
           << " block_size " << block_size << " (" << byte_u_t(block_size)
-          << ")" << dendl;
+          << ")"
+          << " discard " << (support_discard ? "supported" : "not supported")
+          << " flush " << (support_flush ? "supported" : "not supported")
+          << dendl;
 
 
   return 0;
@@ -741,6 +790,7 @@ void NVMEDevice::close()
 {
   dout(1) << __func__ << dendl;
 
+  _discard_stop();
   name.clear();
   driver->remove_device(this);
 
@@ -756,15 +806,150 @@ int NVMEDevice::collect_metadata(const string& prefix, map<string,string> *pm) c
   (*pm)[prefix + "type"] = "nvme";
   (*pm)[prefix + "access_mode"] = "spdk";
   (*pm)[prefix + "nvme_serial_number"] = name;
+  (*pm)[prefix + "support_discard"] = stringify((int)(bool)support_discard);
 
   return 0;
 }
 
+static void ioc_append_task(IOContext *ioc, Task *t);
+
 int NVMEDevice::flush()
 {
+  if (!support_flush) {
+    // the writes are stable once completed
+    return 0;
+  }
+  dout(10) << __func__ << dendl;
+  IOContext ioc(cct, nullptr);
+  Task *t = new Task(this, IOCommand::FLUSH_COMMAND, 0, 0);
+  t->ctx = &ioc;
+  ioc_append_task(&ioc, t);
+  aio_submit(&ioc);
+  ioc.aio_wait();
   return 0;
 }
 
+int NVMEDevice::_discard(const interval_set<uint64_t>& extents)
+{
+  // a dataset management command takes up to 256 ranges of up to 4G
+  // blocks each
+  const uint64_t max_range_len = (uint64_t)UINT32_MAX * block_size;
+  IOContext ioc(cct, nullptr);
+  Task *t = nullptr;
+  for (auto p = extents.begin(); p != extents.end(); ++p) {
+    uint64_t off = p.get_start();
+    uint64_t len = p.get_len();
+    ceph_assert(is_valid_io(off, len));
+    while (len > 0) {
+      uint64_t range_len = std::min(len, max_range_len);
+      if (!t || t->dsm_ranges.size() == SPDK_NVME_DATASET_MANAGEMENT_MAX_RANGES) {
+        t = new Task(this, IOCommand::DISCARD_COMMAND, off, 0);
+        t->ctx = &ioc;
+        t->dsm_ranges.reserve(std::min<size_t>(
+          extents.num_intervals(), SPDK_NVME_DATASET_MANAGEMENT_MAX_RANGES));
+        ioc_append_task(&ioc, t);
+      }
+      spdk_nvme_dsm_range range = {};
+      range.attributes.raw = 0;
+      range.length = range_len / block_size;
+      range.starting_lba = off / block_size;
+      t->dsm_ranges.push_back(range);
+      off += range_len;
+      len -= range_len;
+    }
+  }
+  dout(10) << __func__ << " " << std::hex << extents << std::dec
+           << " in " << ioc.num_pending.load() << " commands" << dendl;
+  aio_submit(&ioc);
+  ioc.aio_wait();
+  return ioc.get_return_value();
+}
+
+int NVMEDevice::discard(uint64_t offset, uint64_t len)
+{
+  if (!support_discard || !len) {
+    return 0;
+  }
+  dout(10) << __func__ << " 0x" << std::hex << offset << "~" << len
+           << std::dec << dendl;
+  interval_set<uint64_t> extents;
+  extents.insert(offset, len);
+  return _discard(extents);
+}
+
+int NVMEDevice::queue_discard(interval_set<uint64_t> &to_release)
+{
+  if (!support_discard)
+    return -1;
+
+  if (to_release.empty())
+    return 0;
+
+  std::lock_guard l(discard_lock);
+  discard_queued.insert(to_release);
+  discard_cond.notify_all();
+  return 0;
+}
+
+void NVMEDevice::discard_drain()
+{
+  dout(10) << __func__ << dendl;
+  std::unique_lock l(discard_lock);
+  while (!discard_queued.empty() || discard_running) {
+    discard_cond.wait(l);
+  }
+}
+
+void NVMEDevice::_discard_thread()
+{
+  std::unique_lock l(discard_lock);
+  ceph_assert(!discard_started);
+  discard_started = true;
+  discard_cond.notify_all();
+  while (true) {
+    ceph_assert(discard_finishing.empty());
+    if (discard_queued.empty()) {
+      if (discard_stop)
+        break;
+      dout(20) << __func__ << " sleep" << dendl;
+      discard_cond.notify_all(); // for the thread trying to drain...
+      discard_cond.wait(l);
+      dout(20) << __func__ << " wake" << dendl;
+    } else {
+      discard_finishing.swap(discard_queued);
+      discard_running = true;
+      l.unlock();
+      dout(20) << __func__ << " finishing" << dendl;
+      _discard(discard_finishing);
+      discard_callback(discard_callback_priv, static_cast<void*>(&discard_finishing));
+      discard_finishing.clear();
+      l.lock();
+      discard_running = false;
+    }
+  }
+  dout(10) << __func__ << " finish" << dendl;
+  discard_started = false;
+}
+
+void NVMEDevice::_discard_stop()
+{
+  dout(10) << __func__ << dendl;
+  {
+    std::unique_lock l(discard_lock);
+    while (!discard_started) {
+      discard_cond.wait(l);
+    }
+    discard_stop = true;
+    discard_cond.notify_all();
+  }
+  discard_thread.join();
+  {
+    std::lock_guard l(discard_lock);
+    discard_stop = false;
+  }
+  dout(10) << __func__ << " stopped" << dendl;
+}
+
 void NVMEDevice::aio_submit(IOContext *ioc)
 {
   dout(20) << __func__ << " ioc " << ioc << " pending "
@@ -779,8 +964,15 @@ void NVMEDevice::aio_submit(IOContext *ioc)
     // Only need to push the first entry
     ioc->nvme_task_first = ioc->nvme_task_last = nullptr;
 
-    thread_local SharedDriverQueueData queue_t = SharedDriverQueueData(this, driver);
-    queue_t._aio_handle(t, ioc);
+    // every thread submits through a queue pair of its own on each
+    // controller, so the bluestore and bluefs devices do not share them
+    thread_local std::map<SharedDriverData*,
+                          std::unique_ptr<SharedDriverQueueData>> queues;
+    auto& queue = queues[driver];
+    if (!queue) {
+      queue = std::make_unique<SharedDriverQueueData>(this, driver);
+    }
+    queue->_aio_handle(t, ioc);
   }
 }
 
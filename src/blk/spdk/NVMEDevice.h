@@ -27,12 +27,14 @@
 
 #include "include/interval_set.h"
 #include "common/ceph_time.h"
+#include "common/Thread.h"
 #include "BlockDevice.h"
 
 enum class IOCommand {
   READ_COMMAND,
   WRITE_COMMAND,
-  FLUSH_COMMAND
+  FLUSH_COMMAND,
+  DISCARD_COMMAND
 };
 
 class SharedDriverData;
@@ -46,11 +48,39 @@ class NVMEDevice : public BlockDevice {
    */
   SharedDriverData *driver;
   std::string name;
+  /// the namespace has a volatile write cache to flush
+  bool support_flush = false;
+
+  aio_callback_t discard_callback;
+  void *discard_callback_priv;
+  bool discard_started = false;
+  bool discard_stop = false;
+
+  ceph::mutex discard_lock = ceph::make_mutex("NVMEDevice::discard_lock");
+  ceph::condition_variable discard_cond;
+  bool discard_running = false;
+  interval_set<uint64_t> discard_queued;
+  interval_set<uint64_t> discard_finishing;
+
+  struct DiscardThread : public Thread {
+    NVMEDevice *bdev;
+    explicit DiscardThread(NVMEDevice *b) : bdev(b) {}
+    void *entry() override {
+      bdev->_discard_thread();
+      return NULL;
+    }
+  } discard_thread;
+
+  void _discard_thread();
+  void _discard_stop();
+  /// deallocate the extents, with as few commands as possible
+  int _discard(const interval_set<uint64_t>& extents);
 
  public:
   SharedDriverData *get_driver() { return driver; }
 
-  NVMEDevice(CephContext* cct, aio_callback_t cb, void *cbpriv);
+  NVMEDevice(CephContext* cct, aio_callback_t cb, void *cbpriv,
+	     aio_callback_t d_cb, void *d_cbpriv);
 
   bool supported_bdev_label() override { return false; }
 
@@ -72,6 +102,9 @@ class NVMEDevice : public BlockDevice {
 		int write_hint = WRITE_LIFE_NOT_SET) override;
   int write(uint64_t off, bufferlist& bl, bool buffered, int write_hint = WRITE_LIFE_NOT_SET) override;
   int flush() override;
+  int discard(uint64_t offset, uint64_t len) override;
+  int queue_discard(interval_set<uint64_t> &to_release) override;
+  void discard_drain() override;
   int read_random(uint64_t off, uint64_t len, char *buf, bool buffered) override;
 
   // for managing buffered readers/writers
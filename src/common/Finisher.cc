@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include "Finisher.h"
+#include "include/mempool.h"
 
 #define dout_subsys ceph_subsys_finisher
 #undef dout_prefix
@@ -53,12 +54,14 @@ void *Finisher::finisher_thread_entry()
       // while we are working.
       in_progress_queue.swap(finisher_queue);
       finisher_running = true;
+      utime_t queued = queue_stamp;
       ul.unlock();
       ldout(cct, 10) << "finisher_thread doing " << in_progress_queue << dendl;
 
       if (logger) {
 	start = ceph_clock_now();
 	count = in_progress_queue.size();
+	logger->tinc(l_finisher_queue_lat, start - queued);
       }
 
       // Now actually process the contexts.
@@ -83,6 +86,7 @@ void *Finisher::finisher_thread_entry()
       break;
     
     ldout(cct, 10) << "finisher_thread sleeping" << dendl;
+    mempool::flush_thread_cache();
     finisher_cond.wait(ul);
   }
   // If we are exiting, we signal the thread waiting in stop(),
@@ -94,3 +98,37 @@ void *Finisher::finisher_thread_entry()
   return 0;
 }
 
+ShardedFinisher::ShardedFinisher(CephContext *cct, const std::string& name,
+				 const std::string& tn, unsigned num_shards)
+{
+  ceph_assert(num_shards > 0);
+  if (num_shards == 1) {
+    shards.emplace_back(std::make_unique<Finisher>(cct, name, tn));
+    return;
+  }
+  for (unsigned i = 0; i < num_shards; i++) {
+    shards.emplace_back(std::make_unique<Finisher>(
+      cct, name + "-" + std::to_string(i), tn + std::to_string(i)));
+  }
+}
+
+void ShardedFinisher::start()
+{
+  for (auto& f : shards) {
+    f->start();
+  }
+}
+
+void ShardedFinisher::stop()
+{
+  for (auto& f : shards) {
+    f->stop();
+  }
+}
+
+void ShardedFinisher::wait_for_empty()
+{
+  for (auto& f : shards) {
+    f->wait_for_empty();
+  }
+}
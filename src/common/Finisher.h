@@ -15,6 +15,8 @@
 #ifndef CEPH_FINISHER_H
 #define CEPH_FINISHER_H
 
+#include <memory>
+
 #include "include/Context.h"
 #include "include/common_fwd.h"
 #include "common/Thread.h"
@@ -28,6 +30,7 @@ enum {
   l_finisher_first = 997082,
   l_finisher_queue_len,
   l_finisher_complete_lat,
+  l_finisher_queue_lat,
   l_finisher_last
 };
 
@@ -51,6 +54,9 @@ class Finisher {
 
   std::string thread_name;
 
+  /// When the queue last became non-empty, for the queue latency.
+  utime_t queue_stamp;
+
   /// Performance counter for the finisher's queue length.
   /// Only active for named finishers.
   PerfCounters *logger;
@@ -72,8 +78,11 @@ class Finisher {
     if (was_empty) {
       finisher_cond.notify_one();
     }
-    if (logger)
+    if (logger) {
+      if (was_empty)
+	queue_stamp = ceph_clock_now();
       logger->inc(l_finisher_queue_len);
+    }
   }
 
   void queue(std::list<Context*>& ls) {
@@ -81,6 +90,8 @@ class Finisher {
       std::unique_lock ul(finisher_lock);
       if (finisher_queue.empty()) {
 	finisher_cond.notify_all();
+	if (logger)
+	  queue_stamp = ceph_clock_now();
       }
       for (auto i : ls) {
 	finisher_queue.push_back(std::make_pair(i, 0));
@@ -95,6 +106,8 @@ class Finisher {
       std::unique_lock ul(finisher_lock);
       if (finisher_queue.empty()) {
 	finisher_cond.notify_all();
+	if (logger)
+	  queue_stamp = ceph_clock_now();
       }
       for (auto i : ls) {
 	finisher_queue.push_back(std::make_pair(i, 0));
@@ -109,6 +122,8 @@ class Finisher {
       std::unique_lock ul(finisher_lock);
       if (finisher_queue.empty()) {
 	finisher_cond.notify_all();
+	if (logger)
+	  queue_stamp = ceph_clock_now();
       }
       for (auto i : ls) {
 	finisher_queue.push_back(std::make_pair(i, 0));
@@ -153,6 +168,8 @@ class Finisher {
 			  l_finisher_first, l_finisher_last);
     b.add_u64(l_finisher_queue_len, "queue_len");
     b.add_time_avg(l_finisher_complete_lat, "complete_latency");
+    b.add_time_avg(l_finisher_queue_lat, "queue_latency",
+		   "Time the oldest context of a batch waited in the queue");
     logger = b.create_perf_counters();
     cct->get_perfcounters_collection()->add(logger);
     logger->set(l_finisher_queue_len, 0);
@@ -167,6 +184,39 @@ class Finisher {
   }
 };
 
+/** @brief Finishers completing contexts on several threads.
+ * The contexts queued with the same key, e.g. the id of an OpSequencer,
+ * are completed in order by the same shard, while those with different
+ * keys may be completed in parallel. With a single shard, this is a
+ * named Finisher. */
+class ShardedFinisher {
+  std::vector<std::unique_ptr<Finisher>> shards;
+
+  Finisher& shard_of(uint64_t key) {
+    return *shards[key % shards.size()];
+  }
+
+public:
+  ShardedFinisher(CephContext *cct, const std::string& name,
+		  const std::string& tn, unsigned num_shards);
+
+  unsigned get_num_shards() const {
+    return shards.size();
+  }
+
+  void queue(uint64_t key, Context *c, int r = 0) {
+    shard_of(key).queue(c, r);
+  }
+  template <typename T>
+  void queue(uint64_t key, T& ls) {
+    shard_of(key).queue(ls);
+  }
+
+  void start();
+  void stop();
+  void wait_for_empty();
+};
+
 /// Context that is completed asynchronously on the supplied finisher.
 class C_OnFinisher : public Context {
   Context *con;
@@ -15,11 +15,13 @@
 #define LARGE_SIZE 1024
 
 #include "HTMLFormatter.h"
+#include "common/deleter.h"
 #include "common/escape.h"
 #include "include/buffer.h"
 
 #include <fmt/format.h>
 #include <algorithm>
+#include <charconv>
 #include <set>
 #include <limits>
 
@@ -157,44 +159,66 @@ JSONFormatter::JSONFormatter(bool p)
 void JSONFormatter::flush(std::ostream& os)
 {
   finish_pending_string();
-  os << m_ss.str();
+  os.write(m_buf.data(), m_buf.size());
   if (m_line_break_enabled)
     os << "\n";
-  m_ss.clear();
-  m_ss.str("");
+  m_buf.clear();
+}
+
+void JSONFormatter::flush(bufferlist& bl)
+{
+  finish_pending_string();
+  if (m_line_break_enabled)
+    m_buf += '\n';
+  // hand large outputs over to the bufferlist rather than copying them
+  if (m_buf.size() >= CEPH_PAGE_SIZE) {
+    char *data = m_buf.data();
+    size_t len = m_buf.size();
+    bl.push_back(buffer::claim_buffer(len, data,
+                                      make_object_deleter(std::move(m_buf))));
+  } else {
+    bl.append(m_buf);
+  }
+  m_buf.clear();
 }
 
 void JSONFormatter::reset()
 {
   m_stack.clear();
-  m_ss.clear();
-  m_ss.str("");
+  m_buf.clear();
   m_pending_string.clear();
   m_pending_string.str("");
 }
 
+void JSONFormatter::print_indent(size_t levels)
+{
+  static constexpr std::string_view indent = "    ";
+  for (size_t i = 0; i < levels; i++)
+    m_buf += indent;
+}
+
 void JSONFormatter::print_comma(json_formatter_stack_entry_d& entry)
 {
   if (entry.size) {
     if (m_pretty) {
-      m_ss << ",\n";
-      for (unsigned i = 1; i < m_stack.size(); i++)
-        m_ss << "    ";
+      m_buf += ",\n";
+      print_indent(m_stack.size() - 1);
     } else {
-      m_ss << ",";
+      m_buf += ',';
     }
   } else if (m_pretty) {
-    m_ss << "\n";
-    for (unsigned i = 1; i < m_stack.size(); i++)
-      m_ss << "    ";
+    m_buf += '\n';
+    print_indent(m_stack.size() - 1);
   }
   if (m_pretty && entry.is_array)
-    m_ss << "    ";
+    print_indent(1);
 }
 
 void JSONFormatter::print_quoted_string(std::string_view s)
 {
-  m_ss << '\"' << json_stream_escaper(s) << '\"';
+  m_buf += '\"';
+  escape_json_append(s, m_buf);
+  m_buf += '\"';
 }
 
 void JSONFormatter::print_name(std::string_view name)
@@ -206,13 +230,15 @@ void JSONFormatter::print_name(std::string_view name)
   print_comma(entry);
   if (!entry.is_array) {
     if (m_pretty) {
-      m_ss << "    ";
+      print_indent(1);
     }
-    m_ss << "\"" << name << "\"";
+    m_buf += '\"';
+    m_buf += name;
+    m_buf += '\"';
     if (m_pretty)
-      m_ss << ": ";
+      m_buf += ": ";
     else
-      m_ss << ':';
+      m_buf += ':';
   }
   ++entry.size;
 }
@@ -223,16 +249,17 @@ void JSONFormatter::open_section(std::string_view name, const char *ns, bool is_
     return;
   }
   if (ns) {
-    std::ostringstream oss;
-    oss << name << " " << ns;
-    print_name(oss.str().c_str());
+    std::string name_ns(name);
+    name_ns += ' ';
+    name_ns += ns;
+    print_name(name_ns);
   } else {
     print_name(name);
   }
   if (is_array)
-    m_ss << '[';
+    m_buf += '[';
   else
-    m_ss << '{';
+    m_buf += '{';
 
   json_formatter_stack_entry_d n;
   n.is_array = is_array;
@@ -270,14 +297,13 @@ void JSONFormatter::close_section()
 
   struct json_formatter_stack_entry_d& entry = m_stack.back();
   if (m_pretty && entry.size) {
-    m_ss << "\n";
-    for (unsigned i = 1; i < m_stack.size(); i++)
-      m_ss << "    ";
+    m_buf += '\n';
+    print_indent(m_stack.size() - 1);
   }
-  m_ss << (entry.is_array ? ']' : '}');
+  m_buf += (entry.is_array ? ']' : '}');
   m_stack.pop_back();
   if (m_pretty && m_stack.empty())
-    m_ss << "\n";
+    m_buf += '\n';
 }
 
 void JSONFormatter::finish_pending_string()
@@ -292,10 +318,17 @@ void JSONFormatter::finish_pending_string()
 template <class T>
 void JSONFormatter::add_value(std::string_view name, T val)
 {
-  std::stringstream ss;
-  ss.precision(std::numeric_limits<T>::max_digits10);
-  ss << val;
-  add_value(name, ss.str(), false);
+  char buf[64];
+  if constexpr (std::is_integral_v<T>) {
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), val);
+    ceph_assert(ec == std::errc());
+    add_value(name, std::string_view(buf, end - buf), false);
+  } else {
+    // the format of an ostream with this precision
+    int len = snprintf(buf, sizeof(buf), "%.*g",
+                       std::numeric_limits<T>::max_digits10, val);
+    add_value(name, std::string_view(buf, len), false);
+  }
 }
 
 void JSONFormatter::add_value(std::string_view name, std::string_view val, bool quoted)
@@ -305,7 +338,7 @@ void JSONFormatter::add_value(std::string_view name, std::string_view val, bool
   }
   print_name(name);
   if (!quoted) {
-    m_ss << val;
+    m_buf += val;
   } else {
     print_quoted_string(val);
   }
@@ -349,12 +382,12 @@ void JSONFormatter::dump_format_va(std::string_view name, const char *ns, bool q
 
 int JSONFormatter::get_len() const
 {
-  return m_ss.str().size();
+  return m_buf.size();
 }
 
 void JSONFormatter::write_raw_data(const char *data)
 {
-  m_ss << data;
+  m_buf += data;
 }
 
 const char *XMLFormatter::XML_1_DTD =
@@ -13,6 +13,8 @@
  */
 
 #include "PriorityCache.h"
+#include <algorithm>
+#include <limits>
 #include "common/dout.h"
 #include "perfglue/heap_profiler.h"
 #define dout_context cct
@@ -149,13 +151,120 @@ namespace PriorityCache
     logger->set(MallocStats::M_CACHE_BYTES, new_size);
   }
 
+  int Manager::check_group_ratios(const std::string& name,
+                                  const std::string& parent,
+                                  double min_ratio, double max_ratio) const
+  {
+    if (min_ratio < 0 || max_ratio > 1.0 || min_ratio > max_ratio) {
+      return -EINVAL;
+    }
+    // The min shares of the groups under a parent come out of the min share
+    // of the parent.
+    double parent_min = 1.0;
+    if (!parent.empty()) {
+      auto p = groups.find(parent);
+      if (p == groups.end()) {
+        return -ENOENT;
+      }
+      parent_min = p->second.min_ratio;
+    }
+    double siblings_min = min_ratio;
+    double children_min = 0;
+    for (auto& [n, g] : groups) {
+      if (n == name) {
+        continue;
+      }
+      if (g.parent == parent) {
+        siblings_min += g.min_ratio;
+      }
+      if (g.parent == name) {
+        children_min += g.min_ratio;
+      }
+    }
+    // leave some room for floating point imprecision
+    constexpr double epsilon = 1e-9;
+    if (siblings_min > parent_min + epsilon ||
+        children_min > min_ratio + epsilon) {
+      return -EINVAL;
+    }
+    return 0;
+  }
+
+  int Manager::add_group(const std::string& name, double min_ratio,
+                         double max_ratio, const std::string& parent)
+  {
+    ceph_assert(!name.empty());
+    if (groups.count(name) || caches.count(name)) {
+      return -EEXIST;
+    }
+    int r = check_group_ratios(name, parent, min_ratio, max_ratio);
+    if (r < 0) {
+      return r;
+    }
+
+    int start = cur_index++;
+    int end = cur_index + GroupStats::G_LAST + 1;
+    ceph_assert(end < PERF_COUNTER_MAX_BOUND);
+
+    PerfCountersBuilder b(cct, this->name + ":" + name, start, end);
+
+    b.add_u64(cur_index + GroupStats::G_MIN_BYTES, "min_bytes",
+              "bytes set aside for the group", "min",
+              PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+
+    b.add_u64(cur_index + GroupStats::G_MAX_BYTES, "max_bytes",
+              "most bytes the group may be assigned", "max",
+              PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+
+    b.add_u64(cur_index + GroupStats::G_ASSIGNED_BYTES, "assigned_bytes",
+              "bytes assigned to the caches in the group", "a",
+              PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+
+    b.add_u64(cur_index + GroupStats::G_COMMITTED_BYTES, "committed_bytes",
+              "bytes committed by the caches in the group", "c",
+              PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+
+    Group g;
+    g.parent = parent;
+    g.min_ratio = min_ratio;
+    g.max_ratio = max_ratio;
+    g.first_index = cur_index;
+    g.logger = b.create_perf_counters();
+    cct->get_perfcounters_collection()->add(g.logger);
+    groups.emplace(name, std::move(g));
+
+    cur_index = end;
+    return 0;
+  }
+
+  int Manager::set_group_ratios(const std::string& name, double min_ratio,
+                                double max_ratio)
+  {
+    auto it = groups.find(name);
+    if (it == groups.end()) {
+      return -ENOENT;
+    }
+    int r = check_group_ratios(name, it->second.parent, min_ratio, max_ratio);
+    if (r < 0) {
+      return r;
+    }
+    it->second.min_ratio = min_ratio;
+    it->second.max_ratio = max_ratio;
+    return 0;
+  }
+
   void Manager::insert(const std::string& name, std::shared_ptr<PriCache> c,
-                       bool enable_perf_counters)
+                       bool enable_perf_counters, const std::string& group)
   {
     ceph_assert(!caches.count(name));
     ceph_assert(!indexes.count(name));
+    ceph_assert(!groups.count(name));
 
     caches.emplace(name, c);
+    if (!group.empty()) {
+      ceph_assert(groups.count(group));
+      cache_groups.emplace(name, group);
+    }
 
     if (!enable_perf_counters) {
       return;
@@ -250,6 +359,7 @@ namespace PriorityCache
     }
     indexes.erase(name);
     caches.erase(name);
+    cache_groups.erase(name);
   }
 
   void Manager::clear()
@@ -262,6 +372,72 @@ namespace PriorityCache
     }
     indexes.clear();
     caches.clear();
+    cache_groups.clear();
+    for (auto& [name, g] : groups) {
+      cct->get_perfcounters_collection()->remove(g.logger);
+      delete g.logger;
+    }
+    groups.clear();
+  }
+
+  template <typename F>
+  void Manager::for_each_group(const std::string& cache, F&& f)
+  {
+    auto it = cache_groups.find(cache);
+    if (it == cache_groups.end()) {
+      return;
+    }
+    for (auto name = &it->second; !name->empty();) {
+      auto& g = groups.at(*name);
+      f(g);
+      name = &g.parent;
+    }
+  }
+
+  void Manager::reserve_groups(const std::string& parent, int64_t total,
+                               int64_t *mem_avail)
+  {
+    for (auto& [name, g] : groups) {
+      if (g.parent != parent) {
+        continue;
+      }
+      int64_t min_bytes = static_cast<int64_t>(total * g.min_ratio);
+      g.limit = static_cast<int64_t>(total * g.max_ratio);
+      g.reserved = std::min({min_bytes, g.limit, *mem_avail});
+      *mem_avail -= g.reserved;
+      g.logger->set(g.first_index + GroupStats::G_MIN_BYTES, g.reserved);
+      g.logger->set(g.first_index + GroupStats::G_MAX_BYTES, g.limit);
+
+      // The groups under this one take their min share out of its own.
+      reserve_groups(name, total, &g.reserved);
+    }
+  }
+
+  int64_t Manager::get_group_limit(const std::string& cache)
+  {
+    int64_t limit = std::numeric_limits<int64_t>::max();
+    for_each_group(cache, [&limit](Group& g) {
+      limit = std::min(limit, g.limit);
+    });
+    return std::max<int64_t>(limit, 0);
+  }
+
+  int64_t Manager::take_group_reserve(const std::string& cache, int64_t bytes)
+  {
+    int64_t taken = 0;
+    for_each_group(cache, [&](Group& g) {
+      int64_t t = std::min(bytes - taken, g.reserved);
+      g.reserved -= t;
+      taken += t;
+    });
+    return taken;
+  }
+
+  void Manager::charge_groups(const std::string& cache, int64_t bytes)
+  {
+    for_each_group(cache, [bytes](Group& g) {
+      g.limit -= bytes;
+    });
   }
 
   void Manager::balance()
@@ -280,11 +456,21 @@ namespace PriorityCache
       mem_avail = 0;
     }
 
+    // Set aside the min share of the groups.
+    reserve_groups(std::string(), mem_avail, &mem_avail);
+
     // Assign memory for each priority level
     for (int i = 0; i < Priority::LAST+1; i++) {
       ldout(cct, 10) << __func__ << " assigning cache bytes for PRI: " << i << dendl;
 
       auto pri = static_cast<Priority>(i);
+      if (pri == Priority::LAST) {
+        // What the groups did not use of their min share is up for grabs.
+        for (auto& [name, g] : groups) {
+          mem_avail += g.reserved;
+          g.reserved = 0;
+        }
+      }
       balance_priority(&mem_avail, pri);
 
       // Update the per-priority perf counters
@@ -311,6 +497,30 @@ namespace PriorityCache
       l.second->set(indexes[it->first][Extra::E_RESERVED], committed - alloc);
       l.second->set(indexes[it->first][Extra::E_COMMITTED], committed);
     }
+
+    if (groups.empty()) {
+      return;
+    }
+    for (auto& [name, g] : groups) {
+      g.assigned = 0;
+      g.committed = 0;
+    }
+    for (auto& [cache, group] : cache_groups) {
+      auto& c = caches.at(cache);
+      int64_t assigned = c->get_cache_bytes();
+      int64_t committed = c->get_committed_size();
+      for_each_group(cache, [&](Group& g) {
+        g.assigned += assigned;
+        g.committed += committed;
+      });
+    }
+    for (auto& [name, g] : groups) {
+      ldout(cct, 10) << __func__ << " group " << name
+                     << " assigned: " << g.assigned
+                     << " committed: " << g.committed << dendl;
+      g.logger->set(g.first_index + GroupStats::G_ASSIGNED_BYTES, g.assigned);
+      g.logger->set(g.first_index + GroupStats::G_COMMITTED_BYTES, g.committed);
+    }
   }
 
   void Manager::shift_bins()
@@ -334,12 +544,35 @@ namespace PriorityCache
       cur_ratios += it->second->get_cache_ratio();
     }
 
+    // The caches in a group get what they want from the memory set aside
+    // for the group and its parents before sharing the rest.
+    for (auto& [name, group] : cache_groups) {
+      auto& c = caches.at(name);
+      int64_t cache_wants = std::min(c->request_cache_bytes(pri, tuned_mem),
+                                     get_group_limit(name));
+      if (cache_wants <= 0) {
+        continue;
+      }
+      int64_t taken = take_group_reserve(name, cache_wants);
+      if (taken > 0) {
+        ldout(cct, 10) << __func__ << " " << name
+                       << " pri: " << (int) pri
+                       << " wanted: " << cache_wants
+                       << " from group " << group << ": " << taken
+                       << dendl;
+        c->add_cache_bytes(pri, taken);
+        charge_groups(name, taken);
+      }
+    }
+
     // For other priorities, loop until caches are satisified or we run out of
     // memory (stop if we can't guarantee a full byte allocation).
     while (!tmp_caches.empty() && *mem_avail > static_cast<int64_t>(tmp_caches.size())) {
       uint64_t total_assigned = 0;
       for (auto it = tmp_caches.begin(); it != tmp_caches.end();) {
         int64_t cache_wants = it->second->request_cache_bytes(pri, tuned_mem);
+        // Never exceed the max share of the groups of the cache.
+        cache_wants = std::min(cache_wants, get_group_limit(it->first));
         // Usually the ratio should be set to the fraction of the current caches'
         // assigned ratio compared to the total ratio of all caches that still
         // want memory.  There is a special case where the only caches left are
@@ -364,6 +597,7 @@ namespace PriorityCache
         if (cache_wants > fair_share) {
           // If we want too much, take what we can get but stick around for more
           it->second->add_cache_bytes(pri, fair_share);
+          charge_groups(it->first, fair_share);
           total_assigned += fair_share;
           new_ratios += it->second->get_cache_ratio();
           ++it;
@@ -371,6 +605,7 @@ namespace PriorityCache
           // Otherwise assign only what we want
           if (cache_wants > 0) {
             it->second->add_cache_bytes(pri, cache_wants);
+            charge_groups(it->first, cache_wants);
             total_assigned += cache_wants;
           }
           // Either the cache didn't want anything or got what it wanted, so
@@ -392,6 +627,12 @@ namespace PriorityCache
       for (auto it = caches.begin(); it != caches.end(); it++) {
         double ratio = it->second->get_cache_ratio();
         int64_t fair_share = static_cast<int64_t>(*mem_avail * ratio);
+        int64_t cur = it->second->get_cache_bytes(Priority::LAST);
+        int64_t limit = get_group_limit(it->first);
+        if (fair_share - cur > limit) {
+          fair_share = cur + limit;
+        }
+        charge_groups(it->first, fair_share - cur);
         it->second->set_cache_bytes(Priority::LAST, fair_share);
         total_assigned += fair_share;
       }
@@ -16,6 +16,7 @@
 #define CEPH_PRIORITY_CACHE_H
 
 #include <stdint.h>
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -60,6 +61,14 @@ namespace PriorityCache {
     E_LAST = E_COMMITTED,
   };
 
+  enum GroupStats {
+    G_MIN_BYTES,
+    G_MAX_BYTES,
+    G_ASSIGNED_BYTES,
+    G_COMMITTED_BYTES,
+    G_LAST = G_COMMITTED_BYTES,
+  };
+
   int64_t get_chunk(uint64_t usage, uint64_t total_bytes);
 
   struct PriCache {
@@ -115,11 +124,33 @@ namespace PriorityCache {
   };
 
   class Manager {
+    /* A group of caches, or of other groups, whose share of the memory
+     * available for caches is kept between min_ratio and max_ratio.  The
+     * min share is set aside for the group before the other caches are
+     * assigned anything; it is only given away at the last priority if the
+     * caches in the group did not ask for it. */
+    struct Group {
+      std::string parent;
+      double min_ratio = 0;
+      double max_ratio = 1.0;
+      PerfCounters* logger = nullptr;
+      int first_index = 0;
+
+      // Bytes still set aside for the group, and bytes its caches may still
+      // be assigned, while balancing.
+      int64_t reserved = 0;
+      int64_t limit = 0;
+      int64_t assigned = 0;
+      int64_t committed = 0;
+    };
+
     CephContext* cct = nullptr;
     PerfCounters* logger;
     std::unordered_map<std::string, PerfCounters*> loggers;
     std::unordered_map<std::string, std::vector<int>> indexes;
     std::unordered_map<std::string, std::shared_ptr<PriCache>> caches;
+    std::map<std::string, Group> groups;
+    std::unordered_map<std::string, std::string> cache_groups;
 
     // Start perf counter slots after the malloc stats.
     int cur_index = MallocStats::M_LAST;
@@ -146,8 +177,17 @@ namespace PriorityCache {
     uint64_t get_tuned_mem() const {
       return tuned_mem;
     }
+    /* Add a group of caches.  The ratios are fractions of the memory
+     * available for caches, the min ratios of the groups under the same
+     * parent must not add up to more than the min ratio of the parent (or
+     * to more than 1 for the top level groups). */
+    int add_group(const std::string& name, double min_ratio, double max_ratio,
+                  const std::string& parent = std::string());
+    int set_group_ratios(const std::string& name, double min_ratio,
+                         double max_ratio);
     void insert(const std::string& name, const std::shared_ptr<PriCache> c,
-                bool enable_perf_counters);
+                bool enable_perf_counters,
+                const std::string& group = std::string());
     void erase(const std::string& name);
     void clear();
     void tune_memory();
@@ -155,6 +195,15 @@ namespace PriorityCache {
     void shift_bins();
   private:
     void balance_priority(int64_t *mem_avail, Priority pri);
+    int check_group_ratios(const std::string& name, const std::string& parent,
+                           double min_ratio, double max_ratio) const;
+    void reserve_groups(const std::string& parent, int64_t total,
+                        int64_t *mem_avail);
+    int64_t get_group_limit(const std::string& cache);
+    int64_t take_group_reserve(const std::string& cache, int64_t bytes);
+    void charge_groups(const std::string& cache, int64_t bytes);
+    template <typename F>
+    void for_each_group(const std::string& cache, F&& f);
   };
 }
 
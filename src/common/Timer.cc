@@ -83,16 +83,10 @@ void CommonSafeTimer<Mutex>::timer_thread()
   while (!stopping) {
     auto now = clock_t::now();
 
-    while (!schedule.empty()) {
-      auto p = schedule.begin();
-
-      // is the future now?
-      if (p->first > now)
-	break;
-
-      Context *callback = p->second;
+    while (auto e = wheel.next_due(now)) {
+      Context *callback = e->callback;
+      wheel.unschedule(*e);
       events.erase(callback);
-      schedule.erase(p);
       ldout(cct,10) << "timer_thread executing " << callback << dendl;
       
       if (!safe_callbacks) {
@@ -109,12 +103,13 @@ void CommonSafeTimer<Mutex>::timer_thread()
       break;
 
     ldout(cct,20) << "timer_thread going to sleep" << dendl;
-    if (schedule.empty()) {
+    next_wake = wheel.next_event();
+    if (next_wake == clock_t::time_point::max()) {
       cond.wait(l);
     } else {
-      auto when = schedule.begin()->first;
-      cond.wait_until(l, when);
+      cond.wait_until(l, next_wake);
     }
+    next_wake = clock_t::time_point::min();
     ldout(cct,20) << "timer_thread awake" << dendl;
   }
   ldout(cct,10) << "timer_thread exiting" << dendl;
@@ -145,18 +140,15 @@ Context* CommonSafeTimer<Mutex>::add_event_at(CommonSafeTimer<Mutex>::clock_t::t
     delete callback;
     return nullptr;
   }
-  scheduled_map_t::value_type s_val(when, callback);
-  scheduled_map_t::iterator i = schedule.insert(s_val);
-
-  event_lookup_map_t::value_type e_val(callback, i);
-  pair < event_lookup_map_t::iterator, bool > rval(events.insert(e_val));
+  auto [p, inserted] = events.try_emplace(callback, callback, when);
 
   /* If you hit this, you tried to insert the same Context* twice. */
-  ceph_assert(rval.second);
+  ceph_assert(inserted);
+  wheel.schedule(p->second, clock_t::now());
 
   /* If the event we have just inserted comes before everything else, we need to
    * adjust our timeout. */
-  if (i == schedule.begin())
+  if (when < next_wake)
     cond.notify_all();
   return callback;
 }
@@ -185,10 +177,10 @@ bool CommonSafeTimer<Mutex>::cancel_event(Context *callback)
     return false;
   }
 
-  ldout(cct,10) << "cancel_event " << p->second->first << " -> " << callback << dendl;
+  ldout(cct,10) << "cancel_event " << p->second.when << " -> " << callback << dendl;
   delete p->first;
 
-  schedule.erase(p->second);
+  wheel.unschedule(p->second);
   events.erase(p);
   return true;
 }
@@ -201,9 +193,9 @@ void CommonSafeTimer<Mutex>::cancel_all_events()
 
   while (!events.empty()) {
     auto p = events.begin();
-    ldout(cct,10) << " cancelled " << p->second->first << " -> " << p->first << dendl;
+    ldout(cct,10) << " cancelled " << p->second.when << " -> " << p->first << dendl;
     delete p->first;
-    schedule.erase(p->second);
+    wheel.unschedule(p->second);
     events.erase(p);
   }
 }
@@ -215,10 +207,12 @@ void CommonSafeTimer<Mutex>::dump(const char *caller) const
     caller = "";
   ldout(cct,10) << "dump " << caller << dendl;
 
-  for (scheduled_map_t::const_iterator s = schedule.begin();
-       s != schedule.end();
-       ++s)
-    ldout(cct,10) << " " << s->first << "->" << s->second << dendl;
+  std::multimap<clock_t::time_point, Context*> schedule;
+  for (auto& [callback, e] : events) {
+    schedule.emplace(e.when, callback);
+  }
+  for (auto& [when, callback] : schedule)
+    ldout(cct,10) << " " << when << "->" << callback << dendl;
 }
 
 template class CommonSafeTimer<ceph::mutex>;
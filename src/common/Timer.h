@@ -15,9 +15,10 @@
 #ifndef CEPH_TIMER_H
 #define CEPH_TIMER_H
 
-#include <map>
+#include <unordered_map>
 #include "include/common_fwd.h"
 #include "ceph_time.h"
+#include "TimerWheel.h"
 #include "ceph_mutex.h"
 #include "fair_mutex.h"
 #include <condition_variable>
@@ -41,10 +42,11 @@ class CommonSafeTimer
   void _shutdown();
 
   using clock_t = ceph::mono_clock;
-  using scheduled_map_t = std::multimap<clock_t::time_point, Context*>;
-  scheduled_map_t schedule;
-  using event_lookup_map_t = std::map<Context*, scheduled_map_t::iterator>;
-  event_lookup_map_t events;
+
+  TimerWheel wheel;
+  std::unordered_map<Context*, TimerWheel::event_t> events;
+  /// when the timer thread will wake up, if it is sleeping
+  clock_t::time_point next_wake = clock_t::time_point::min();
   bool stopping;
 
   void dump(const char *caller = 0) const;
@@ -0,0 +1,145 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "include/ceph_assert.h"
+#include "TimerWheel.h"
+
+uint64_t TimerWheel::_next_used_slot() const
+{
+  // scan the bitmap from the cursor, wrapping around once
+  const uint64_t words = num_slots / 64;
+  uint64_t start = cursor % num_slots;
+  for (uint64_t n = 0; n <= words; n++) {
+    uint64_t w = (start / 64 + n) % words;
+    uint64_t bits = wheel_used[w];
+    if (n == 0) {
+      bits &= ~0ull << (start % 64);
+    } else if (n == words) {
+      bits &= ~(~0ull << (start % 64));
+    }
+    if (bits) {
+      uint64_t slot = w * 64 + __builtin_ctzll(bits);
+      return (slot + num_slots - start) % num_slots;
+    }
+  }
+  ceph_abort_msg("no event in the wheel");
+}
+
+void TimerWheel::schedule(event_t& e, clock_t::time_point now)
+{
+  if (wheel.empty()) {
+    wheel.resize(num_slots);
+    wheel_used.resize(num_slots / 64);
+  }
+  if (empty()) {
+    // the cursor may lag if the timer thread slept for long
+    cursor = std::max(cursor, tick_of(now));
+  }
+  e.seq = next_seq++;
+  _insert(e);
+}
+
+void TimerWheel::_insert(event_t& e)
+{
+  uint64_t t = std::max(tick_of(e.when), cursor);
+  if (t >= cursor + num_slots) {
+    e.overflow = true;
+    e.overflow_pos = overflow.emplace(e.when, &e);
+    return;
+  }
+  e.overflow = false;
+  e.slot = t % num_slots;
+  slot_t& slot = wheel[e.slot];
+  if (t == sorted_tick) {
+    // the later events usually go last
+    auto p = slot.end();
+    while (p != slot.begin() && before(e, *std::prev(p))) {
+      --p;
+    }
+    slot.insert(p, e);
+  } else {
+    slot.push_back(e);
+  }
+  wheel_used[e.slot / 64] |= 1ull << (e.slot % 64);
+  ++wheel_events;
+}
+
+void TimerWheel::unschedule(event_t& e)
+{
+  if (e.overflow) {
+    overflow.erase(e.overflow_pos);
+    return;
+  }
+  slot_t& slot = wheel[e.slot];
+  slot.erase(slot.iterator_to(e));
+  if (slot.empty()) {
+    wheel_used[e.slot / 64] &= ~(1ull << (e.slot % 64));
+  }
+  --wheel_events;
+}
+
+void TimerWheel::_sort(uint64_t t)
+{
+  if (t != sorted_tick) {
+    wheel[t % num_slots].sort(before);
+    sorted_tick = t;
+  }
+}
+
+void TimerWheel::_advance(clock_t::time_point now)
+{
+  uint64_t now_tick = tick_of(now);
+  if (wheel.empty() || cursor >= now_tick) {
+    return;
+  }
+  if (wheel_events) {
+    cursor = std::min(cursor + _next_used_slot(), now_tick);
+  } else {
+    cursor = now_tick;
+  }
+  // pull in the events the wheel now covers
+  while (!overflow.empty() &&
+	 tick_of(overflow.begin()->first) < cursor + num_slots) {
+    event_t *e = overflow.begin()->second;
+    overflow.erase(overflow.begin());
+    _insert(*e);
+  }
+}
+
+TimerWheel::event_t* TimerWheel::next_due(clock_t::time_point now)
+{
+  _advance(now);
+  if (!wheel_events) {
+    return nullptr;
+  }
+  // the events due by now are all in the slot of the cursor
+  _sort(cursor);
+  slot_t& slot = wheel[cursor % num_slots];
+  if (!slot.empty() && slot.front().when <= now) {
+    return &slot.front();
+  }
+  return nullptr;
+}
+
+TimerWheel::clock_t::time_point TimerWheel::next_event()
+{
+  if (wheel_events) {
+    // the events of the wheel all precede those of the overflow
+    uint64_t t = cursor + _next_used_slot();
+    _sort(t);
+    return wheel[t % num_slots].front().when;
+  }
+  if (!overflow.empty()) {
+    return overflow.begin()->first;
+  }
+  return clock_t::time_point::max();
+}
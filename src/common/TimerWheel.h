@@ -0,0 +1,101 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_TIMERWHEEL_H
+#define CEPH_TIMERWHEEL_H
+
+#include <map>
+#include <vector>
+#include <boost/intrusive/list.hpp>
+#include "ceph_time.h"
+
+class Context;
+
+/* The schedule of a SafeTimer.
+ *
+ * The events are hashed by their tick into a wheel spanning
+ * num_slots * tick, so that scheduling and cancelling them is O(1).  The
+ * events further in the future wait in the overflow map until the wheel
+ * gets close to them.  A slot is sorted by (when, seq) once, when it
+ * becomes the next one to fire, and kept in order after that, so the
+ * events still fire at their exact time, in order.
+ *
+ * The wheel does not read the clock; the callers pass it the time, and
+ * serialize the calls. */
+class TimerWheel {
+public:
+  using clock_t = ceph::mono_clock;
+  static constexpr clock_t::duration tick = std::chrono::milliseconds(16);
+  static constexpr uint64_t num_slots = 4096;
+
+  struct event_t;
+  using overflow_map_t = std::multimap<clock_t::time_point, event_t*>;
+  struct event_t : public boost::intrusive::list_base_hook<> {
+    Context *callback;
+    clock_t::time_point when;
+    uint64_t seq = 0;   ///< orders the events due at the same time
+    uint64_t slot = 0;
+    bool overflow = false;
+    overflow_map_t::iterator overflow_pos;
+    event_t(Context *c, clock_t::time_point w)
+      : callback(c), when(w) {}
+  };
+
+  TimerWheel() = default;
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  static uint64_t tick_of(clock_t::time_point t) {
+    return t.time_since_epoch() / tick;
+  }
+
+  /// add @p e, which must outlive its schedule
+  void schedule(event_t& e, clock_t::time_point now);
+  void unschedule(event_t& e);
+  /// the first event due by now, if any
+  event_t* next_due(clock_t::time_point now);
+  /// the time of the first event, or time_point::max() if there is none
+  clock_t::time_point next_event();
+
+  bool empty() const {
+    return !wheel_events && overflow.empty();
+  }
+  uint64_t get_cursor() const {
+    return cursor;
+  }
+
+private:
+  using slot_t = boost::intrusive::list<
+    event_t, boost::intrusive::constant_time_size<false>>;
+
+  std::vector<slot_t> wheel;          ///< allocated on first use
+  std::vector<uint64_t> wheel_used;   ///< bitmap of the non-empty slots
+  uint64_t wheel_events = 0;
+  uint64_t cursor = 0;                ///< the tick of the current slot
+  /// the tick of the slot kept in order, if any
+  uint64_t sorted_tick = UINT64_MAX;
+  uint64_t next_seq = 0;
+  overflow_map_t overflow;
+
+  static bool before(const event_t& a, const event_t& b) {
+    return a.when < b.when || (a.when == b.when && a.seq < b.seq);
+  }
+  void _insert(event_t& e);
+  /// sort the slot of @p t, unless it is already in order
+  void _sort(uint64_t t);
+  /// move the cursor up to now, skipping the empty slots
+  void _advance(clock_t::time_point now);
+  /// the distance from the cursor to the first non-empty slot
+  uint64_t _next_used_slot() const;
+};
+
+#endif
@@ -12,8 +12,11 @@
  * 
  */
 
+#include <boost/lockfree/queue.hpp>
+
 #include "WorkQueue.h"
 #include "include/compat.h"
+#include "include/mempool.h"
 #include "common/errno.h"
 
 #define dout_subsys ceph_subsys_tp
@@ -133,6 +136,7 @@ void ThreadPool::worker(WorkThread *wt)
     }
 
     ldout(cct,20) << "worker waiting" << dendl;
+    mempool::flush_thread_cache();
     cct->get_heartbeat_map()->reset_timeout(
       hb,
       ceph::make_timespan(cct->_conf->threadpool_default_timeout),
@@ -411,3 +415,212 @@ void ShardedThreadPool::drain()
   ldout(cct,10) << "drained" << dendl;
 }
 
+
+struct WorkStealingThreadPool::Shard {
+  struct item_t {
+    WorkQueue_ *wq;
+    void *item;
+  };
+  boost::lockfree::queue<item_t> q{128};
+
+  struct WorkThread : public Thread {
+    WorkStealingThreadPool *pool;
+    unsigned index;
+    WorkThread(WorkStealingThreadPool *p, unsigned i) : pool(p), index(i) {}
+    void *entry() override {
+      pool->worker(index);
+      return 0;
+    }
+  } thread;
+
+  Shard(WorkStealingThreadPool *p, unsigned i) : thread(p, i) {}
+};
+
+// the pool and the shard of the worker running on this thread, if any
+static thread_local WorkStealingThreadPool *current_pool = nullptr;
+static thread_local unsigned current_shard = 0;
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+  CephContext *cct_, std::string nm, std::string tn, unsigned num_threads)
+  : cct(cct_),
+    name(std::move(nm)),
+    thread_name(std::move(tn)),
+    lockname(name + "::lock"),
+    lock(ceph::make_mutex(lockname))
+{
+  ceph_assert(num_threads > 0);
+  for (unsigned i = 0; i < num_threads; i++) {
+    shards.emplace_back(std::make_unique<Shard>(this, i));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  ceph_assert(pending == 0);
+}
+
+void WorkStealingThreadPool::queue(WorkQueue_ *wq, void *item)
+{
+  ++wq->pending;
+  ++pending;
+  unsigned i = current_pool == this ?
+    current_shard : next_shard++ % shards.size();
+  shards[i]->q.push({wq, item});
+  // pairs with ++idle in worker(): either the worker sees the item or we
+  // see the worker going to sleep
+  ++queued;
+  if (idle > 0) {
+    std::lock_guard l(lock);
+    cond.notify_one();
+  }
+}
+
+bool WorkStealingThreadPool::_try_dequeue(unsigned index,
+					  WorkQueue_ **wq, void **item)
+{
+  // our own queue first, then steal from the others
+  Shard::item_t i;
+  for (unsigned n = 0; n < shards.size(); n++) {
+    if (shards[(index + n) % shards.size()]->q.pop(i)) {
+      --queued;
+      *wq = i.wq;
+      *item = i.item;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::_wake_waiters()
+{
+  if (waiters > 0) {
+    std::lock_guard l(lock);
+    wait_cond.notify_all();
+  }
+}
+
+void WorkStealingThreadPool::worker(unsigned index)
+{
+  ldout(cct,10) << "worker " << index << " start" << dendl;
+  current_pool = this;
+  current_shard = index;
+
+  std::stringstream ss;
+  ss << name << " thread " << (void *)pthread_self();
+  auto hb = cct->get_heartbeat_map()->add_worker(ss.str(), pthread_self());
+
+  while (!stop_threads) {
+    // pairs with ++paused in pause(): either we see the pause or it waits
+    // for this item
+    ++processing;
+    WorkQueue_ *wq;
+    void *item;
+    if (!paused && _try_dequeue(index, &wq, &item)) {
+      ldout(cct,12) << "worker wq " << wq->name << " start processing "
+		    << item << dendl;
+      TPHandle tp_handle(cct, hb, wq->timeout_interval, wq->suicide_interval);
+      tp_handle.reset_tp_timeout();
+      wq->_void_process(item, tp_handle);
+      // once pending drops, drain() may return and wq may be gone
+      ldout(cct,15) << "worker wq " << wq->name << " done processing "
+		    << item << dendl;
+      --wq->pending;
+      --pending;
+      --processing;
+      _wake_waiters();
+      continue;
+    }
+    --processing;
+    _wake_waiters();
+
+    std::unique_lock ul(lock);
+    ++idle;
+    if (!stop_threads && (paused || queued == 0)) {
+      ldout(cct,20) << "worker waiting" << dendl;
+      mempool::flush_thread_cache();
+      cct->get_heartbeat_map()->reset_timeout(
+	hb,
+	ceph::make_timespan(cct->_conf->threadpool_default_timeout),
+	ceph::make_timespan(0));
+      cond.wait_for(ul, std::chrono::seconds(
+	cct->_conf->threadpool_empty_queue_max_wait));
+    }
+    --idle;
+  }
+  ldout(cct,1) << "worker finish" << dendl;
+
+  cct->get_heartbeat_map()->remove_worker(hb);
+  current_pool = nullptr;
+}
+
+void WorkStealingThreadPool::start()
+{
+  ldout(cct,10) << "start" << dendl;
+  for (auto& s : shards) {
+    s->thread.create(thread_name.c_str());
+  }
+  ldout(cct,15) << "started" << dendl;
+}
+
+void WorkStealingThreadPool::stop()
+{
+  ldout(cct,10) << "stop" << dendl;
+  stop_threads = true;
+  {
+    std::lock_guard l(lock);
+    cond.notify_all();
+  }
+  for (auto& s : shards) {
+    s->thread.join();
+  }
+  WorkQueue_ *wq;
+  void *item;
+  while (_try_dequeue(0, &wq, &item)) {
+    wq->_void_discard(item);
+    --wq->pending;
+    --pending;
+  }
+  stop_threads = false;
+  ldout(cct,15) << "stopped" << dendl;
+}
+
+void WorkStealingThreadPool::pause()
+{
+  ldout(cct,10) << "pause" << dendl;
+  ++paused;
+  ++waiters;
+  {
+    std::unique_lock ul(lock);
+    wait_cond.wait(ul, [this] { return processing == 0; });
+  }
+  --waiters;
+  ldout(cct,15) << "paused" << dendl;
+}
+
+void WorkStealingThreadPool::pause_new()
+{
+  ldout(cct,10) << "pause_new" << dendl;
+  ++paused;
+}
+
+void WorkStealingThreadPool::unpause()
+{
+  ldout(cct,10) << "unpause" << dendl;
+  std::lock_guard l(lock);
+  ceph_assert(paused > 0);
+  --paused;
+  cond.notify_all();
+}
+
+void WorkStealingThreadPool::drain(WorkQueue_* wq)
+{
+  ldout(cct,10) << "drain" << dendl;
+  ++waiters;
+  {
+    std::unique_lock ul(lock);
+    wait_cond.wait(ul, [this, wq] {
+      return (wq ? wq->pending.load() : pending.load()) == 0;
+    });
+  }
+  --waiters;
+}
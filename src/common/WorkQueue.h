@@ -26,6 +26,7 @@ struct ThreadPool {
 
 #include <atomic>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -675,6 +676,132 @@ public:
 
 };
 
+/** @brief Pool of threads without a pool-wide lock.
+ * Each worker owns a lock-free queue.  Producers push to the queue of the
+ * worker they run on, or to the next one round-robin, and a worker whose own
+ * queue is empty steals from the others.  The pool lock is only taken to put
+ * an idle worker to sleep and to wake it up, so queueing does not contend
+ * with the workers.  Items of a queue may be processed in parallel and out
+ * of order, and the number of threads is fixed. */
+class WorkStealingThreadPool {
+public:
+  using TPHandle = ThreadPool::TPHandle;
+
+  /// Basic interface to a work queue used by the worker threads.
+  struct WorkQueue_ {
+    std::string name;
+    ceph::timespan timeout_interval;
+    ceph::timespan suicide_interval;
+    /// items queued or being processed
+    std::atomic<uint64_t> pending = {0};
+    WorkQueue_(std::string n, ceph::timespan ti, ceph::timespan sti)
+      : name(std::move(n)), timeout_interval(ti), suicide_interval(sti)
+    { }
+    virtual ~WorkQueue_() {}
+    /// Process the work item, in parallel with the other items.
+    virtual void _void_process(void *item, TPHandle &handle) = 0;
+    /// Drop a work item which was not processed before stop().
+    virtual void _void_discard(void *item) {}
+    void set_timeout(time_t ti){
+      timeout_interval = ceph::make_timespan(ti);
+    }
+    void set_suicide_timeout(time_t sti){
+      suicide_interval = ceph::make_timespan(sti);
+    }
+  };
+
+  /** @brief Template by-pointer work queue.
+   * The counterpart of ThreadPool::WorkQueue: the items are held by the
+   * pool, so there is no _enqueue() or _dequeue() to implement. */
+  template<class T>
+  class WorkQueue : public WorkQueue_ {
+    WorkStealingThreadPool *pool;
+
+    void _void_process(void *p, TPHandle &handle) override {
+      _process(static_cast<T *>(p), handle);
+    }
+    void _void_discard(void *p) override {
+      _discard(static_cast<T *>(p));
+    }
+
+  protected:
+    /// Process a work item. Called from the worker threads.
+    virtual void _process(T *t, TPHandle &) = 0;
+    virtual void _discard(T *) {}
+
+  public:
+    WorkQueue(std::string n,
+	      ceph::timespan ti, ceph::timespan sti,
+	      WorkStealingThreadPool* p)
+      : WorkQueue_(std::move(n), ti, sti), pool(p) {}
+    ~WorkQueue() override {
+      ceph_assert(pending == 0);
+    }
+
+    void queue(T *item) {
+      pool->queue(this, item);
+    }
+    bool empty() const {
+      return pending == 0;
+    }
+    void drain() {
+      pool->drain(this);
+    }
+  };
+
+private:
+  CephContext *cct;
+  std::string name;
+  std::string thread_name;
+  std::string lockname;
+  ceph::mutex lock;
+  ceph::condition_variable cond;       ///< idle workers sleep here
+  ceph::condition_variable wait_cond;  ///< pause() and drain() wait here
+
+  struct Shard;
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  std::atomic<bool> stop_threads = { false };
+  std::atomic<int> paused = { 0 };
+  std::atomic<unsigned> idle = { 0 };        ///< workers about to sleep
+  std::atomic<unsigned> waiters = { 0 };     ///< in pause() or drain()
+  std::atomic<int> processing = { 0 };
+  std::atomic<uint64_t> queued = { 0 };      ///< items in the shards
+  std::atomic<uint64_t> pending = { 0 };     ///< queued or processing
+  std::atomic<unsigned> next_shard = { 0 };
+
+  void worker(unsigned index);
+  bool _try_dequeue(unsigned index, WorkQueue_ **wq, void **item);
+  void _wake_waiters();
+
+public:
+  WorkStealingThreadPool(CephContext *cct_, std::string nm, std::string tn,
+			 unsigned num_threads);
+  ~WorkStealingThreadPool();
+
+  unsigned get_num_threads() const {
+    return shards.size();
+  }
+
+  /// queue an item of the given work queue
+  void queue(WorkQueue_ *wq, void *item);
+
+  /// start thread pool thread
+  void start();
+  /// stop thread pool thread, discarding the queued items
+  void stop();
+  /// pause thread pool (if it not already paused)
+  void pause();
+  /// pause initiation of new work
+  void pause_new();
+  /// resume work in thread pool.  must match each pause() call 1:1 to resume.
+  void unpause();
+  /** @brief Wait until work completes.
+   * If the parameter is NULL, blocks until all the queued items are
+   * processed; otherwise until those of the given work queue are. */
+  void drain(WorkQueue_* wq = 0);
+};
+
 #endif
 
 #endif
@@ -18,6 +18,13 @@
 #include <limits.h>
 
 #include <sys/uio.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
 
 #include "include/ceph_assert.h"
 #include "include/types.h"
@@ -189,6 +196,258 @@ static ceph::spinlock debug_lock;
   };
 #endif
 
+#if defined(__linux__)
+  /*
+   * NUMA node pools.
+   *
+   * The pool of each node hands out buffers whose size is a power of two,
+   * from 4 KiB to 1 MiB, carved from 2 MiB regions bound to the node. The
+   * buffers are aligned on their size. A freed buffer goes back to the free
+   * list of its size, in the pool it came from.
+   */
+  namespace {
+    constexpr unsigned NUMA_POOL_MIN_SHIFT = 12;
+    constexpr unsigned NUMA_POOL_MAX_SHIFT = 20;
+    constexpr unsigned NUMA_POOL_NUM_SIZES =
+      NUMA_POOL_MAX_SHIFT - NUMA_POOL_MIN_SHIFT + 1;
+    constexpr size_t NUMA_POOL_REGION_SIZE = 2 << 20;
+    constexpr int NUMA_POOL_MAX_NODES = 64;
+
+    struct numa_pool_t {
+      int node = -1;
+      uint64_t max_bytes = 0;
+      bool huge_pages = false;
+
+      struct free_list_t {
+	ceph::spinlock lock;
+	std::vector<char*> bufs;
+      } free_lists[NUMA_POOL_NUM_SIZES];
+
+      std::mutex map_lock;
+      uint64_t mapped = 0;  // protected by map_lock
+
+      std::atomic<uint64_t> allocs = {0};
+      std::atomic<uint64_t> alloc_bytes = {0};
+      std::atomic<uint64_t> fallbacks = {0};
+      std::atomic<uint64_t> in_use_bytes = {0};
+      std::atomic<uint64_t> mapped_bytes = {0};
+      std::atomic<uint64_t> huge_page_bytes = {0};
+
+      char *get(unsigned size_index);
+      void put(char *buf, unsigned size_index);
+
+    private:
+      bool map_region(unsigned size_index);
+    };
+
+    // never freed: buffers may be released by the destructors of other
+    // static objects, after this translation unit's are gone
+    const std::vector<int> *numa_cpu_nodes = nullptr;
+    numa_pool_t *numa_pools = nullptr;
+    std::atomic<int> num_numa_pools = {0};
+
+    char *numa_pool_t::get(unsigned size_index)
+    {
+      auto& fl = free_lists[size_index];
+      while (true) {
+	{
+	  std::lock_guard l(fl.lock);
+	  if (!fl.bufs.empty()) {
+	    char *buf = fl.bufs.back();
+	    fl.bufs.pop_back();
+	    return buf;
+	  }
+	}
+	if (!map_region(size_index)) {
+	  return nullptr;
+	}
+      }
+    }
+
+    void numa_pool_t::put(char *buf, unsigned size_index)
+    {
+      in_use_bytes -= 1ull << (size_index + NUMA_POOL_MIN_SHIFT);
+      auto& fl = free_lists[size_index];
+      std::lock_guard l(fl.lock);
+      fl.bufs.push_back(buf);
+    }
+
+    bool numa_pool_t::map_region(unsigned size_index)
+    {
+      std::lock_guard l(map_lock);
+      if (mapped + NUMA_POOL_REGION_SIZE > max_bytes) {
+	return false;
+      }
+      char *region = nullptr;
+      bool huge = false;
+      if (huge_pages) {
+	void *p = ::mmap(nullptr, NUMA_POOL_REGION_SIZE, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (p != MAP_FAILED) {
+	  region = static_cast<char*>(p);
+	  huge = true;
+	}
+      }
+      if (!region) {
+	// map twice the size to trim it down to an aligned region, so that
+	// it can be backed by a transparent huge page
+	size_t len = 2 * NUMA_POOL_REGION_SIZE;
+	void *p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+	  return false;
+	}
+	char *start = static_cast<char*>(p);
+	region = reinterpret_cast<char*>(
+	  p2roundup(reinterpret_cast<uintptr_t>(start),
+		    static_cast<uintptr_t>(NUMA_POOL_REGION_SIZE)));
+	if (region > start) {
+	  ::munmap(start, region - start);
+	}
+	char *end = region + NUMA_POOL_REGION_SIZE;
+	if (start + len > end) {
+	  ::munmap(end, start + len - end);
+	}
+	::madvise(region, NUMA_POOL_REGION_SIZE, MADV_HUGEPAGE);
+      }
+      // the pages are not touched yet, they will be allocated on the node
+      // when they are. if it is out of memory, they come from another one.
+      unsigned long nodemask = 1ul << node;
+      ::syscall(SYS_mbind, region, NUMA_POOL_REGION_SIZE, MPOL_PREFERRED,
+		&nodemask, NUMA_POOL_MAX_NODES + 1, 0);
+
+      mapped += NUMA_POOL_REGION_SIZE;
+      mapped_bytes += NUMA_POOL_REGION_SIZE;
+      if (huge) {
+	huge_page_bytes += NUMA_POOL_REGION_SIZE;
+      }
+      size_t size = 1ull << (size_index + NUMA_POOL_MIN_SHIFT);
+      auto& fl = free_lists[size_index];
+      std::lock_guard fll(fl.lock);
+      for (size_t off = 0; off < NUMA_POOL_REGION_SIZE; off += size) {
+	fl.bufs.push_back(region + off);
+      }
+      return true;
+    }
+  }
+
+  class buffer::raw_numa_pooled : public buffer::raw {
+    numa_pool_t *pool;
+    unsigned size_index;
+  public:
+    MEMPOOL_CLASS_HELPERS();
+
+    raw_numa_pooled(char *buf, unsigned l, int mempool,
+		    numa_pool_t *p, unsigned i)
+      : raw(buf, l, mempool), pool(p), size_index(i) {
+      bdout << "raw_numa_pooled " << this << " alloc " << (void *)data
+	    << " l=" << l << " node=" << pool->node << bendl;
+    }
+    ~raw_numa_pooled() override {
+      pool->put(data, size_index);
+      bdout << "raw_numa_pooled " << this << " free " << (void *)data << bendl;
+    }
+    raw* clone_empty() override;
+
+    // a buffer from the pool of the node of the current cpu, or nullptr
+    static raw_numa_pooled* create(unsigned len, unsigned align, int mempool) {
+      int num_pools = num_numa_pools.load(std::memory_order_acquire);
+      if (num_pools == 0) {
+	return nullptr;
+      }
+      unsigned shift = std::max(NUMA_POOL_MIN_SHIFT,
+				cbits(std::max(len, align) - 1));
+      if (shift > NUMA_POOL_MAX_SHIFT) {
+	return nullptr;
+      }
+      int cpu = sched_getcpu();
+      if (cpu < 0 || cpu >= (int)numa_cpu_nodes->size()) {
+	return nullptr;
+      }
+      int node = (*numa_cpu_nodes)[cpu];
+      if (node < 0 || node >= num_pools) {
+	return nullptr;
+      }
+      auto& pool = numa_pools[node];
+      unsigned size_index = shift - NUMA_POOL_MIN_SHIFT;
+      char *buf = pool.get(size_index);
+      if (!buf) {
+	++pool.fallbacks;
+	return nullptr;
+      }
+      ++pool.allocs;
+      pool.alloc_bytes += len;
+      pool.in_use_bytes += 1ull << shift;
+      return new raw_numa_pooled(buf, len, mempool, &pool, size_index);
+    }
+  };
+
+  buffer::raw* buffer::raw_numa_pooled::clone_empty() {
+    if (auto r = create(len, CEPH_PAGE_SIZE, mempool); r) {
+      return r;
+    }
+    return new raw_posix_aligned(len, CEPH_PAGE_SIZE);
+  }
+
+  int buffer::enable_numa_pools(const std::vector<int>& cpu_nodes,
+				uint64_t max_bytes, bool huge_pages) {
+    if (num_numa_pools.load() > 0) {
+      return -EEXIST;
+    }
+    int num_pools = 0;
+    for (auto node : cpu_nodes) {
+      if (node >= NUMA_POOL_MAX_NODES) {
+	return -ERANGE;
+      }
+      num_pools = std::max(num_pools, node + 1);
+    }
+    if (num_pools == 0) {
+      return -EINVAL;
+    }
+    numa_cpu_nodes = new std::vector<int>(cpu_nodes);
+    numa_pools = new numa_pool_t[num_pools];
+    for (int i = 0; i < num_pools; ++i) {
+      numa_pools[i].node = i;
+      numa_pools[i].max_bytes = max_bytes;
+      numa_pools[i].huge_pages = huge_pages;
+    }
+    num_numa_pools.store(num_pools, std::memory_order_release);
+    return 0;
+  }
+
+  int buffer::get_num_numa_pools() {
+    return num_numa_pools.load(std::memory_order_acquire);
+  }
+
+  buffer::numa_pool_stats_t buffer::get_numa_pool_stats(int node) {
+    numa_pool_stats_t stats;
+    if (node < 0 || node >= get_num_numa_pools()) {
+      return stats;
+    }
+    auto& pool = numa_pools[node];
+    stats.allocs = pool.allocs;
+    stats.alloc_bytes = pool.alloc_bytes;
+    stats.fallbacks = pool.fallbacks;
+    stats.in_use_bytes = pool.in_use_bytes;
+    stats.mapped_bytes = pool.mapped_bytes;
+    stats.huge_page_bytes = pool.huge_page_bytes;
+    return stats;
+  }
+#else
+  int buffer::enable_numa_pools(const std::vector<int>& cpu_nodes,
+				uint64_t max_bytes, bool huge_pages) {
+    return -EOPNOTSUPP;
+  }
+
+  int buffer::get_num_numa_pools() {
+    return 0;
+  }
+
+  buffer::numa_pool_stats_t buffer::get_numa_pool_stats(int node) {
+    return {};
+  }
+#endif
+
 #ifdef __CYGWIN__
   class buffer::raw_hack_aligned : public buffer::raw {
     unsigned align;
@@ -335,6 +594,11 @@ static ceph::spinlock debug_lock;
     // size passes 8KB.
     if ((align & ~CEPH_PAGE_MASK) == 0 ||
 	len >= CEPH_PAGE_SIZE * 2) {
+#if defined(__linux__)
+      if (auto r = raw_numa_pooled::create(len, align, mempool); r) {
+	return ceph::unique_leakable_ptr<buffer::raw>(r);
+      }
+#endif
 #ifndef __CYGWIN__
       return ceph::unique_leakable_ptr<buffer::raw>(new raw_posix_aligned(len, align));
 #else
@@ -2310,6 +2574,10 @@ MEMPOOL_DEFINE_OBJECT_FACTORY(buffer::raw_claimed_char, buffer_raw_claimed_char,
 			      buffer_meta);
 MEMPOOL_DEFINE_OBJECT_FACTORY(buffer::raw_static, buffer_raw_static,
 			      buffer_meta);
+#if defined(__linux__)
+MEMPOOL_DEFINE_OBJECT_FACTORY(buffer::raw_numa_pooled, buffer_raw_numa_pooled,
+			      buffer_meta);
+#endif
 
 
 void ceph::buffer::list::page_aligned_appender::_refill(size_t len) {
@@ -35,6 +35,9 @@
 #include "common/HeartbeatMap.h"
 #include "common/errno.h"
 #include "common/Graylog.h"
+#ifndef _WIN32
+#include "common/sampling_profiler.h"
+#endif
 #ifdef CEPH_DEBUG_MUTEX
 #include "common/lockdep.h"
 #endif
@@ -141,6 +144,65 @@ private:
   bool m_registered;
   ceph::mutex lock;
 };
+
+class LockContentionObs : public md_config_obs_t,
+			  public AdminSocketHook {
+  CephContext *cct;
+
+public:
+  explicit LockContentionObs(CephContext *cct) : cct(cct) {
+    cct->_conf.add_observer(this);
+    int r = cct->get_admin_socket()->register_command(
+      "dump_lock_contention",
+      this,
+      "dump wait and hold time histograms of the sampled locks");
+    ceph_assert(r == 0);
+    r = cct->get_admin_socket()->register_command(
+      "reset_lock_contention",
+      this,
+      "reset the lock contention profile");
+    ceph_assert(r == 0);
+  }
+  ~LockContentionObs() override {
+    cct->_conf.remove_observer(this);
+    cct->get_admin_socket()->unregister_commands(this);
+  }
+
+  // md_config_obs_t
+  const char** get_tracked_conf_keys() const override {
+    static const char *KEYS[] = {
+      "mutex_contention_sample",
+      NULL
+    };
+    return KEYS;
+  }
+
+  void handle_conf_change(const ConfigProxy& conf,
+                          const std::set <std::string> &changed) override {
+    if (changed.count("mutex_contention_sample")) {
+      ceph::lock_contention_set_sample(
+	conf.get_val<uint64_t>("mutex_contention_sample"));
+    }
+  }
+
+  // AdminSocketHook
+  int call(std::string_view command, const cmdmap_t& cmdmap,
+	   ceph::Formatter *f,
+	   std::ostream& errss,
+	   bufferlist& out) override {
+    if (command == "dump_lock_contention") {
+      f->open_object_section("lock_contention");
+      ceph::lock_contention_dump(f);
+      f->close_section();
+      return 0;
+    }
+    if (command == "reset_lock_contention") {
+      ceph::lock_contention_reset();
+      return 0;
+    }
+    return -ENOSYS;
+  }
+};
 #endif // CEPH_DEBUG_MUTEX
 
 class MempoolObs : public md_config_obs_t,
@@ -195,6 +257,73 @@ public:
   }
 };
 
+#ifndef _WIN32
+class SamplingProfilerHook : public AdminSocketHook {
+  CephContext *cct;
+
+public:
+  explicit SamplingProfilerHook(CephContext *cct) : cct(cct) {
+    auto admin_socket = cct->get_admin_socket();
+    int r = admin_socket->register_command(
+      "sampling_profiler start "
+      "name=frequency,type=CephInt,range=1|1000,req=false",
+      this,
+      "start sampling the stacks of the threads using CPU");
+    ceph_assert(r == 0);
+    r = admin_socket->register_command(
+      "sampling_profiler stop", this, "stop the sampling profiler");
+    ceph_assert(r == 0);
+    r = admin_socket->register_command(
+      "sampling_profiler status", this,
+      "show the state of the sampling profiler");
+    ceph_assert(r == 0);
+    r = admin_socket->register_command(
+      "sampling_profiler dump", this,
+      "dump the sampled stacks in the collapsed-stack format");
+    ceph_assert(r == 0);
+    r = admin_socket->register_command(
+      "sampling_profiler reset", this,
+      "forget the sampled stacks");
+    ceph_assert(r == 0);
+  }
+  ~SamplingProfilerHook() override {
+    cct->get_admin_socket()->unregister_commands(this);
+  }
+
+  // AdminSocketHook
+  int call(std::string_view command, const cmdmap_t& cmdmap,
+	   ceph::Formatter *f,
+	   std::ostream& errss,
+	   bufferlist& out) override {
+    auto& profiler = ceph::SamplingProfiler::instance();
+    if (command == "sampling_profiler start") {
+      int64_t frequency = ceph::SamplingProfiler::DEFAULT_FREQUENCY;
+      ceph::common::cmd_getval(cmdmap, "frequency", frequency);
+      return profiler.start(frequency, errss);
+    }
+    if (command == "sampling_profiler stop") {
+      return profiler.stop(errss);
+    }
+    if (command == "sampling_profiler status") {
+      f->open_object_section("sampling_profiler");
+      profiler.dump_status(f);
+      f->close_section();
+      return 0;
+    }
+    if (command == "sampling_profiler dump") {
+      std::ostringstream ss;
+      profiler.dump_collapsed(ss);
+      out.append(ss.str());
+      return 0;
+    }
+    if (command == "sampling_profiler reset") {
+      return profiler.reset(errss);
+    }
+    return -ENOSYS;
+  }
+};
+#endif
+
 } // anonymous namespace
 
 namespace ceph::common {
@@ -281,7 +410,9 @@ public:
     static const char *KEYS[] = {
       "log_file",
       "log_max_new",
+      "log_drop_on_full",
       "log_max_recent",
+      "log_binary_file",
       "log_to_file",
       "log_to_syslog",
       "err_to_syslog",
@@ -337,10 +468,19 @@ public:
       log->set_max_new(conf->log_max_new);
     }
 
+    if (changed.count("log_drop_on_full")) {
+      log->set_drop_on_full(conf.get_val<bool>("log_drop_on_full"));
+    }
+
     if (changed.count("log_max_recent")) {
       log->set_max_recent(conf->log_max_recent);
     }
 
+    if (changed.count("log_binary_file")) {
+      log->set_binary_log(conf.get_val<std::string>("log_binary_file"),
+			  conf.get_val<Option::size_t>("log_binary_size"));
+    }
+
     // graylog
     if (changed.count("log_to_graylog") || changed.count("err_to_graylog")) {
       int l = conf->log_to_graylog ? 99 : (conf->err_to_graylog ? -1 : -2);
@@ -755,6 +895,14 @@ CephContext::CephContext(uint32_t module_type_,
   _crypto_random.reset(new CryptoRandom());
 
   lookup_or_create_singleton_object<MempoolObs>("mempool_obs", false, this);
+#ifndef _WIN32
+  lookup_or_create_singleton_object<SamplingProfilerHook>(
+    "sampling_profiler_hook", false, this);
+#endif
+#ifdef CEPH_DEBUG_MUTEX
+  lookup_or_create_singleton_object<LockContentionObs>(
+    "lock_contention_obs", false, this);
+#endif
 }
 
 CephContext::~CephContext()
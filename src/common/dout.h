@@ -133,6 +133,13 @@ struct is_dynamic<dynamic_marker_t<T>> : public std::true_type {};
                   "{}", _out.str().c_str());    \
     }                                           \
   } while (0)
+#define dout_bin_impl(cct, sub, v, MSG, ...)                           \
+  do {                                                                  \
+    if (crimson::common::local_conf()->subsys.should_gather(sub, v)) {  \
+      crimson::get_logger(sub).log(crimson::to_log_level(v),            \
+                                   MSG, ##__VA_ARGS__);                 \
+    }                                                                   \
+  } while (0)
 #elif defined(WITH_SEASTAR) && defined(WITH_ALIEN)
 #define dout_impl(cct, sub, v)						\
   do {									\
@@ -143,10 +150,11 @@ struct is_dynamic<dynamic_marker_t<T>> : public std::true_type {};
 #define dendl_impl std::flush;                                          \
   }                                                                     \
   } while (0)
+
+#define dout_bin_impl(cct, sub, v, MSG, ...) do {} while (0)
 #else
-#define dout_impl(cct, sub, v)						\
-  do {									\
-  const bool should_gather = [&](const auto cctX) {			\
+#define dout_should_gather(cct, sub, v)					\
+  [&](const auto cctX) {						\
     if constexpr (ceph::dout::is_dynamic<decltype(sub)>::value ||	\
 		  ceph::dout::is_dynamic<decltype(v)>::value) {		\
       return cctX->_conf->subsys.should_gather(sub, v);			\
@@ -156,7 +164,11 @@ struct is_dynamic<dynamic_marker_t<T>> : public std::true_type {};
        * limitation, sorry. */						\
       return (cctX->_conf->subsys.template should_gather<sub, v>());	\
     }									\
-  }(cct);								\
+  }(cct)
+
+#define dout_impl(cct, sub, v)						\
+  do {									\
+  const bool should_gather = dout_should_gather(cct, sub, v);		\
 									\
   if (should_gather) {							\
     ceph::logging::MutableEntry _dout_e(v, sub);                        \
@@ -170,6 +182,14 @@ struct is_dynamic<dynamic_marker_t<T>> : public std::true_type {};
     _dout_cct->_log->submit_entry(std::move(_dout_e));                  \
   }                                                                     \
   } while (0)
+
+#define dout_bin_impl(cct, sub, v, MSG, ...)				\
+  do {									\
+  if (dout_should_gather(cct, sub, v)) {				\
+    static const ceph::logging::BinaryFormat _dout_bfmt(MSG);		\
+    (cct)->_log->submit_binary(v, sub, _dout_bfmt, ##__VA_ARGS__);	\
+  }									\
+  } while (0)
 #endif	// WITH_SEASTAR
 
 #define lsubdout(cct, sub, v)  dout_impl(cct, ceph_subsys_##sub, v) dout_prefix
@@ -190,6 +210,14 @@ struct is_dynamic<dynamic_marker_t<T>> : public std::true_type {};
 #define lgeneric_dout(cct, v) dout_impl(cct, ceph_subsys_, v) *_dout
 #define lgeneric_derr(cct) dout_impl(cct, ceph_subsys_, -1) *_dout
 
+// fmt-style entries, e.g. ldout_bin(cct, 20, "{} read {}~{}", oid, off, len).
+// the entries which are only gathered are recorded in the binary log if
+// there is one, and formatted when it is decoded. dout_prefix is not used.
+#define lsubdout_bin(cct, sub, v, MSG, ...)				\
+  dout_bin_impl(cct, ceph_subsys_##sub, v, MSG, ##__VA_ARGS__)
+#define ldout_bin(cct, v, MSG, ...)					\
+  dout_bin_impl(cct, dout_subsys, v, MSG, ##__VA_ARGS__)
+
 #define ldlog_p1(cct, sub, lvl)                 \
   (cct->_conf->subsys.should_gather((sub), (lvl)))
 
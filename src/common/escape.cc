@@ -16,8 +16,12 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <cstdint>
 #include <iomanip>
 #include <boost/optional.hpp>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /*
  * Some functions for escaping RGW responses
@@ -251,36 +255,114 @@ void escape_json_attr(const char *buf, size_t src_len, char *out)
 	*o = '\0';
 }
 
-std::ostream& operator<<(std::ostream& out, const json_stream_escaper& e)
+static inline bool json_needs_escape(unsigned char c)
 {
-  boost::optional<hex_formatter> fmt;
+  return c == '"' || c == '\\' || c < 0x20 || c == 0x7f;
+}
 
-  for (unsigned char c : e.str) {
-    switch (c) {
-    case '"':
-      out << DBL_QUOTE_JESCAPE;
-      break;
-    case '\\':
-      out << BACKSLASH_JESCAPE;
-      break;
-    case '\t':
-      out << TAB_JESCAPE;
+// Returns the first character of [p, end) which needs escaping in a JSON
+// string, or end.
+static const char *find_json_escape(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i ctrl = _mm_set1_epi8(0x1f);
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+      _mm_or_si128(_mm_cmpeq_epi8(v, del),
+		   // v <= 0x1f, compared as unsigned
+		   _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v)));
+    if (int mask = _mm_movemask_epi8(m); mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+#else
+  // check 8 bytes at a time, see "Determine if a word has a byte less
+  // than n" in Bit Twiddling Hacks
+  constexpr uint64_t ones = 0x0101010101010101ull;
+  constexpr uint64_t highs = ones * 0x80;
+  auto has_less = [](uint64_t w, uint64_t n) {
+    return (w - ones * n) & ~w & highs;
+  };
+  for (; end - p >= 8; p += 8) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    if (has_less(w, 0x20) ||
+	has_less(w ^ (ones * '"'), 1) ||
+	has_less(w ^ (ones * '\\'), 1) ||
+	has_less(w ^ (ones * 0x7f), 1)) {
       break;
-    case '\n':
-      out << NEWLINE_JESCAPE;
+    }
+  }
+#endif
+  for (; p < end; ++p) {
+    if (json_needs_escape(*p)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+// Writes the escape sequence of 'c' into 'out', which must hold 6
+// characters, and returns its length.
+static size_t json_escape_char(unsigned char c, char *out)
+{
+  static const char hex[] = "0123456789abcdef";
+  switch (c) {
+  case '"':
+    memcpy(out, DBL_QUOTE_JESCAPE, SSTRL(DBL_QUOTE_JESCAPE));
+    return SSTRL(DBL_QUOTE_JESCAPE);
+  case '\\':
+    memcpy(out, BACKSLASH_JESCAPE, SSTRL(BACKSLASH_JESCAPE));
+    return SSTRL(BACKSLASH_JESCAPE);
+  case '\t':
+    memcpy(out, TAB_JESCAPE, SSTRL(TAB_JESCAPE));
+    return SSTRL(TAB_JESCAPE);
+  case '\n':
+    memcpy(out, NEWLINE_JESCAPE, SSTRL(NEWLINE_JESCAPE));
+    return SSTRL(NEWLINE_JESCAPE);
+  default:
+    // Escape control characters.
+    memcpy(out, "\\u00", 4);
+    out[4] = hex[c >> 4];
+    out[5] = hex[c & 0xf];
+    return 6;
+  }
+}
+
+void escape_json_append(std::string_view s, std::string& out)
+{
+  const char *p = s.data();
+  const char *end = p + s.size();
+  while (true) {
+    const char *q = find_json_escape(p, end);
+    out.append(p, q - p);
+    if (q == end) {
       break;
-    default:
-      // Escape control characters.
-      if ((c < 0x20) || (c == 0x7f)) {
-        if (!fmt) {
-          fmt.emplace(out); // enable hex formatting
-        }
-        out << "\\u" << std::setw(4) << static_cast<unsigned int>(c);
-      } else {
-        out << c;
-      }
+    }
+    char esc[6];
+    out.append(esc, json_escape_char(*q, esc));
+    p = q + 1;
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const json_stream_escaper& e)
+{
+  const char *p = e.str.data();
+  const char *end = p + e.str.size();
+  while (true) {
+    const char *q = find_json_escape(p, end);
+    out.write(p, q - p);
+    if (q == end) {
       break;
     }
+    char esc[6];
+    out.write(esc, json_escape_char(*q, esc));
+    p = q + 1;
   }
   return out;
 }
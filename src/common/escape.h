@@ -16,6 +16,7 @@
 #define CEPH_RGW_ESCAPE_H
 
 #include <ostream>
+#include <string>
 #include <string_view>
 
 /* Returns the length of a buffer that would be needed to escape 'buf'
@@ -40,6 +41,12 @@ size_t escape_json_attr_len(const char *buf, size_t src_len);
  */
 void escape_json_attr(const char *buf, size_t src_len, char *out);
 
+/* Appends 's' escaped as a JSON string to 'out'. The characters which need
+ * no escaping are copied in runs, found 16 bytes at a time where SSE2 is
+ * available.
+ */
+void escape_json_append(std::string_view s, std::string& out);
+
 /* Note: we escape control characters. Although the XML spec doesn't actually
  * require this, Amazon does it in their XML responses.
  */
@@ -14,10 +14,65 @@
 
 #include "include/mempool.h"
 #include "include/demangle.h"
+#include "common/likely.h"
 
-// Thread local variables should save index, not &shard[index],
-// because shard[] is defined in the class
-static thread_local size_t thread_shard_index = mempool::num_shards;
+namespace {
+
+// trivially destructible, so that it can still be used by the
+// destructors of the other thread locals; the flush at thread exit is
+// registered separately, see register_thread_cache()
+struct thread_cache_t {
+  struct delta_t {
+    ssize_t items;
+    ssize_t bytes;
+  };
+  delta_t delta[mempool::num_pools];
+  // save the index, not &shard[index], because shard[] is defined in
+  // the class
+  size_t shard_index;
+  // the flush_epoch this thread last flushed at
+  uint64_t epoch;
+  bool registered;
+  // allocations made after the flush at thread exit go to the shards
+  // directly
+  bool exited;
+};
+
+thread_local thread_cache_t thread_cache = {
+  {}, mempool::num_shards, 0, false, false
+};
+
+// bumped to have every thread flush its cache the next time it
+// accounts for an allocation
+std::atomic<uint64_t> flush_epoch = {0};
+
+void flush_thread_cache_at_exit(void *)
+{
+  mempool::flush_thread_cache();
+  thread_cache.exited = true;
+}
+
+void register_thread_cache()
+{
+  // pthread key destructors run after those of the C++ thread locals,
+  // which may still free memory from a pool
+  static pthread_key_t key = [] {
+    pthread_key_t k;
+    int r = pthread_key_create(&k, flush_thread_cache_at_exit);
+    ceph_assert(r == 0);
+    return k;
+  }();
+  pthread_setspecific(key, &thread_cache);
+  thread_cache.epoch = flush_epoch;
+  thread_cache.registered = true;
+}
+
+size_t pool_index(const mempool::pool_t *pool)
+{
+  return pool - &mempool::get_pool((mempool::pool_index_t)0);
+}
+
+} // anonymous namespace
 
 // default to debug_mode off
 bool mempool::debug_mode = false;
@@ -44,6 +99,8 @@ const char *mempool::get_pool_name(mempool::pool_index_t ix) {
 
 void mempool::dump(ceph::Formatter *f)
 {
+  // the counts cached by the other threads show up in the next dump
+  request_thread_cache_flush();
   stats_t total;
   f->open_object_section("mempool"); // we need (dummy?) topmost section for 
 				     // JSON Formatter to print pool names. It omits them otherwise.
@@ -59,6 +116,18 @@ void mempool::dump(ceph::Formatter *f)
   f->close_section();
 }
 
+void mempool::flush_thread_cache()
+{
+  for (size_t i = 0; i < num_pools; ++i) {
+    get_pool((pool_index_t)i).flush_thread_cache();
+  }
+}
+
+void mempool::request_thread_cache_flush()
+{
+  ++flush_epoch;
+}
+
 void mempool::set_debug_mode(bool d)
 {
   debug_mode = d;
@@ -67,12 +136,24 @@ void mempool::set_debug_mode(bool d)
 // --------------------------------------------------------------
 // pool_t
 
-size_t mempool::pool_t::allocated_bytes() const
+mempool::stats_t mempool::pool_t::_get_total() const
 {
-  ssize_t result = 0;
+  // a single pass over the shards for both counters; they are read
+  // racily anyway
+  stats_t total;
   for (size_t i = 0; i < num_shards; ++i) {
-    result += shard[i].bytes;
+    total.items += shard[i].items.load(std::memory_order_relaxed);
+    total.bytes += shard[i].bytes.load(std::memory_order_relaxed);
   }
+  const auto& delta = thread_cache.delta[pool_index(this)];
+  total.items += delta.items;
+  total.bytes += delta.bytes;
+  return total;
+}
+
+size_t mempool::pool_t::allocated_bytes() const
+{
+  ssize_t result = _get_total().bytes;
   if (result < 0) {
     // we raced with some unbalanced allocations/deallocations
     result = 0;
@@ -82,10 +163,7 @@ size_t mempool::pool_t::allocated_bytes() const
 
 size_t mempool::pool_t::allocated_items() const
 {
-  ssize_t result = 0;
-  for (size_t i = 0; i < num_shards; ++i) {
-    result += shard[i].items;
-  }
+  ssize_t result = _get_total().items;
   if (result < 0) {
     // we raced with some unbalanced allocations/deallocations
     result = 0;
@@ -95,19 +173,41 @@ size_t mempool::pool_t::allocated_items() const
 
 void mempool::pool_t::adjust_count(ssize_t items, ssize_t bytes)
 {
-  thread_shard_index = (thread_shard_index == num_shards) ? pick_a_shard_int() : thread_shard_index;
-  shard[thread_shard_index].items += items;
-  shard[thread_shard_index].bytes += bytes;
+  if (unlikely(!thread_cache.registered)) {
+    register_thread_cache();
+  }
+  auto& delta = thread_cache.delta[pool_index(this)];
+  delta.items += items;
+  delta.bytes += bytes;
+  if (uint64_t epoch = flush_epoch.load(std::memory_order_relaxed);
+      unlikely(epoch != thread_cache.epoch)) {
+    thread_cache.epoch = epoch;
+    mempool::flush_thread_cache();
+  } else if (delta.bytes >= flush_bytes || delta.bytes <= -flush_bytes ||
+	     delta.items >= flush_items || delta.items <= -flush_items ||
+	     thread_cache.exited) {
+    flush_thread_cache();
+  }
+}
+
+void mempool::pool_t::flush_thread_cache()
+{
+  auto& delta = thread_cache.delta[pool_index(this)];
+  if (delta.items == 0 && delta.bytes == 0) {
+    return;
+  }
+  size_t& i = thread_cache.shard_index;
+  i = (i == num_shards) ? pick_a_shard_int() : i;
+  shard[i].items += delta.items;
+  shard[i].bytes += delta.bytes;
+  delta = {};
 }
 
 void mempool::pool_t::get_stats(
   stats_t *total,
   std::map<std::string, stats_t> *by_type) const
 {
-  for (size_t i = 0; i < num_shards; ++i) {
-    total->items += shard[i].items;
-    total->bytes += shard[i].bytes;
-  }
+  *total += _get_total();
   if (debug_mode) {
     std::lock_guard shard_lock(lock);
     for (auto &p : type_map) {
@@ -12,7 +12,14 @@
  *
  */
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 #include "common/mutex_debug.h"
+#include "common/Formatter.h"
 #include "common/perf_counters.h"
 #include "common/ceph_context.h"
 #include "common/config.h"
@@ -25,6 +32,106 @@ enum {
   l_mutex_last
 };
 
+std::atomic<unsigned> g_contention_sample = {0};
+
+/// the contention profile of a group of locks: log2 histograms of the
+/// wait and hold times, in ns, of the sampled acquisitions
+struct contention_stats_t {
+  static constexpr unsigned BUCKETS = 32;
+
+  std::atomic<uint64_t> sampled = {0};
+  std::atomic<uint64_t> contended = {0};
+  std::atomic<uint64_t> wait_ns = {0};
+  std::atomic<uint64_t> hold_ns = {0};
+  std::atomic<uint64_t> wait_hist[BUCKETS] = {};
+  std::atomic<uint64_t> hold_hist[BUCKETS] = {};
+
+  static unsigned bucket_of(uint64_t ns) {
+    return std::min<unsigned>(ns ? 64 - __builtin_clzll(ns) : 0, BUCKETS - 1);
+  }
+  void add_wait(uint64_t ns) {
+    contended.fetch_add(1, std::memory_order_relaxed);
+    wait_ns.fetch_add(ns, std::memory_order_relaxed);
+    wait_hist[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+  }
+  void add_hold(uint64_t ns) {
+    hold_ns.fetch_add(ns, std::memory_order_relaxed);
+    hold_hist[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+  }
+  void reset() {
+    sampled = 0;
+    contended = 0;
+    wait_ns = 0;
+    hold_ns = 0;
+    for (unsigned i = 0; i < BUCKETS; i++) {
+      wait_hist[i] = 0;
+      hold_hist[i] = 0;
+    }
+  }
+  static void dump_hist(ceph::Formatter *f, const char *name,
+			const std::atomic<uint64_t> (&hist)[BUCKETS]) {
+    f->open_array_section(name);
+    for (unsigned i = 0; i < BUCKETS; i++) {
+      if (uint64_t n = hist[i]; n) {
+	f->open_object_section("bucket");
+	// bucket i holds [2^(i-1), 2^i) ns
+	f->dump_unsigned("upper_bound_ns", 1ull << i);
+	f->dump_unsigned("count", n);
+	f->close_section();
+      }
+    }
+    f->close_section();
+  }
+  void dump(ceph::Formatter *f) const {
+    f->dump_unsigned("sampled", sampled);
+    f->dump_unsigned("contended", contended);
+    f->dump_unsigned("wait_ns", wait_ns);
+    f->dump_unsigned("hold_ns", hold_ns);
+    dump_hist(f, "wait_histogram", wait_hist);
+    dump_hist(f, "hold_histogram", hold_hist);
+  }
+};
+
+// the profiles are never freed: the locks keep pointers to them
+static std::mutex contention_lock;
+static std::map<std::string, contention_stats_t*> contention_groups;
+
+static contention_stats_t *get_contention_stats(const std::string& group)
+{
+  std::lock_guard l(contention_lock);
+  auto& stats = contention_groups[group];
+  if (!stats) {
+    stats = new contention_stats_t;
+  }
+  return stats;
+}
+
+void mutex_debugging_base::_contention_locked(
+  bool contended, ceph::mono_clock::time_point start, bool hold)
+{
+  auto now = ceph::mono_clock::now();
+  auto stats = contention.load(std::memory_order_relaxed);
+  if (!stats) {
+    stats = get_contention_stats(group);
+    contention = stats;
+  }
+  stats->sampled.fetch_add(1, std::memory_order_relaxed);
+  if (contended) {
+    stats->add_wait(std::chrono::nanoseconds(now - start).count());
+  }
+  if (hold) {
+    hold_start = now;
+  }
+}
+
+void mutex_debugging_base::_contention_held()
+{
+  auto stats = contention.load(std::memory_order_relaxed);
+  stats->add_hold(
+    std::chrono::nanoseconds(ceph::mono_clock::now() - hold_start).count());
+  hold_start = ceph::mono_clock::time_point();
+}
+
 mutex_debugging_base::mutex_debugging_base(std::string group, bool ld, bool bt)
   : group(std::move(group)),
     lockdep(ld),
@@ -56,4 +163,44 @@ void mutex_debugging_base::_will_unlock() {  // about to unlock
 }
 
 } // namespace mutex_debug_detail
+
+void lock_contention_set_sample(unsigned every)
+{
+  mutex_debug_detail::g_contention_sample = every;
+}
+
+void lock_contention_dump(ceph::Formatter *f)
+{
+  using mutex_debug_detail::contention_stats_t;
+  // (wait_ns, name, stats), the wait time being read once for sorting
+  std::vector<std::tuple<uint64_t, std::string, contention_stats_t*>> groups;
+  {
+    std::lock_guard l(mutex_debug_detail::contention_lock);
+    for (auto& [name, stats] : mutex_debug_detail::contention_groups) {
+      groups.emplace_back(stats->wait_ns.load(), name, stats);
+    }
+  }
+  // the most contended first
+  std::sort(groups.begin(), groups.end(), [](auto& a, auto& b) {
+    return std::get<0>(a) > std::get<0>(b);
+  });
+  f->dump_unsigned("sample", mutex_debug_detail::g_contention_sample);
+  f->open_array_section("locks");
+  for (auto& [wait_ns, name, stats] : groups) {
+    f->open_object_section("lock");
+    f->dump_string("name", name);
+    stats->dump(f);
+    f->close_section();
+  }
+  f->close_section();
+}
+
+void lock_contention_reset()
+{
+  std::lock_guard l(mutex_debug_detail::contention_lock);
+  for (auto& [name, stats] : mutex_debug_detail::contention_groups) {
+    stats->reset();
+  }
+}
+
 } // namespace ceph
@@ -29,8 +29,20 @@
 #include "lockdep.h"
 
 namespace ceph {
+
+class Formatter;
+
+/// profile one in every `every` lock acquisitions, or none if 0
+void lock_contention_set_sample(unsigned every);
+/// dump the wait and hold time histograms of the profiled locks
+void lock_contention_dump(ceph::Formatter *f);
+void lock_contention_reset();
+
 namespace mutex_debug_detail {
 
+struct contention_stats_t;
+extern std::atomic<unsigned> g_contention_sample;
+
 class mutex_debugging_base
 {
 protected:
@@ -42,6 +54,11 @@ protected:
   std::atomic<int> nlock = 0;
   std::thread::id locked_by = {};
 
+  /// the profile of this lock's group, looked up on the first sample
+  std::atomic<contention_stats_t*> contention = nullptr;
+  /// when the owner took the lock, if that acquisition is sampled
+  ceph::mono_clock::time_point hold_start;
+
   bool _enable_lockdep() const {
     return lockdep && g_lockdep;
   }
@@ -50,6 +67,30 @@ protected:
   void _locked(); // just locked
   void _will_unlock(); // about to unlock
 
+  /// whether to profile this acquisition
+  static bool _sample_contention() {
+    unsigned every = g_contention_sample.load(std::memory_order_relaxed);
+    if (likely(every == 0)) {
+      return false;
+    }
+    static thread_local unsigned countdown = 0;
+    if (countdown == 0) {
+      countdown = every;
+    }
+    return --countdown == 0;
+  }
+  /// record a sampled acquisition, which waited since `start` if contended,
+  /// and start timing the hold if `hold`
+  void _contention_locked(bool contended, ceph::mono_clock::time_point start,
+			  bool hold);
+  /// record the hold time of a sampled acquisition, if any, before unlocking
+  void _contention_unlock() {
+    if (unlikely(hold_start != ceph::mono_clock::time_point())) {
+      _contention_held();
+    }
+  }
+  void _contention_held();
+
   mutex_debugging_base(std::string group, bool ld = true, bool bt = false);
   ~mutex_debugging_base();
 
@@ -163,8 +204,10 @@ public:
       ceph_assert(nlock == 1);
     }
     ceph_assert(locked_by == std::this_thread::get_id());
-    if (nlock == 1)
+    if (nlock == 1) {
+      _contention_unlock();
       locked_by = std::thread::id();
+    }
     nlock.fetch_sub(1, std::memory_order_release);
   }
 
@@ -182,13 +225,21 @@ public:
     if (enable_lockdep(no_lockdep))
       _will_lock(recursive);
 
-    if (try_lock(no_lockdep))
+    bool sample = _sample_contention();
+    if (try_lock(no_lockdep)) {
+      if (unlikely(sample))
+	_contention_locked(false, {}, nlock == 1);
       return;
+    }
 
+    auto start = sample ? ceph::mono_clock::now() :
+      ceph::mono_clock::time_point();
     lock_impl();
     if (enable_lockdep(no_lockdep))
       _locked();
     _post_lock();
+    if (unlikely(sample))
+      _contention_locked(true, start, nlock == 1);
   }
 
   void unlock(bool no_lockdep = false) {
@@ -184,6 +184,30 @@ static std::string get_task_comm(pid_t tid)
 }
 #endif
 
+int get_cpu_numa_nodes(std::vector<int> *cpu_nodes)
+{
+  cpu_nodes->clear();
+  // the node numbers may have holes
+  for (int node = 0; node < CPU_SETSIZE; ++node) {
+    size_t cpu_set_size;
+    cpu_set_t cpu_set;
+    int r = get_numa_node_cpu_set(node, &cpu_set_size, &cpu_set);
+    if (r == -ENOENT) {
+      continue;
+    }
+    if (r < 0) {
+      return r;
+    }
+    for (auto cpu : cpu_set_to_set(cpu_set_size, &cpu_set)) {
+      if (cpu >= (int)cpu_nodes->size()) {
+	cpu_nodes->resize(cpu + 1, -1);
+      }
+      (*cpu_nodes)[cpu] = node;
+    }
+  }
+  return cpu_nodes->empty() ? -ENOENT : 0;
+}
+
 int set_cpu_affinity_all_threads(size_t cpu_set_size, cpu_set_t *cpu_set)
 {
   // first set my affinity
@@ -251,6 +275,11 @@ int get_numa_node_cpu_set(int node,
   return -ENOTSUP;
 }
 
+int get_cpu_numa_nodes(std::vector<int> *cpu_nodes)
+{
+  return -ENOTSUP;
+}
+
 int set_cpu_affinity_all_threads(size_t cpu_set_size,
 				 cpu_set_t *cpu_set)
 {
@@ -13,6 +13,9 @@
  *
  */
 
+#include <algorithm>
+#include <thread>
+
 #include "common/perf_counters.h"
 #include "common/dout.h"
 #include "common/valgrind.h"
@@ -22,6 +25,23 @@ using std::ostringstream;
 using std::make_pair;
 using std::pair;
 
+namespace {
+
+// Counter is either a perf_counter_data_any_d or a perf_counter_shard_d
+template <typename Counter>
+void inc_counter(Counter& c, int type, uint64_t amt)
+{
+  if (type & PERFCOUNTER_LONGRUNAVG) {
+    c.avgcount++;
+    c.u64 += amt;
+    c.avgcount2++;
+  } else {
+    c.u64 += amt;
+  }
+}
+
+}
+
 namespace TOPNSPC::common {
 PerfCountersCollectionImpl::PerfCountersCollectionImpl()
 {
@@ -168,12 +188,10 @@ void PerfCounters::inc(int idx, uint64_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt;
-    data.avgcount2++;
+  if (auto shard = get_shard(data); shard) {
+    inc_counter(*shard, data.type, amt);
   } else {
-    data.u64 += amt;
+    inc_counter(data, data.type, amt);
   }
 }
 
@@ -190,7 +208,12 @@ void PerfCounters::dec(int idx, uint64_t amt)
   ceph_assert(!(data.type & PERFCOUNTER_LONGRUNAVG));
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  data.u64 -= amt;
+  // the shards may wrap around, their sum is still right
+  if (auto shard = get_shard(data); shard) {
+    shard->u64 -= amt;
+  } else {
+    data.u64 -= amt;
+  }
 }
 
 void PerfCounters::set(int idx, uint64_t amt)
@@ -208,6 +231,9 @@ void PerfCounters::set(int idx, uint64_t amt)
 
   ANNOTATE_BENIGN_RACE_SIZED(&data.u64, sizeof(data.u64),
                              "perf counter atomic");
+  data.for_each_shard([](perf_counter_shard_d& shard) {
+    shard.u64 = 0;
+  });
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
     data.avgcount++;
     data.u64 = amt;
@@ -229,7 +255,7 @@ uint64_t PerfCounters::get(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return 0;
-  return data.u64;
+  return data.read_u64();
 }
 
 void PerfCounters::tinc(int idx, utime_t amt)
@@ -244,12 +270,10 @@ void PerfCounters::tinc(int idx, utime_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.to_nsec();
-    data.avgcount2++;
+  if (auto shard = get_shard(data); shard) {
+    inc_counter(*shard, data.type, amt.to_nsec());
   } else {
-    data.u64 += amt.to_nsec();
+    inc_counter(data, data.type, amt.to_nsec());
   }
 }
 
@@ -265,12 +289,10 @@ void PerfCounters::tinc(int idx, ceph::timespan amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.count();
-    data.avgcount2++;
+  if (auto shard = get_shard(data); shard) {
+    inc_counter(*shard, data.type, amt.count());
   } else {
-    data.u64 += amt.count();
+    inc_counter(data, data.type, amt.count());
   }
 }
 
@@ -286,6 +308,9 @@ void PerfCounters::tset(int idx, utime_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
+  data.for_each_shard([](perf_counter_shard_d& shard) {
+    shard.u64 = 0;
+  });
   data.u64 = amt.to_nsec();
   if (data.type & PERFCOUNTER_LONGRUNAVG)
     ceph_abort();
@@ -303,7 +328,7 @@ utime_t PerfCounters::tget(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return utime_t();
-  uint64_t v = data.u64;
+  uint64_t v = data.read_u64();
   return utime_t(v / 1000000000ull, v % 1000000000ull);
 }
 
@@ -451,7 +476,7 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
         d->histogram->dump_formatted(f);
         f->close_section();
       } else {
-	uint64_t v = d->u64;
+	uint64_t v = d->read_u64();
 	if (d->type & PERFCOUNTER_U64) {
 	  f->dump_unsigned(d->name, v);
 	} else if (d->type & PERFCOUNTER_TIME) {
@@ -485,6 +510,40 @@ PerfCounters::PerfCounters(CephContext *cct, const std::string &name,
 #endif
 {
   m_data.resize(upper_bound - lower_bound - 1);
+  if (auto num_shards = get_num_shards(); num_shards > 1) {
+    m_shards.reserve(num_shards);
+    for (unsigned i = 0; i < num_shards; ++i) {
+      // pad each shard, so the last counters of a shard don't share
+      // their cache line with whatever follows it
+      m_shards.emplace_back(new perf_counter_shard_d[m_data.size() + 3]);
+    }
+  }
+}
+
+unsigned PerfCounters::get_num_shards()
+{
+#if defined(WITH_SEASTAR) && !defined(WITH_ALIEN)
+  // the counters are not shared by reactors
+  return 1;
+#else
+  static const unsigned num_shards =
+    std::clamp(std::thread::hardware_concurrency(), 1u, 32u);
+  return num_shards;
+#endif
+}
+
+PerfCounters::perf_counter_shard_d*
+PerfCounters::get_shard(const perf_counter_data_any_d& data) const
+{
+  if (!data.shards) {
+    return nullptr;
+  }
+  // threads are spread over the shards in the order they first update a
+  // counter, which is cheaper than looking up the current cpu for each
+  // update, and as good as long as the threads don't outnumber the shards
+  static std::atomic<unsigned> next_thread_id = {0};
+  thread_local const unsigned thread_id = next_thread_id++;
+  return &m_shards[thread_id % m_shards.size()][data.shard_index];
 }
 
 PerfCountersBuilder::PerfCountersBuilder(CephContext *cct, const std::string &name,
@@ -571,6 +630,13 @@ void PerfCountersBuilder::add_impl(
   data.type = (enum perfcounter_type_d)ty;
   data.unit = (enum unit_t) unit;
   data.histogram = std::move(histogram);
+  if ((ty & (PERFCOUNTER_COUNTER | PERFCOUNTER_LONGRUNAVG)) &&
+      !(ty & PERFCOUNTER_HISTOGRAM) &&
+      !m_perf_counters->m_shards.empty()) {
+    // the gauges are set more than updated, so they are not sharded
+    data.shards = &m_perf_counters->m_shards;
+    data.shard_index = idx - m_perf_counters->m_lower_bound - 1;
+  }
 }
 
 PerfCounters *PerfCountersBuilder::create_perf_counters()
@@ -154,6 +154,30 @@ private:
 class PerfCounters
 {
 public:
+  /**
+   * The per-shard part of a counter.
+   *
+   * The counters and averages are updated by many threads, so they are
+   * split into shards to keep the threads from bouncing the same cache
+   * line, and the shards are summed up when the value is read.
+   */
+  struct perf_counter_shard_d {
+    std::atomic<uint64_t> u64 = { 0 };
+    std::atomic<uint64_t> avgcount = { 0 };
+    std::atomic<uint64_t> avgcount2 = { 0 };
+
+    std::pair<uint64_t,uint64_t> read_avg() const {
+      uint64_t sum, count;
+      do {
+	count = avgcount2;
+	sum = u64;
+      } while (avgcount != count);
+      return { sum, count };
+    }
+  };
+  using perf_counter_shards_t =
+    std::vector<std::unique_ptr<perf_counter_shard_d[]>>;
+
   /** Represents a PerfCounters data element. */
   struct perf_counter_data_any_d {
     perf_counter_data_any_d()
@@ -174,6 +198,7 @@ public:
       u64 = a.first;
       avgcount = a.second;
       avgcount2 = a.second;
+      // the copy is not sharded, the values are summed up above
       if (other.histogram) {
         histogram.reset(new PerfHistogram<>(*other.histogram));
       }
@@ -189,6 +214,10 @@ public:
     std::atomic<uint64_t> avgcount = { 0 };
     std::atomic<uint64_t> avgcount2 = { 0 };
     std::unique_ptr<PerfHistogram<>> histogram;
+    /// the shards of the owning PerfCounters if this counter is sharded,
+    /// in which case its value is the sum of (*shards)[*][shard_index]
+    const perf_counter_shards_t *shards = nullptr;
+    size_t shard_index = 0;
 
     void reset()
     {
@@ -196,23 +225,51 @@ public:
 	    u64 = 0;
 	    avgcount = 0;
 	    avgcount2 = 0;
+	    for_each_shard([](perf_counter_shard_d& shard) {
+	      shard.u64 = 0;
+	      shard.avgcount = 0;
+	      shard.avgcount2 = 0;
+	    });
       }
       if (histogram) {
         histogram->reset();
       }
     }
 
+    uint64_t read_u64() const {
+      uint64_t v = u64;
+      for_each_shard([&v](const perf_counter_shard_d& shard) {
+	v += shard.u64;
+      });
+      return v;
+    }
+
     // read <sum, count> safely by making sure the post- and pre-count
     // are identical; in other words the whole loop needs to be run
-    // without any intervening calls to inc, set, or tinc.
+    // without any intervening calls to inc, set, or tinc. each shard
+    // is read this way, so the sum of them is consistent as well.
     std::pair<uint64_t,uint64_t> read_avg() const {
       uint64_t sum, count;
       do {
 	count = avgcount2;
 	sum = u64;
       } while (avgcount != count);
+      for_each_shard([&sum, &count](const perf_counter_shard_d& shard) {
+	auto [shard_sum, shard_count] = shard.read_avg();
+	sum += shard_sum;
+	count += shard_count;
+      });
       return { sum, count };
     }
+
+    template <typename Func>
+    void for_each_shard(Func&& f) const {
+      if (shards) {
+	for (auto& shard : *shards) {
+	  f(shard[shard_index]);
+	}
+      }
+    }
   };
 
   template <typename T>
@@ -280,6 +337,11 @@ private:
   void dump_formatted_generic(ceph::Formatter *f, bool schema, bool histograms,
                               const std::string &counter = "") const;
 
+  /// the number of shards to split the counters into
+  static unsigned get_num_shards();
+  /// the shard of the calling thread, or nullptr if not sharded
+  perf_counter_shard_d* get_shard(const perf_counter_data_any_d& data) const;
+
   typedef std::vector<perf_counter_data_any_d> perf_counter_data_vec_t;
 
   CephContext *m_cct;
@@ -296,6 +358,8 @@ private:
 #endif
 
   perf_counter_data_vec_t m_data;
+  /// one array of all counters per shard, empty if not sharded
+  perf_counter_shards_t m_shards;
 
   friend class PerfCountersBuilder;
   friend class PerfCountersCollectionImpl;
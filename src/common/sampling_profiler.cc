@@ -0,0 +1,333 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "common/sampling_profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "acconfig.h"
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
+#include "common/Formatter.h"
+#include "common/errno.h"
+
+namespace ceph {
+
+namespace {
+
+// the frames of the signal handler itself: record(), handle_signal() and
+// the signal trampoline
+constexpr unsigned HANDLER_FRAMES = 3;
+
+void *interrupted_pc(void *uc)
+{
+  auto ctx = static_cast<ucontext_t*>(uc);
+#if defined(__linux__) && defined(__x86_64__)
+  return reinterpret_cast<void*>(ctx->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__linux__) && defined(__aarch64__)
+  return reinterpret_cast<void*>(ctx->uc_mcontext.pc);
+#else
+  (void)ctx;
+  return nullptr;
+#endif
+}
+
+uint64_t hash_stack(void * const *pcs, unsigned depth)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned i = 0; i < depth; i++) {
+    h ^= reinterpret_cast<uintptr_t>(pcs[i]);
+    h *= 1099511628211ull;
+    h ^= h >> 29;
+  }
+  // 0 marks a free slot
+  return h ? h : 1;
+}
+
+std::string symbolize(void *addr)
+{
+  Dl_info info;
+  if (dladdr(addr, &info)) {
+    if (info.dli_sname) {
+      int status;
+      char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr,
+					    &status);
+      if (status == 0) {
+	std::string name(demangled);
+	free(demangled);
+	return name;
+      }
+      return info.dli_sname;
+    }
+    if (info.dli_fname) {
+      // let the caller resolve it offline with the symbols of the object
+      const char *slash = strrchr(info.dli_fname, '/');
+      std::ostringstream ss;
+      ss << (slash ? slash + 1 : info.dli_fname) << "+0x" << std::hex
+	 << (static_cast<char*>(addr) - static_cast<char*>(info.dli_fbase));
+      return ss.str();
+    }
+  }
+  std::ostringstream ss;
+  ss << addr;
+  return ss.str();
+}
+
+} // anonymous namespace
+
+SamplingProfiler& SamplingProfiler::instance()
+{
+  static SamplingProfiler profiler;
+  return profiler;
+}
+
+void SamplingProfiler::handle_signal(int signum, siginfo_t *info, void *uc)
+{
+  int saved_errno = errno;
+  auto& p = instance();
+  p.in_handler++;
+  if (p.running) {
+    p.record(interrupted_pc(uc));
+  }
+  p.in_handler--;
+  errno = saved_errno;
+}
+
+// only async-signal-safe work here: no allocation, no locks
+__attribute__((noinline))
+void SamplingProfiler::record(void *pc)
+{
+  samples++;
+  void *frames[HANDLER_FRAMES + MAX_DEPTH];
+  unsigned n = 0;
+  unsigned first = 0;
+#ifdef HAVE_EXECINFO_H
+  n = backtrace(frames, HANDLER_FRAMES + MAX_DEPTH);
+#endif
+  if (pc) {
+    // skip the handler frames, up to the interrupted instruction
+    while (first < n && first <= HANDLER_FRAMES && frames[first] != pc) {
+      first++;
+    }
+    if (first == n || frames[first] != pc) {
+      // could not unwind through the signal frame
+      frames[0] = pc;
+      first = 0;
+      n = 1;
+    }
+  } else {
+    first = std::min(n, HANDLER_FRAMES);
+  }
+  unsigned depth = std::min(n - first, MAX_DEPTH);
+  if (depth == 0) {
+    dropped++;
+    return;
+  }
+  void * const *pcs = frames + first;
+  uint64_t h = hash_stack(pcs, depth);
+
+  // open addressing, linear probing.  stacks are told apart by their
+  // hash alone, so a racing thread may count a sample in a slot whose
+  // frames are still being filled in.
+  for (unsigned i = 0; i < MAX_STACKS; i++) {
+    stack_t& s = stacks[(h + i) & (MAX_STACKS - 1)];
+    uint64_t cur = s.hash.load(std::memory_order_acquire);
+    if (cur == 0) {
+      if (s.hash.compare_exchange_strong(cur, h)) {
+	s.depth = depth;
+	memcpy(s.pcs, pcs, depth * sizeof(void*));
+	s.ready.store(true, std::memory_order_release);
+	s.count++;
+	return;
+      }
+    }
+    if (cur == h) {
+      s.count++;
+      return;
+    }
+  }
+  dropped++;
+}
+
+int SamplingProfiler::start(unsigned hz, std::ostream& ss)
+{
+#ifndef HAVE_EXECINFO_H
+  ss << "stack traces are not supported on this platform";
+  return -EOPNOTSUPP;
+#else
+  static_assert((MAX_STACKS & (MAX_STACKS - 1)) == 0,
+		"MAX_STACKS must be a power of 2");
+  std::lock_guard l(lock);
+  if (running) {
+    ss << "profiler is already running";
+    return -EBUSY;
+  }
+  if (hz == 0 || hz > 1000) {
+    ss << "frequency must be between 1 and 1000 Hz";
+    return -EINVAL;
+  }
+  if (!stacks) {
+    stacks.reset(new stack_t[MAX_STACKS]);
+  }
+  // the first backtrace() loads the unwinder, which allocates; do it
+  // here rather than in the signal handler
+  void *warmup[1];
+  backtrace(warmup, 1);
+
+  struct sigaction old;
+  if (sigaction(SIGPROF, nullptr, &old) < 0) {
+    int r = -errno;
+    ss << "sigaction failed: " << cpp_strerror(r);
+    return r;
+  }
+  if (old.sa_sigaction != handle_signal) {
+    if ((old.sa_flags & SA_SIGINFO) ||
+	(old.sa_handler != SIG_DFL && old.sa_handler != SIG_IGN)) {
+      ss << "SIGPROF is in use by another profiler";
+      return -EBUSY;
+    }
+    // the handler stays installed once the profiler is stopped: a
+    // SIGPROF still pending would otherwise terminate the process
+    struct sigaction sa = {};
+    sa.sa_sigaction = handle_signal;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, nullptr) < 0) {
+      int r = -errno;
+      ss << "sigaction failed: " << cpp_strerror(r);
+      return r;
+    }
+  }
+
+  running = true;
+  struct itimerval timer;
+  // tv_usec must stay below 1000000
+  const unsigned interval_us = 1000000 / hz;
+  timer.it_interval.tv_sec = interval_us / 1000000;
+  timer.it_interval.tv_usec = interval_us % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) < 0) {
+    int r = -errno;
+    running = false;
+    ss << "setitimer failed: " << cpp_strerror(r);
+    return r;
+  }
+  frequency = hz;
+  return 0;
+#endif
+}
+
+int SamplingProfiler::stop(std::ostream& ss)
+{
+  std::lock_guard l(lock);
+  if (!running) {
+    ss << "profiler is not running";
+    return -EINVAL;
+  }
+  struct itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  running = false;
+  // wait for the handlers which are still recording
+  while (in_handler) {
+    std::this_thread::yield();
+  }
+  return 0;
+}
+
+int SamplingProfiler::reset(std::ostream& ss)
+{
+  std::lock_guard l(lock);
+  if (running) {
+    ss << "profiler is running";
+    return -EBUSY;
+  }
+  if (stacks) {
+    for (unsigned i = 0; i < MAX_STACKS; i++) {
+      stacks[i].hash = 0;
+      stacks[i].ready = false;
+      stacks[i].count = 0;
+      stacks[i].depth = 0;
+    }
+  }
+  samples = 0;
+  dropped = 0;
+  return 0;
+}
+
+void SamplingProfiler::dump_status(Formatter *f) const
+{
+  std::lock_guard l(lock);
+  unsigned used = 0;
+  if (stacks) {
+    for (unsigned i = 0; i < MAX_STACKS; i++) {
+      if (stacks[i].hash) {
+	used++;
+      }
+    }
+  }
+  f->dump_bool("running", running);
+  f->dump_unsigned("frequency", running ? frequency : 0);
+  f->dump_unsigned("samples", samples);
+  f->dump_unsigned("dropped", dropped);
+  f->dump_unsigned("stacks", used);
+  f->dump_unsigned("max_stacks", MAX_STACKS);
+}
+
+void SamplingProfiler::dump_collapsed(std::ostream& out) const
+{
+  std::lock_guard l(lock);
+  if (!stacks) {
+    return;
+  }
+  std::map<void*, std::string> names;
+  auto name = [&names](void *pc, bool leaf) -> const std::string& {
+    // all but the leaf are return addresses, which may already point
+    // at the next function
+    void *addr = leaf ? pc : static_cast<char*>(pc) - 1;
+    auto [p, inserted] = names.try_emplace(addr);
+    if (inserted) {
+      p->second = symbolize(addr);
+    }
+    return p->second;
+  };
+  // stacks which only differ in the offsets within the same functions
+  // collapse into one line
+  std::map<std::string, uint64_t> collapsed;
+  for (unsigned i = 0; i < MAX_STACKS; i++) {
+    const stack_t& s = stacks[i];
+    if (!s.ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+    uint64_t count = s.count;
+    if (!count) {
+      continue;
+    }
+    // outermost frame first
+    std::string line;
+    for (unsigned j = s.depth; j > 0; j--) {
+      line += name(s.pcs[j - 1], j == 1);
+      if (j > 1) {
+	line += ';';
+      }
+    }
+    collapsed[line] += count;
+  }
+  for (auto& [line, count] : collapsed) {
+    out << line << ' ' << count << '\n';
+  }
+}
+
+}
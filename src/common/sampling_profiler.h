@@ -0,0 +1,79 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_COMMON_SAMPLING_PROFILER_H
+#define CEPH_COMMON_SAMPLING_PROFILER_H
+
+#include <signal.h>
+
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+
+#include "common/ceph_mutex.h"
+
+namespace ceph {
+
+class Formatter;
+
+/**
+ * SamplingProfiler -- a process wide, SIGPROF driven CPU profiler
+ *
+ * While running, an ITIMER_PROF timer interrupts the threads consuming
+ * CPU and the signal handler records the interrupted call stack in a
+ * fixed-size, lock-free table, keyed by a hash of the stack.  Stacks
+ * which do not fit in the table are only counted as dropped.  Nothing
+ * is allocated or symbolized in the signal handler; the addresses are
+ * resolved when the profile is dumped, in the collapsed-stack format
+ * consumed by flamegraph.pl and most other flame graph tools.
+ *
+ * When the profiler is stopped the timer is disarmed, so it costs
+ * nothing.
+ */
+class SamplingProfiler {
+public:
+  static constexpr unsigned MAX_DEPTH = 64;
+  static constexpr unsigned MAX_STACKS = 4096;
+  static constexpr unsigned DEFAULT_FREQUENCY = 99;
+
+  static SamplingProfiler& instance();
+
+  /// start sampling at @p hz samples per second of CPU time
+  int start(unsigned hz, std::ostream& ss);
+  int stop(std::ostream& ss);
+  /// forget the samples collected so far; the profiler must be stopped
+  int reset(std::ostream& ss);
+  bool is_running() const {
+    return running.load(std::memory_order_relaxed);
+  }
+
+  void dump_status(Formatter *f) const;
+  /// one "root;...;leaf count" line per distinct stack
+  void dump_collapsed(std::ostream& out) const;
+
+private:
+  struct stack_t {
+    std::atomic<uint64_t> hash = {0};   ///< 0 if the slot is free
+    std::atomic<bool> ready = {false};  ///< depth and pcs are valid
+    std::atomic<uint64_t> count = {0};
+    unsigned depth = 0;
+    void *pcs[MAX_DEPTH];
+  };
+
+  SamplingProfiler() = default;
+
+  static void handle_signal(int signum, siginfo_t *info, void *uc);
+  void record(void *pc);
+
+  mutable ceph::mutex lock = ceph::make_mutex("SamplingProfiler::lock");
+  std::atomic<bool> running = {false};
+  std::atomic<unsigned> in_handler = {0};
+  std::atomic<uint64_t> samples = {0};
+  std::atomic<uint64_t> dropped = {0};
+  unsigned frequency = 0;
+  std::unique_ptr<stack_t[]> stacks;
+};
+
+}
+
+#endif
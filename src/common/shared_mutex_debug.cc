@@ -44,13 +44,25 @@ void shared_mutex_debug::lock()
   if (_enable_lockdep()) {
     _will_lock();
   }
-  if (int r = pthread_rwlock_wrlock(&rwlock); r != 0) {
-    throw std::system_error(r, std::generic_category());
+  bool sample = _sample_contention();
+  bool contended = false;
+  ceph::mono_clock::time_point start;
+  if (unlikely(sample) && pthread_rwlock_trywrlock(&rwlock) != 0) {
+    contended = true;
+    start = ceph::mono_clock::now();
+  }
+  if (!sample || contended) {
+    if (int r = pthread_rwlock_wrlock(&rwlock); r != 0) {
+      throw std::system_error(r, std::generic_category());
+    }
   }
   if (_enable_lockdep()) {
     _locked();
   }
   _post_lock();
+  if (unlikely(sample)) {
+    _contention_locked(contended, start, true);
+  }
 }
 
 bool shared_mutex_debug::try_lock()
@@ -87,13 +99,26 @@ void shared_mutex_debug::lock_shared()
   if (_enable_lockdep()) {
     _will_lock();
   }
-  if (int r = pthread_rwlock_rdlock(&rwlock); r != 0) {
-    throw std::system_error(r, std::generic_category());
+  // only the wait is profiled: a shared lock has many holders
+  bool sample = _sample_contention();
+  bool contended = false;
+  ceph::mono_clock::time_point start;
+  if (unlikely(sample) && pthread_rwlock_tryrdlock(&rwlock) != 0) {
+    contended = true;
+    start = ceph::mono_clock::now();
+  }
+  if (!sample || contended) {
+    if (int r = pthread_rwlock_rdlock(&rwlock); r != 0) {
+      throw std::system_error(r, std::generic_category());
+    }
   }
   if (_enable_lockdep()) {
     _locked();
   }
   _post_lock_shared();
+  if (unlikely(sample)) {
+    _contention_locked(contended, start, false);
+  }
 }
 
 bool shared_mutex_debug::try_lock_shared()
@@ -129,6 +154,7 @@ void shared_mutex_debug::unlock_shared()
 // exclusive locking
 void shared_mutex_debug::_pre_unlock()
 {
+  _contention_unlock();
   if (track) {
     ceph_assert(nlock > 0);
     --nlock;
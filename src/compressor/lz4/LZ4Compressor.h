@@ -54,8 +54,7 @@ class LZ4Compressor : public Compressor {
 #endif
     ceph::buffer::ptr outptr = ceph::buffer::create_small_page_aligned(
       LZ4_compressBound(src.length()));
-    LZ4_stream_t lz4_stream;
-    LZ4_resetStream(&lz4_stream);
+    LZ4_stream_t& lz4_stream = get_stream();
 
     using ceph::encode;
 
@@ -142,6 +141,23 @@ class LZ4Compressor : public Compressor {
     dst.push_back(std::move(dstptr));
     return 0;
   }
+
+ private:
+  // the compressor is shared by all its users, so the stream state is cached
+  // per thread, and only reset instead of being initialized for each call
+  static LZ4_stream_t& get_stream() {
+    thread_local LZ4_stream_t lz4_stream = [] {
+      LZ4_stream_t stream;
+      LZ4_resetStream(&stream);
+      return stream;
+    }();
+#if LZ4_VERSION_NUMBER >= 10900
+    LZ4_resetStream_fast(&lz4_stream);
+#else
+    LZ4_resetStream(&lz4_stream);
+#endif
+    return lz4_stream;
+  }
 };
 
 #endif
@@ -16,6 +16,8 @@
 #define CEPH_COMPRESSION_PLUGIN_ZSTD_H
 
 // -----------------------------------------------------------------------------
+#include <sstream>
+
 #include "ceph_ver.h"
 #include "compressor/CompressionPlugin.h"
 #include "ZstdCompressor.h"
@@ -31,13 +33,34 @@ public:
   int factory(CompressorRef *cs,
                       std::ostream *ss) override
   {
-    if (compressor == 0) {
+    if (compressor == 0 && dict_error == 0) {
       ZstdCompressor *interface = new ZstdCompressor(cct);
-      compressor = CompressorRef(interface);
+      auto dict = cct->_conf.get_val<std::string>("compressor_zstd_dictionary");
+      if (!dict.empty()) {
+	std::ostringstream err;
+	dict_error = interface->load_dictionary(dict, &err);
+	if (dict_error < 0) {
+	  // without the dictionary, the data compressed with it could not
+	  // be decompressed, and new data would silently not use it
+	  dict_error_msg = err.str();
+	  delete interface;
+	}
+      }
+      if (dict_error == 0) {
+	compressor = CompressorRef(interface);
+      }
+    }
+    if (dict_error < 0) {
+      *ss << dict_error_msg;
+      return dict_error;
     }
     *cs = compressor;
     return 0;
   }
+
+private:
+  int dict_error = 0;
+  std::string dict_error_msg;
 };
 
 #endif
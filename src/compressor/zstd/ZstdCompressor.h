@@ -15,6 +15,10 @@
 #ifndef CEPH_ZSTDCOMPRESSOR_H
 #define CEPH_ZSTDCOMPRESSOR_H
 
+#include <algorithm>
+#include <memory>
+#include <ostream>
+
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd/lib/zstd.h"
 
@@ -25,10 +29,46 @@
 class ZstdCompressor : public Compressor {
  public:
   ZstdCompressor(CephContext *cct) : Compressor(COMP_ALG_ZSTD, "zstd"), cct(cct) {}
+  ~ZstdCompressor() override {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+  }
+
+  /// load a dictionary trained with "zstd --train" for the data to compress.
+  /// once loaded, the compressed frames reference the dictionary by its id,
+  /// and they can only be decompressed if the same dictionary is loaded.
+  int load_dictionary(const std::string& path, std::ostream *ss) {
+    ceph::buffer::list dict;
+    std::string err;
+    if (int r = dict.read_file(path.c_str(), &err); r < 0) {
+      *ss << "failed to read zstd dictionary " << path << ": " << err;
+      return r;
+    }
+    // the dictionary content is copied, so dict can go away afterwards
+    cdict = ZSTD_createCDict(dict.c_str(), dict.length(),
+			     cct->_conf->compressor_zstd_level);
+    ddict = ZSTD_createDDict(dict.c_str(), dict.length());
+    if (!cdict || !ddict) {
+      *ss << "failed to load zstd dictionary " << path;
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+      cdict = nullptr;
+      ddict = nullptr;
+      return -EINVAL;
+    }
+    dict_id = ZSTD_getDictID_fromDDict(ddict);
+    return 0;
+  }
 
   int compress(const ceph::buffer::list &src, ceph::buffer::list &dst, std::optional<int32_t> &compressor_message) override {
-    ZSTD_CStream *s = ZSTD_createCStream();
-    ZSTD_initCStream_srcSize(s, cct->_conf->compressor_zstd_level, src.length());
+    ZSTD_CCtx *s = get_cctx();
+    ZSTD_CCtx_reset(s, ZSTD_reset_session_and_parameters);
+    ZSTD_CCtx_setParameter(s, ZSTD_c_compressionLevel,
+			   cct->_conf->compressor_zstd_level);
+    ZSTD_CCtx_setPledgedSrcSize(s, src.length());
+    if (cdict) {
+      ZSTD_CCtx_refCDict(s, cdict);
+    }
     auto p = src.begin();
     size_t left = src.length();
 
@@ -53,8 +93,6 @@ class ZstdCompressor : public Compressor {
     }
     ceph_assert(p.end());
 
-    ZSTD_freeCStream(s);
-
     // prefix with decompressed length
     ceph::encode((uint32_t)src.length(), dst);
     dst.append(outptr, 0, outbuf.pos);
@@ -82,8 +120,20 @@ class ZstdCompressor : public Compressor {
     outbuf.dst = dstptr.c_str();
     outbuf.size = dstptr.length();
     outbuf.pos = 0;
-    ZSTD_DStream *s = ZSTD_createDStream();
-    ZSTD_initDStream(s);
+    ZSTD_DCtx *s = get_dctx();
+    ZSTD_DCtx_reset(s, ZSTD_reset_session_and_parameters);
+    if (ddict) {
+      // frames compressed without dictionary must be decompressed without
+      // it, as the dictionary changes the initial state of the decoder
+      char header[ZSTD_FRAMEHEADERSIZE_MAX];
+      size_t header_len = std::min(compressed_len, sizeof(header));
+      auto hp = p;
+      hp.copy(header_len, header);
+      unsigned frame_dict_id = ZSTD_getDictID_fromFrame(header, header_len);
+      if (frame_dict_id == dict_id) {
+	ZSTD_DCtx_refDDict(s, ddict);
+      }
+    }
     while (compressed_len > 0) {
       if (p.end()) {
 	return -1;
@@ -92,16 +142,38 @@ class ZstdCompressor : public Compressor {
       inbuf.pos = 0;
       inbuf.size = p.get_ptr_and_advance(compressed_len,
 					 (const char**)&inbuf.src);
-      ZSTD_decompressStream(s, &outbuf, &inbuf);
+      size_t r = ZSTD_decompressStream(s, &outbuf, &inbuf);
+      if (ZSTD_isError(r)) {
+	return -1;
+      }
       compressed_len -= inbuf.size;
     }
-    ZSTD_freeDStream(s);
 
     dst.append(dstptr, 0, outbuf.pos);
     return 0;
   }
  private:
+  // the compressor is shared by all its users, so the (de)compression
+  // contexts are cached per thread instead of being created for each call
+  static ZSTD_CCtx* get_cctx() {
+    struct deleter {
+      void operator()(ZSTD_CCtx* cctx) const { ZSTD_freeCCtx(cctx); }
+    };
+    thread_local std::unique_ptr<ZSTD_CCtx, deleter> cctx{ZSTD_createCCtx()};
+    return cctx.get();
+  }
+  static ZSTD_DCtx* get_dctx() {
+    struct deleter {
+      void operator()(ZSTD_DCtx* dctx) const { ZSTD_freeDCtx(dctx); }
+    };
+    thread_local std::unique_ptr<ZSTD_DCtx, deleter> dctx{ZSTD_createDCtx()};
+    return dctx.get();
+  }
+
   CephContext *const cct;
+  ZSTD_CDict *cdict = nullptr;
+  ZSTD_DDict *ddict = nullptr;
+  unsigned dict_id = 0;
 };
 
 #endif
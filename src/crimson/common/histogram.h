@@ -0,0 +1,40 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 smarttab expandtab
+
+#pragma once
+
+#include <seastar/core/metrics_types.hh>
+
+namespace crimson::common {
+
+/// add @p value to @p hist, whose bucket counts are cumulative
+inline void sample_histogram(seastar::metrics::histogram& hist, double value)
+{
+  ++hist.sample_count;
+  hist.sample_sum += value;
+  for (auto& bucket : hist.buckets) {
+    if (value <= bucket.upper_bound) {
+      ++bucket.count;
+    }
+  }
+}
+
+/// clear @p hist, and give it the buckets first_bound, 2 * first_bound, ...
+/// up to max_bound
+inline void reset_histogram(seastar::metrics::histogram& hist,
+                            double first_bound,
+                            double max_bound)
+{
+  hist = seastar::metrics::histogram();
+  for (double bound = first_bound; ; bound *= 2) {
+    seastar::metrics::histogram_bucket bucket;
+    bucket.count = 0;
+    bucket.upper_bound = bound;
+    hist.buckets.push_back(bucket);
+    if (bound >= max_bound) {
+      break;
+    }
+  }
+}
+
+}
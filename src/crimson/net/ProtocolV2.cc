@@ -3,6 +3,7 @@
 
 #include "ProtocolV2.h"
 
+#include <algorithm>
 #include <seastar/core/lowres_clock.hh>
 #include <fmt/format.h>
 #include "include/msgr.h"
@@ -286,18 +287,32 @@ seastar::future<> ProtocolV2::read_frame_payload()
   return seastar::do_until(
     [this] { return rx_frame_asm.get_num_segments() == rx_segments_data.size(); },
     [this] {
-      // TODO: create aligned and contiguous buffer from socket
       const size_t seg_idx = rx_segments_data.size();
-      if (uint16_t alignment = rx_frame_asm.get_segment_align(seg_idx);
-	  alignment != segment_t::DEFAULT_ALIGNMENT) {
-        logger().trace("{} cannot allocate {} aligned buffer at segment desc index {}",
-                       conn, alignment, rx_segments_data.size());
-      }
+      uint16_t alignment = rx_frame_asm.get_segment_align(seg_idx);
       uint32_t onwire_len = rx_frame_asm.get_segment_onwire_len(seg_idx);
-      // TODO: create aligned and contiguous buffer from socket
-      return read_exactly(onwire_len).then([this] (auto tmp_bl) {
+      return read_exactly(onwire_len
+      ).then([this, alignment] (auto tmp_bl) {
         logger().trace("{} RECV({}) frame segment[{}]",
                        conn, tmp_bl.size(), rx_segments_data.size());
+        if (alignment != segment_t::DEFAULT_ALIGNMENT &&
+            tmp_bl.size() > 0 &&
+            !session_stream_handlers.rx) {
+          // in crc mode, the segment (e.g. the data of MOSDOp) is handed down
+          // to the ObjectStore as it is, make sure it is aligned so that it
+          // can be adopted without copying later. In secure mode the segment
+          // is decrypted into a new buffer anyway.
+          bool copied = false;
+          if (reinterpret_cast<uintptr_t>(tmp_bl.get()) % alignment != 0) {
+            auto aligned = Socket::tmp_buf::aligned(alignment, tmp_bl.size());
+            std::copy_n(tmp_bl.get(), tmp_bl.size(), aligned.get_write());
+            tmp_bl = std::move(aligned);
+            copied = true;
+          }
+          logger().trace("{} RECV frame segment[{}] {} aligned by {}",
+                         conn, rx_segments_data.size(),
+                         copied ? "copied" : "already", alignment);
+          messenger.account_rx_segment(tmp_bl.size(), copied);
+        }
         bufferlist segment;
         segment.append(buffer::create(std::move(tmp_bl)));
         rx_segments_data.emplace_back(std::move(segment));
@@ -38,7 +38,9 @@ SocketMessenger::SocketMessenger(const entity_name_t& myname,
     master_sid{seastar::this_shard_id()},
     logic_name{logic_name},
     nonce{nonce}
-{}
+{
+  register_metrics();
+}
 
 SocketMessenger::~SocketMessenger()
 {
@@ -245,6 +247,32 @@ SocketMessenger::connect(const entity_addr_t& peer_addr, const entity_name_t& pe
   return conn->shared_from_this();
 }
 
+void SocketMessenger::register_metrics()
+{
+  namespace sm = seastar::metrics;
+  std::vector<sm::label_instance> label_instances;
+  label_instances.push_back(sm::label_instance("messenger", logic_name));
+  label_instances.push_back(sm::label_instance("nonce", nonce));
+  metrics.add_group(
+    "messenger",
+    {
+      sm::make_counter(
+        "rx_segment_copy_bytes",
+        stats.rx_segment_copy_bytes,
+        sm::description("bytes of aligned frame segments copied on receive"),
+        label_instances
+      ),
+      sm::make_counter(
+        "rx_segment_zero_copy_bytes",
+        stats.rx_segment_zero_copy_bytes,
+        sm::description("bytes of aligned frame segments received without "
+                        "copying"),
+        label_instances
+      ),
+    }
+  );
+}
+
 seastar::future<> SocketMessenger::shutdown()
 {
   assert(seastar::this_shard_id() == master_sid);
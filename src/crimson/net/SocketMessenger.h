@@ -18,6 +18,7 @@
 #include <set>
 #include <vector>
 #include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_future.hh>
@@ -49,6 +50,13 @@ class SocketMessenger final : public Messenger {
   uint32_t global_seq = 0;
   bool started = false;
 
+  struct {
+    uint64_t rx_segment_copy_bytes = 0;
+    uint64_t rx_segment_zero_copy_bytes = 0;
+  } stats;
+  seastar::metrics::metric_group metrics;
+  void register_metrics();
+
   listen_ertr::future<> do_listen(const entity_addrvec_t& addr);
   /// try to bind to the first unused port of given address
   bind_ertr::future<> try_bind(const entity_addrvec_t& addr,
@@ -120,6 +128,16 @@ class SocketMessenger final : public Messenger {
     assert(seastar::this_shard_id() == master_sid);
     return master_sid;
   }
+
+  // account an aligned frame segment received, copied if the receive buffer
+  // from the socket didn't satisfy the required alignment
+  void account_rx_segment(size_t bytes, bool copied) {
+    if (copied) {
+      stats.rx_segment_copy_bytes += bytes;
+    } else {
+      stats.rx_segment_zero_copy_bytes += bytes;
+    }
+  }
 };
 
 } // namespace crimson::net
@@ -613,6 +613,26 @@ void Cache::register_metrics()
       }
     );
   }
+
+  /**
+   * fresh data extents
+   */
+  metrics.add_group(
+    "cache",
+    {
+      sm::make_counter(
+        "data_copy_bytes",
+        stats.data_copy_bytes,
+        sm::description("total bytes copied into fresh data extents")
+      ),
+      sm::make_counter(
+        "data_zero_copy_bytes",
+        stats.data_zero_copy_bytes,
+        sm::description("total bytes adopted by fresh data extents "
+                        "without copying")
+      ),
+    }
+  );
 }
 
 void Cache::add_extent(CachedExtentRef ref)
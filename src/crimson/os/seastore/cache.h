@@ -509,6 +509,57 @@ public:
     return ret;
   }
 
+  /**
+   * alloc_new_extent_with_data
+   *
+   * Allocates a fresh extent holding data. The buffer of data is adopted
+   * without copying if it is a single page aligned buffer which nothing
+   * else refers to, e.g. a data segment received by the messenger once the
+   * message is gone. A buffer still shared, say with the message or with
+   * the transaction sent to the replicas, is copied, as the extent may be
+   * modified in place later.
+   */
+  template <typename T>
+  TCachedExtentRef<T> alloc_new_extent_with_data(
+    Transaction &t,                  ///< [in, out] current transaction
+    const ceph::bufferlist &data,    ///< [in] extent content
+    placement_hint_t hint = placement_hint_t::HOT
+  ) {
+    LOG_PREFIX(Cache::alloc_new_extent_with_data);
+    seastore_off_t length = data.length();
+    SUBTRACET(seastore_cache, "allocate {} {}B, hint={}",
+              t, T::TYPE, length, hint);
+    ceph::bufferptr bp;
+    if (data.get_num_buffers() == 1 &&
+        data.front().is_page_aligned() &&
+        data.front().raw_nref() == 1) {
+      bp = data.front();
+      stats.data_zero_copy_bytes += length;
+    } else {
+      bp = ceph::bufferptr(buffer::create_page_aligned(length));
+      data.cbegin().copy(length, bp.c_str());
+      stats.data_copy_bytes += length;
+    }
+    auto result = epm.alloc_new_extent(t, T::TYPE, hint, std::move(bp));
+    auto ret = CachedExtent::make_cached_extent_ref<T>(std::move(result.bp));
+    ret->set_paddr(result.paddr);
+    ret->hint = hint;
+    t.add_fresh_extent(ret);
+    ret->state = CachedExtent::extent_state_t::INITIAL_WRITE_PENDING;
+    SUBDEBUGT(seastore_cache, "allocated {} {}B extent at {}, hint={} -- {}",
+              t, T::TYPE, length, result.paddr, hint, *ret);
+    return ret;
+  }
+
+  /// the bytes alloc_new_extent_with_data() copied
+  uint64_t get_data_copy_bytes() const {
+    return stats.data_copy_bytes;
+  }
+  /// the bytes alloc_new_extent_with_data() adopted without copying
+  uint64_t get_data_zero_copy_bytes() const {
+    return stats.data_zero_copy_bytes;
+  }
+
   /**
    * alloc_new_extent
    *
@@ -917,6 +968,9 @@ private:
 
     std::array<uint64_t, NUM_SRC_COMB> trans_conflicts_by_srcs;
     counter_by_src_t<uint64_t> trans_conflicts_by_unknown;
+
+    uint64_t data_copy_bytes = 0;
+    uint64_t data_zero_copy_bytes = 0;
   } stats;
 
   template <typename CounterT>
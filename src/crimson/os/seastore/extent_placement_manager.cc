@@ -22,6 +22,9 @@ SegmentedOolWriter::SegmentedOolWriter(
                        "seastore_journal_batch_flush_size"),
                      crimson::common::get_conf<double>(
                        "seastore_journal_batch_preferred_fullness"),
+                     std::chrono::microseconds(
+                       crimson::common::get_conf<uint64_t>(
+                         "seastore_journal_batch_max_latency_us")),
                      segment_allocator)
 {
 }
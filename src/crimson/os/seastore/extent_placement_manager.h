@@ -149,13 +149,23 @@ public:
     seastore_off_t length,
     placement_hint_t hint
   ) {
-    assert(hint < placement_hint_t::NUM_HINTS);
-
     // XXX: bp might be extended to point to differnt memory (e.g. PMem)
     // according to the allocator.
     auto bp = ceph::bufferptr(
       buffer::create_page_aligned(length));
     bp.zero();
+    return alloc_new_extent(t, type, hint, std::move(bp));
+  }
+
+  /// allocates a new extent backed by the page aligned bp
+  alloc_result_t alloc_new_extent(
+    Transaction& t,
+    extent_types_t type,
+    placement_hint_t hint,
+    bufferptr &&bp
+  ) {
+    assert(hint < placement_hint_t::NUM_HINTS);
+    assert(bp.is_page_aligned());
 
     if (!is_logical_type(type)) {
       // TODO: implement out-of-line strategy for physical extent.
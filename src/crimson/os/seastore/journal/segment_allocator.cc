@@ -5,11 +5,15 @@
 
 #include <fmt/format.h>
 
+#include "crimson/common/histogram.h"
 #include "crimson/os/seastore/logging.h"
 #include "crimson/os/seastore/segment_cleaner.h"
 
 SET_SUBSYS(seastore_journal);
 
+using crimson::common::reset_histogram;
+using crimson::common::sample_histogram;
+
 namespace crimson::os::seastore::journal {
 
 SegmentAllocator::SegmentAllocator(
@@ -280,6 +284,7 @@ RecordBatch::add_pending(
   if (state == state_t::EMPTY) {
     assert(!io_promise.has_value());
     io_promise = seastar::shared_promise<maybe_promise_result_t>();
+    start_time = std::chrono::steady_clock::now();
   } else {
     assert(io_promise.has_value());
   }
@@ -372,17 +377,21 @@ RecordSubmitter::RecordSubmitter(
   std::size_t batch_capacity,
   std::size_t batch_flush_size,
   double preferred_fullness,
+  std::chrono::microseconds batch_max_latency,
   SegmentAllocator& sa)
   : io_depth_limit{io_depth},
     preferred_fullness{preferred_fullness},
+    batch_max_latency{batch_max_latency},
+    batch_timer([this] { on_batch_timeout(); }),
     segment_allocator{sa},
     batches(new RecordBatch[io_depth + 1])
 {
   LOG_PREFIX(RecordSubmitter);
   INFO("{} io_depth_limit={}, batch_capacity={}, batch_flush_size={}, "
-       "preferred_fullness={}",
+       "preferred_fullness={}, batch_max_latency={}us",
        get_name(), io_depth, batch_capacity,
-       batch_flush_size, preferred_fullness);
+       batch_flush_size, preferred_fullness,
+       batch_max_latency.count());
   ceph_assert(io_depth > 0);
   ceph_assert(batch_capacity > 0);
   ceph_assert(preferred_fullness >= 0 &&
@@ -517,8 +526,9 @@ RecordSubmitter::submit(record_t&& record)
   assert(check_action(record.size) != action_t::ROLL);
   auto eval = p_current_batch->evaluate_submit(
       record.size, segment_allocator.get_block_size());
+  bool delay_batch = update_and_check_delay_batch();
   bool needs_flush = (
-      state == state_t::IDLE ||
+      (state == state_t::IDLE && !delay_batch) ||
       eval.submit_size.get_fullness() > preferred_fullness ||
       // RecordBatch::needs_flush()
       eval.is_full ||
@@ -538,7 +548,10 @@ RecordSubmitter::submit(record_t&& record)
           get_name(), sizes, committed_to, num_outstanding_io);
     account_submission(1, sizes);
     return segment_allocator.write(to_write
-    ).safe_then([mdlength = sizes.get_mdlength()](auto write_result) {
+    ).safe_then([this, mdlength = sizes.get_mdlength(),
+                 start_time = std::chrono::steady_clock::now()
+                ](auto write_result) {
+      account_batch_latency(start_time);
       return record_locator_t{
         write_result.start_seq.offset.add_offset(mdlength),
         write_result
@@ -548,6 +561,7 @@ RecordSubmitter::submit(record_t&& record)
     });
   }
   // indirect batched write
+  bool is_new_batch = p_current_batch->is_empty();
   auto write_fut = p_current_batch->add_pending(
     get_name(),
     std::move(record),
@@ -580,6 +594,18 @@ RecordSubmitter::submit(record_t&& record)
           p_current_batch->get_num_records(),
           num_outstanding_io);
     assert(!p_current_batch->needs_flush());
+    if (state == state_t::IDLE) {
+      // no outstanding io to trigger the flush, hold back the batch
+      // for at most batch_max_latency
+      assert(delay_batch);
+      if (is_new_batch) {
+        assert(!batch_timer.armed());
+        ++stats.record_batch_delayed;
+        batch_timer.arm(batch_max_latency);
+      } else {
+        assert(batch_timer.armed());
+      }
+    }
   }
   return write_fut;
 }
@@ -592,6 +618,11 @@ RecordSubmitter::open()
     LOG_PREFIX(RecordSubmitter::open);
     DEBUG("{} register metrics", get_name());
     stats = {};
+    reset_histogram(stats.record_batch_size, 1,
+                    batches[0].get_batch_capacity());
+    reset_histogram(stats.record_batch_lat, 8, 64 * 1024);
+    avg_submit_interval_us = 0;
+    last_submit_time.reset();
     namespace sm = seastar::metrics;
     std::vector<sm::label_instance> label_instances;
     label_instances.push_back(sm::label_instance("submitter", get_name()));
@@ -640,6 +671,37 @@ RecordSubmitter::open()
           sm::description("bytes of data when write record groups"),
           label_instances
         ),
+        sm::make_counter(
+          "record_batch_delayed",
+          stats.record_batch_delayed,
+          sm::description("total number of batches held back to group "
+                          "concurrent records"),
+          label_instances
+        ),
+        sm::make_counter(
+          "record_batch_timeout",
+          stats.record_batch_timeout,
+          sm::description("total number of held back batches flushed by "
+                          "reaching batch_max_latency"),
+          label_instances
+        ),
+        sm::make_histogram(
+          "record_batch_size",
+          [this]() -> seastar::metrics::histogram& {
+            return stats.record_batch_size;
+          },
+          sm::description("distribution of the number of records per write"),
+          label_instances
+        ),
+        sm::make_histogram(
+          "record_batch_latency",
+          [this]() -> seastar::metrics::histogram& {
+            return stats.record_batch_lat;
+          },
+          sm::description("distribution of the latency in microseconds from "
+                          "a record batch started to its write completion"),
+          label_instances
+        ),
       }
     );
     return ret;
@@ -657,6 +719,8 @@ RecordSubmitter::close()
   assert(!wait_available_promise.has_value());
   has_io_error = false;
   assert(!wait_unfull_flush_promise.has_value());
+  assert(!batch_timer.armed());
+  batch_timer.cancel();
   metrics.clear();
   return segment_allocator.close();
 }
@@ -717,6 +781,57 @@ void RecordSubmitter::account_submission(
   stats.record_group_metadata_bytes += size.get_raw_mdlength();
   stats.record_group_data_bytes += size.dlength;
   stats.record_batch_stats.increment(num);
+  sample_histogram(stats.record_batch_size, num);
+}
+
+void RecordSubmitter::account_batch_latency(
+  std::chrono::steady_clock::time_point start_time)
+{
+  auto lat = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  sample_histogram(stats.record_batch_lat, lat.count());
+}
+
+bool RecordSubmitter::update_and_check_delay_batch()
+{
+  auto now = std::chrono::steady_clock::now();
+  if (last_submit_time.has_value()) {
+    auto interval = std::chrono::duration_cast<std::chrono::microseconds>(
+        now - *last_submit_time);
+    // exponential moving average with weight 1/8 for the new sample
+    avg_submit_interval_us +=
+      (interval.count() - avg_submit_interval_us) / 8;
+  } else {
+    // no history, start from a value that never delays
+    avg_submit_interval_us = batch_max_latency.count();
+  }
+  last_submit_time = now;
+
+  if (batch_timer.armed()) {
+    // keep holding back the current batch
+    assert(state == state_t::IDLE);
+    assert(p_current_batch->is_pending());
+    return true;
+  }
+  return (batch_max_latency.count() > 0 &&
+          p_current_batch->is_empty() &&
+          avg_submit_interval_us < batch_max_latency.count());
+}
+
+void RecordSubmitter::on_batch_timeout()
+{
+  LOG_PREFIX(RecordSubmitter::on_batch_timeout);
+  if (!p_current_batch->is_pending() ||
+      state == state_t::FULL ||
+      has_io_error) {
+    return;
+  }
+  DEBUG("{} {} records held for {}us, flush",
+        get_name(),
+        p_current_batch->get_num_records(),
+        batch_max_latency.count());
+  ++stats.record_batch_timeout;
+  flush_current_batch();
 }
 
 void RecordSubmitter::finish_submit_batch(
@@ -734,20 +849,24 @@ void RecordSubmitter::flush_current_batch()
   LOG_PREFIX(RecordSubmitter::flush_current_batch);
   RecordBatch* p_batch = p_current_batch;
   assert(p_batch->is_pending());
+  batch_timer.cancel();
   p_current_batch = nullptr;
   pop_free_batch();
 
   increment_io();
   auto num = p_batch->get_num_records();
+  auto start_time = p_batch->get_start_time();
   auto [to_write, sizes] = p_batch->encode_batch(
     committed_to, segment_allocator.get_nonce());
   DEBUG("{} {} records, {}, committed_to={}, outstanding_io={} ...",
         get_name(), num, sizes, committed_to, num_outstanding_io);
   account_submission(num, sizes);
   std::ignore = segment_allocator.write(to_write
-  ).safe_then([this, p_batch, FNAME, num, sizes=sizes](auto write_result) {
+  ).safe_then([this, p_batch, FNAME, num, sizes=sizes, start_time
+              ](auto write_result) {
     TRACE("{} {} records, {}, write done with {}",
           get_name(), num, sizes, write_result);
+    account_batch_latency(start_time);
     finish_submit_batch(p_batch, write_result);
   }).handle_error(
     crimson::ct_error::all_same_way([this, p_batch, FNAME, num, sizes=sizes](auto e) {
@@ -3,10 +3,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <optional>
 #include <seastar/core/circular_buffer.hh>
 #include <seastar/core/metrics.hh>
 #include <seastar/core/shared_future.hh>
+#include <seastar/core/timer.hh>
 
 #include "include/buffer.h"
 
@@ -169,6 +171,12 @@ public:
     return batch_capacity;
   }
 
+  // the time when the first pending record was added
+  std::chrono::steady_clock::time_point get_start_time() const {
+    assert(state != state_t::EMPTY);
+    return start_time;
+  }
+
   const record_group_size_t& get_submit_size() const {
     assert(state != state_t::EMPTY);
     return pending.size;
@@ -256,6 +264,7 @@ private:
   std::size_t index = 0;
   std::size_t batch_capacity = 0;
   std::size_t batch_flush_size = 0;
+  std::chrono::steady_clock::time_point start_time;
 
   record_group_t pending;
   std::size_t submitting_size = 0;
@@ -281,6 +290,10 @@ private:
  * - batch_flush_size: the bytes threshold to force flush a RecordBatch to
  *   control the maximum latency;
  * - preferred_fullness: the fullness threshold to flush a RecordBatch;
+ * - batch_max_latency: the maximum time a RecordBatch may be held back when
+ *   there is no outstanding io, in order to group records from concurrent
+ *   transactions. Holding back only happens when the observed interval
+ *   between submissions is shorter than this target, 0 to disable;
  */
 class RecordSubmitter {
   enum class state_t {
@@ -308,6 +321,7 @@ public:
                   std::size_t batch_capacity,
                   std::size_t batch_flush_size,
                   double preferred_fullness,
+                  std::chrono::microseconds batch_max_latency,
                   SegmentAllocator&);
 
   const std::string& get_name() const {
@@ -386,10 +400,25 @@ private:
 
   void flush_current_batch();
 
+  // sample the submission interval, return whether the current batch should
+  // be held back for more records although there is no outstanding io
+  bool update_and_check_delay_batch();
+
+  void on_batch_timeout();
+
+  void account_batch_latency(std::chrono::steady_clock::time_point);
+
   state_t state = state_t::IDLE;
   std::size_t num_outstanding_io = 0;
   std::size_t io_depth_limit;
   double preferred_fullness;
+  std::chrono::microseconds batch_max_latency;
+
+  // moving average of the interval between submissions in microseconds
+  double avg_submit_interval_us = 0;
+  std::optional<std::chrono::steady_clock::time_point> last_submit_time;
+  // armed iff the current batch is held back with no outstanding io
+  seastar::timer<> batch_timer;
 
   SegmentAllocator& segment_allocator;
   // committed_to may be in a previous journal segment
@@ -413,6 +442,12 @@ private:
     uint64_t record_group_padding_bytes = 0;
     uint64_t record_group_metadata_bytes = 0;
     uint64_t record_group_data_bytes = 0;
+    uint64_t record_batch_delayed = 0;
+    uint64_t record_batch_timeout = 0;
+    // records per write
+    seastar::metrics::histogram record_batch_size;
+    // microseconds from the first record added to the write completion
+    seastar::metrics::histogram record_batch_lat;
   } stats;
   seastar::metrics::metric_group metrics;
 };
@@ -140,7 +140,7 @@ ObjectDataHandler::write_ret do_insertions(
 	return ctx.tm.alloc_extent<ObjectDataBlock>(
 	  ctx.t,
 	  region.addr,
-	  region.len
+	  *region.to_write
 	).si_then([&region](auto extent) {
 	  if (extent->get_laddr() != region.addr) {
 	    logger().debug(
@@ -151,8 +151,6 @@ ObjectDataHandler::write_ret do_insertions(
 	  }
 	  ceph_assert(extent->get_laddr() == region.addr);
 	  ceph_assert(extent->get_length() == region.len);
-	  auto iter = region.to_write->cbegin();
-	  iter.copy(region.len, extent->get_bptr().c_str());
 	  return ObjectDataHandler::write_iertr::now();
 	});
       } else {
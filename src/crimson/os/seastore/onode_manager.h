@@ -79,6 +79,23 @@ public:
     const ghobject_t& end,
     uint64_t limit) = 0;
 
+  /**
+   * scan_onodes
+   *
+   * Like list_onodes(), but also returns the onodes so that sequential
+   * traversals (backfill, scrub) don't need to look up each object again.
+   * The onodes are valid only within trans.
+   */
+  using scan_onodes_iertr = base_iertr;
+  using scan_onodes_bare_ret = std::tuple<
+    std::vector<std::pair<ghobject_t, OnodeRef>>, ghobject_t>;
+  using scan_onodes_ret = scan_onodes_iertr::future<scan_onodes_bare_ret>;
+  virtual scan_onodes_ret scan_onodes(
+    Transaction &trans,
+    const ghobject_t& start,
+    const ghobject_t& end,
+    uint64_t limit) = 0;
+
   virtual ~OnodeManager() {}
 };
 using OnodeManagerRef = std::unique_ptr<OnodeManager>;
@@ -1,6 +1,9 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
 // vim: ts=8 sw=2 smarttab
 
+#include <algorithm>
+#include <numeric>
+
 #include "crimson/os/seastore/logging.h"
 
 #include "crimson/os/seastore/onode_manager/staged-fltree/fltree_onode_manager.h"
@@ -29,10 +32,7 @@ FLTreeOnodeManager::get_onode_ret FLTreeOnodeManager::get_onode(
       DEBUGT("no entry for {}", trans, hoid);
       return crimson::ct_error::enoent::make();
     }
-    auto val = OnodeRef(new FLTreeOnode(
-	default_data_reservation,
-	default_metadata_range,
-	cursor.value()));
+    auto val = make_onode(cursor);
     return get_onode_iertr::make_ready_future<OnodeRef>(
       val
     );
@@ -51,10 +51,7 @@ FLTreeOnodeManager::get_or_create_onode(
   ).si_then([this, &trans, &hoid, FNAME](auto p)
               -> get_or_create_onode_ret {
     auto [cursor, created] = std::move(p);
-    auto val = OnodeRef(new FLTreeOnode(
-	default_data_reservation,
-	default_metadata_range,
-	cursor.value()));
+    auto val = make_onode(cursor);
     if (created) {
       DEBUGT("created onode for entry for {}", trans, hoid);
       val->get_mutable_layout(trans) = onode_layout_t{};
@@ -70,16 +67,24 @@ FLTreeOnodeManager::get_or_create_onodes(
   Transaction &trans,
   const std::vector<ghobject_t> &hoids)
 {
+  // insert in the key order, so that consecutive insertions mostly land in
+  // the same leaf node which is already loaded and tracked, e.g. when
+  // recovering or backfilling a batch of objects
+  std::vector<std::size_t> order(hoids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&hoids](auto l, auto r) {
+    return hoids[l] < hoids[r];
+  });
   return seastar::do_with(
-    std::vector<OnodeRef>(),
-    [this, &hoids, &trans](auto &ret) {
-      ret.reserve(hoids.size());
+    std::vector<OnodeRef>(hoids.size()),
+    std::move(order),
+    [this, &hoids, &trans](auto &ret, auto &order) {
       return trans_intr::do_for_each(
-        hoids,
-        [this, &trans, &ret](auto &hoid) {
-          return get_or_create_onode(trans, hoid
-          ).si_then([&ret](auto &&onoderef) {
-            ret.push_back(std::move(onoderef));
+        order,
+        [this, &trans, &ret, &hoids](auto index) {
+          return get_or_create_onode(trans, hoids[index]
+          ).si_then([&ret, index](auto &&onoderef) {
+            ret[index] = std::move(onoderef);
           });
         }).si_then([&ret] {
           return std::move(ret);
@@ -121,35 +126,39 @@ FLTreeOnodeManager::erase_onode_ret FLTreeOnodeManager::erase_onode(
   return erase_onode_iertr::now();
 }
 
-FLTreeOnodeManager::list_onodes_ret FLTreeOnodeManager::list_onodes(
+template <typename F>
+eagain_ifuture<ghobject_t> FLTreeOnodeManager::scan(
   Transaction &trans,
   const ghobject_t& start,
   const ghobject_t& end,
-  uint64_t limit)
+  uint64_t limit,
+  F &&f)
 {
   return tree.lower_bound(trans, start
-  ).si_then([this, &trans, end, limit] (auto&& cursor) {
-    using crimson::os::seastore::onode::full_key_t;
+  ).si_then([this, &trans, end, limit, f=std::forward<F>(f)]
+            (auto&& cursor) mutable {
     return seastar::do_with(
         limit,
         std::move(cursor),
-        list_onodes_bare_ret(),
-        [this, &trans, end] (auto& to_list, auto& current_cursor, auto& ret) {
+        ghobject_t(),
+        std::move(f),
+        [this, &trans, end] (auto& to_list, auto& current_cursor,
+                             auto& next, auto& f) {
       return trans_intr::repeat(
-          [this, &trans, end, &to_list, &current_cursor, &ret] ()
+          [this, &trans, end, &to_list, &current_cursor, &next, &f] ()
           -> eagain_ifuture<seastar::stop_iteration> {
         if (current_cursor.is_end() ||
             current_cursor.get_ghobj() >= end) {
-          std::get<1>(ret) = end;
+          next = end;
           return seastar::make_ready_future<seastar::stop_iteration>(
             seastar::stop_iteration::yes);
         }
         if (to_list == 0) {
-          std::get<1>(ret) = current_cursor.get_ghobj();
+          next = current_cursor.get_ghobj();
           return seastar::make_ready_future<seastar::stop_iteration>(
             seastar::stop_iteration::yes);
         }
-        std::get<0>(ret).emplace_back(current_cursor.get_ghobj());
+        f(current_cursor);
         return tree.get_next(trans, current_cursor
         ).si_then([&to_list, &current_cursor] (auto&& next_cursor) mutable {
           // we intentionally hold the current_cursor during get_next() to
@@ -159,15 +168,47 @@ FLTreeOnodeManager::list_onodes_ret FLTreeOnodeManager::list_onodes(
           return seastar::make_ready_future<seastar::stop_iteration>(
 	        seastar::stop_iteration::no);
         });
-      }).si_then([&ret] () mutable {
-        return seastar::make_ready_future<list_onodes_bare_ret>(
-            std::move(ret));
-       //  return ret;
+      }).si_then([&next] () mutable {
+        return std::move(next);
       });
     });
   });
 }
 
+FLTreeOnodeManager::list_onodes_ret FLTreeOnodeManager::list_onodes(
+  Transaction &trans,
+  const ghobject_t& start,
+  const ghobject_t& end,
+  uint64_t limit)
+{
+  return seastar::do_with(
+    std::vector<ghobject_t>(),
+    [this, &trans, start, end, limit](auto &oids) {
+    return scan(trans, start, end, limit, [&oids](auto &cursor) {
+      oids.emplace_back(cursor.get_ghobj());
+    }).si_then([&oids](auto next) {
+      return list_onodes_bare_ret(std::move(oids), std::move(next));
+    });
+  });
+}
+
+FLTreeOnodeManager::scan_onodes_ret FLTreeOnodeManager::scan_onodes(
+  Transaction &trans,
+  const ghobject_t& start,
+  const ghobject_t& end,
+  uint64_t limit)
+{
+  return seastar::do_with(
+    std::vector<std::pair<ghobject_t, OnodeRef>>(),
+    [this, &trans, start, end, limit](auto &onodes) {
+    return scan(trans, start, end, limit, [this, &onodes](auto &cursor) {
+      onodes.emplace_back(cursor.get_ghobj(), make_onode(cursor));
+    }).si_then([&onodes](auto next) {
+      return scan_onodes_bare_ret(std::move(onodes), std::move(next));
+    });
+  });
+}
+
 FLTreeOnodeManager::~FLTreeOnodeManager() {}
 
 }
@@ -117,6 +117,22 @@ class FLTreeOnodeManager : public crimson::os::seastore::OnodeManager {
   uint32_t default_data_reservation = 0;
   uint32_t default_metadata_offset = 0;
   uint32_t default_metadata_range = 0;
+
+  OnodeRef make_onode(OnodeTree::Cursor &cursor) {
+    return OnodeRef(new FLTreeOnode(
+	default_data_reservation,
+	default_metadata_range,
+	cursor.value()));
+  }
+
+  /// visits the cursors in [start, end) up to limit, returns where it stops
+  template <typename F>
+  eagain_ifuture<ghobject_t> scan(
+    Transaction &trans,
+    const ghobject_t& start,
+    const ghobject_t& end,
+    uint64_t limit,
+    F &&f);
 public:
   FLTreeOnodeManager(TransactionManager &tm) :
     tree(NodeExtentManager::create_seastore(tm)),
@@ -161,6 +177,12 @@ public:
     const ghobject_t& end,
     uint64_t limit) final;
 
+  scan_onodes_ret scan_onodes(
+    Transaction &trans,
+    const ghobject_t& start,
+    const ghobject_t& end,
+    uint64_t limit) final;
+
   ~FLTreeOnodeManager();
 };
 using FLTreeOnodeManagerRef = std::unique_ptr<FLTreeOnodeManager>;
@@ -293,13 +293,7 @@ public:
     Transaction &t,
     laddr_t laddr_hint,
     extent_len_t len) {
-    placement_hint_t placement_hint;
-    if constexpr (T::TYPE == extent_types_t::OBJECT_DATA_BLOCK ||
-                  T::TYPE == extent_types_t::COLL_BLOCK) {
-      placement_hint = placement_hint_t::COLD;
-    } else {
-      placement_hint = placement_hint_t::HOT;
-    }
+    auto placement_hint = get_placement_hint<T>();
     LOG_PREFIX(TransactionManager::alloc_extent);
     SUBTRACET(seastore_tm, "{} len={}, placement_hint={}, laddr_hint={}",
               t, T::TYPE, len, placement_hint, laddr_hint);
@@ -308,17 +302,31 @@ public:
       t,
       len,
       placement_hint);
-    return lba_manager->alloc_extent(
+    return alloc_extent_pin<T>(t, laddr_hint, std::move(ext));
+  }
+
+  /**
+   * alloc_extent
+   *
+   * Allocates a new block of type T holding data with the minimum lba range
+   * of size data.length() greater than laddr_hint, see
+   * Cache::alloc_new_extent_with_data().
+   */
+  template <typename T>
+  alloc_extent_ret<T> alloc_extent(
+    Transaction &t,
+    laddr_t laddr_hint,
+    const ceph::bufferlist &data) {
+    auto placement_hint = get_placement_hint<T>();
+    LOG_PREFIX(TransactionManager::alloc_extent);
+    SUBTRACET(seastore_tm, "{} len={} with data, placement_hint={}, laddr_hint={}",
+              t, T::TYPE, data.length(), placement_hint, laddr_hint);
+    ceph_assert(is_aligned(laddr_hint, (uint64_t)epm->get_block_size()));
+    auto ext = cache->alloc_new_extent_with_data<T>(
       t,
-      laddr_hint,
-      len,
-      ext->get_paddr()
-    ).si_then([ext=std::move(ext), laddr_hint, &t, FNAME](auto &&ref) mutable {
-      ext->set_pin(std::move(ref));
-      SUBDEBUGT(seastore_tm, "new extent: {}, laddr_hint: {}", t, *ext, laddr_hint);
-      return alloc_extent_iertr::make_ready_future<TCachedExtentRef<T>>(
-	std::move(ext));
-    });
+      data,
+      placement_hint);
+    return alloc_extent_pin<T>(t, laddr_hint, std::move(ext));
   }
 
   using reserve_extent_iertr = alloc_extent_iertr;
@@ -562,6 +570,38 @@ private:
   rewrite_extent_ret rewrite_logical_extent(
     Transaction& t,
     LogicalCachedExtentRef extent);
+
+  template <typename T>
+  static placement_hint_t get_placement_hint() {
+    if constexpr (T::TYPE == extent_types_t::OBJECT_DATA_BLOCK ||
+                  T::TYPE == extent_types_t::COLL_BLOCK) {
+      return placement_hint_t::COLD;
+    } else {
+      return placement_hint_t::HOT;
+    }
+  }
+
+  /// maps the fresh extent ext into the lba tree
+  template <typename T>
+  alloc_extent_ret<T> alloc_extent_pin(
+    Transaction &t,
+    laddr_t laddr_hint,
+    TCachedExtentRef<T> &&ext) {
+    LOG_PREFIX(TransactionManager::alloc_extent);
+    auto len = ext->get_length();
+    auto paddr = ext->get_paddr();
+    return lba_manager->alloc_extent(
+      t,
+      laddr_hint,
+      len,
+      paddr
+    ).si_then([ext=std::move(ext), laddr_hint, &t, FNAME](auto &&ref) mutable {
+      ext->set_pin(std::move(ref));
+      SUBDEBUGT(seastore_tm, "new extent: {}, laddr_hint: {}", t, *ext, laddr_hint);
+      return alloc_extent_iertr::make_ready_future<TCachedExtentRef<T>>(
+	std::move(ext));
+    });
+  }
 public:
   // Testing interfaces
   auto get_segment_cleaner() {
@@ -298,11 +298,38 @@ namespace {
   }
 }
 
+void OSD::register_metrics()
+{
+  namespace sm = seastar::metrics;
+  for (std::size_t i = 0; i < ClientRequest::NUM_STAGES; ++i) {
+    auto stage = static_cast<ClientRequest::stage_t>(i);
+    // from 8us up to about 17s
+    crimson::common::reset_histogram(
+      stats.client_request_stage_lat[i], 8, 16 * 1024 * 1024);
+    auto desc = fmt::format(
+      "latency in microseconds of client requests in stage {}",
+      ClientRequest::get_stage_name(stage));
+    metrics.add_group(
+      "osd",
+      {
+        sm::make_histogram(
+          "client_request_stage_lat", [this, i] {
+            return stats.client_request_stage_lat[i];
+          },
+          sm::description(desc),
+          {sm::label_instance("stage", ClientRequest::get_stage_name(stage))}
+        ),
+      }
+    );
+  }
+}
+
 seastar::future<> OSD::start()
 {
   logger().info("start");
 
   startup_time = ceph::mono_clock::now();
+  register_metrics();
 
   return store.start().then([this] {
     return store.mount().handle_error(
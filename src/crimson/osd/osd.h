@@ -6,6 +6,7 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/shared_future.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/shared_future.hh>
 #include <seastar/core/timer.hh>
@@ -14,6 +15,7 @@
 #include "crimson/common/type_helpers.h"
 #include "crimson/common/auth_handler.h"
 #include "crimson/common/gated.h"
+#include "crimson/common/histogram.h"
 #include "crimson/admin/admin_socket.h"
 #include "crimson/common/simple_lru.h"
 #include "crimson/common/shared_lru.h"
@@ -24,6 +26,7 @@
 #include "crimson/osd/shard_services.h"
 #include "crimson/osd/osdmap_gate.h"
 #include "crimson/osd/pg_map.h"
+#include "crimson/osd/osd_operations/client_request.h"
 #include "crimson/osd/osd_operations/peering_event.h"
 
 #include "messages/MOSDOp.h"
@@ -246,9 +249,25 @@ public:
   Ref<PG> get_pg(spg_t pgid);
   seastar::future<> send_beacon();
 
+  void add_client_request_stage_latency(
+    ClientRequest::stage_t stage,
+    std::chrono::steady_clock::duration dur) {
+    assert(static_cast<std::size_t>(stage) < stats.client_request_stage_lat.size());
+    crimson::common::sample_histogram(
+      stats.client_request_stage_lat[static_cast<std::size_t>(stage)],
+      std::chrono::duration_cast<std::chrono::microseconds>(dur).count());
+  }
+
 private:
   LogClient log_client;
   LogChannelRef clog;
+
+  struct {
+    std::array<seastar::metrics::histogram,
+               ClientRequest::NUM_STAGES> client_request_stage_lat;
+  } stats;
+  seastar::metrics::metric_group metrics;
+  void register_metrics();
 };
 
 inline std::ostream& operator<<(std::ostream& out, const OSD& osd) {
@@ -33,6 +33,43 @@ ClientRequest::ClientRequest(
 ClientRequest::~ClientRequest()
 {
   logger().debug("{}: destroying", *this);
+  account_stage(stage_t::max);
+}
+
+const char* ClientRequest::get_stage_name(stage_t stage)
+{
+  static constexpr const char* const STAGE_NAMES[] = {
+    "conn_await_map",
+    "conn_get_pg",
+    "pg_await_map",
+    "wait_for_active",
+    "recover_missing",
+    "get_obc",
+    "process",
+    "wait_repop",
+    "send_reply",
+  };
+  static_assert(std::size(STAGE_NAMES) == NUM_STAGES);
+  assert(stage < stage_t::max);
+  return STAGE_NAMES[static_cast<std::size_t>(stage)];
+}
+
+void ClientRequest::account_stage(stage_t next_stage)
+{
+  auto now = std::chrono::steady_clock::now();
+  if (current_stage != stage_t::max) {
+    osd.add_client_request_stage_latency(
+      current_stage, now - stage_start_time);
+  }
+  current_stage = next_stage;
+  stage_start_time = now;
+}
+
+template <typename StageT>
+blocking_future<> ClientRequest::enter_stage(StageT &stage, stage_t stage_id)
+{
+  account_stage(stage_id);
+  return handle.enter(stage);
 }
 
 void ClientRequest::print(std::ostream &lhs) const
@@ -79,13 +116,13 @@ seastar::future<> ClientRequest::start()
 
   return seastar::repeat([this, opref=IRef{this}]() mutable {
       logger().debug("{}: in repeat", *this);
-      return with_blocking_future(handle.enter(cp().await_map))
+      return with_blocking_future(enter_stage(cp().await_map, stage_t::conn_await_map))
       .then([this]() {
 	return with_blocking_future(
 	    osd.osdmap_gate.wait_for_map(
 	      m->get_min_epoch()));
       }).then([this](epoch_t epoch) {
-	return with_blocking_future(handle.enter(cp().get_pg));
+	return with_blocking_future(enter_stage(cp().get_pg, stage_t::conn_get_pg));
       }).then([this] {
 	return with_blocking_future(osd.wait_for_pg(m->get_spg()));
       }).then([this](Ref<PG> pgref) mutable {
@@ -105,13 +142,13 @@ seastar::future<> ClientRequest::start()
               });
             }
             return with_blocking_future_interruptible<interruptor::condition>(
-              handle.enter(pp(pg).await_map)
+              enter_stage(pp(pg).await_map, stage_t::pg_await_map)
             ).then_interruptible([this, &pg] {
               return with_blocking_future_interruptible<interruptor::condition>(
                 pg.osdmap_gate.wait_for_map(m->get_min_epoch()));
             }).then_interruptible([this, &pg](auto map) {
               return with_blocking_future_interruptible<interruptor::condition>(
-                handle.enter(pp(pg).wait_for_active));
+                enter_stage(pp(pg).wait_for_active, stage_t::wait_for_active));
             }).then_interruptible([this, &pg]() {
               return with_blocking_future_interruptible<interruptor::condition>(
                 pg.wait_for_active_blocker.wait());
@@ -161,7 +198,7 @@ ClientRequest::interruptible_future<ClientRequest::seq_mode_t>
 ClientRequest::process_op(Ref<PG> &pg)
 {
   return with_blocking_future_interruptible<interruptor::condition>(
-      handle.enter(pp(*pg).recover_missing))
+      enter_stage(pp(*pg).recover_missing, stage_t::recover_missing))
   .then_interruptible(
     [this, pg]() mutable {
     return do_recover_missing(pg, m->get_hobj());
@@ -178,7 +215,7 @@ ClientRequest::process_op(Ref<PG> &pg)
         });
       } else {
         return with_blocking_future_interruptible<interruptor::condition>(
-            handle.enter(pp(*pg).get_obc)).then_interruptible(
+            enter_stage(pp(*pg).get_obc, stage_t::get_obc)).then_interruptible(
           [this, pg]() mutable -> PG::load_obc_iertr::future<seq_mode_t> {
           logger().debug("{}: got obc lock", *this);
           op_info.set_from_op(&*m, *pg->get_osdmap());
@@ -188,7 +225,7 @@ ClientRequest::process_op(Ref<PG> &pg)
             return pg->with_locked_obc(m->get_hobj(), op_info,
                                        [this, pg, &mode](auto obc) mutable {
               return with_blocking_future_interruptible<interruptor::condition>(
-                handle.enter(pp(*pg).process)
+                enter_stage(pp(*pg).process, stage_t::process)
               ).then_interruptible([this, pg, obc, &mode]() mutable {
                 return do_process(pg, obc).then_interruptible([&mode] (seq_mode_t _mode) {
                   mode = _mode;
@@ -258,13 +295,13 @@ ClientRequest::do_process(Ref<PG>& pg, crimson::osd::ObjectContextRef obc)
     return submitted.then_interruptible(
       [this, pg] {
         return with_blocking_future_interruptible<interruptor::condition>(
-            handle.enter(pp(*pg).wait_repop));
+            enter_stage(pp(*pg).wait_repop, stage_t::wait_repop));
     }).then_interruptible(
       [this, pg, all_completed=std::move(all_completed)]() mutable {
       return all_completed.safe_then_interruptible(
         [this, pg](MURef<MOSDOpReply> reply) {
         return with_blocking_future_interruptible<interruptor::condition>(
-            handle.enter(pp(*pg).send_reply)).then_interruptible(
+            enter_stage(pp(*pg).send_reply, stage_t::send_reply)).then_interruptible(
               [this, reply=std::move(reply)]() mutable{
               return conn->send(std::move(reply)).then([] {
                 return seastar::make_ready_future<seq_mode_t>(seq_mode_t::IN_ORDER);
@@ -49,6 +49,22 @@ public:
 
   static constexpr OperationTypeCode type = OperationTypeCode::client_request;
 
+  /// stages of ClientRequest, for accounting the time spent in each stage
+  enum class stage_t : uint8_t {
+    conn_await_map = 0,
+    conn_get_pg,
+    pg_await_map,
+    wait_for_active,
+    recover_missing,
+    get_obc,
+    process,
+    wait_repop,
+    send_reply,
+    max
+  };
+  static constexpr auto NUM_STAGES = static_cast<std::size_t>(stage_t::max);
+  static const char* get_stage_name(stage_t stage);
+
   ClientRequest(OSD &osd, crimson::net::ConnectionRef, Ref<MOSDOp> &&m);
   ~ClientRequest();
 
@@ -62,6 +78,15 @@ public:
 private:
   template <typename FuncT>
   interruptible_future<> with_sequencer(FuncT&& func);
+
+  /// enter the pipeline stage, the time spent since entering the previous
+  /// stage is accounted to the previous one
+  template <typename StageT>
+  blocking_future<> enter_stage(StageT &stage, stage_t stage_id);
+  void account_stage(stage_t next_stage);
+  stage_t current_stage = stage_t::max;
+  std::chrono::steady_clock::time_point stage_start_time;
+
   auto reply_op_error(Ref<PG>& pg, int err);
 
   enum class seq_mode_t {
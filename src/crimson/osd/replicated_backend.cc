@@ -5,6 +5,7 @@
 
 #include "messages/MOSDRepOpReply.h"
 
+#include "crimson/common/config_proxy.h"
 #include "crimson/common/exception.h"
 #include "crimson/common/log.h"
 #include "crimson/os/futurized_store.h"
@@ -24,7 +25,11 @@ ReplicatedBackend::ReplicatedBackend(pg_t pgid,
   : PGBackend{whoami.shard, coll, &shard_services.get_store()},
     pgid{pgid},
     whoami{whoami},
-    shard_services{shard_services}
+    shard_services{shard_services},
+    txn_batcher{[this](ceph::os::Transaction&& txn) {
+      return this->shard_services.get_store().do_transaction(
+	this->coll, std::move(txn));
+    }}
 {}
 
 ReplicatedBackend::ll_read_ierrorator::future<ceph::bufferlist>
@@ -62,7 +67,9 @@ ReplicatedBackend::_submit_transaction(std::set<pg_shard_t>&& pg_shards,
 
   logger().debug("ReplicatedBackend::_submit_transaction: do_transaction...");
   auto all_completed = interruptor::make_interruptible(
-      shard_services.get_store().do_transaction(coll, std::move(txn)))
+      txn_batcher.add(hoid, std::move(txn),
+	crimson::common::local_conf().get_val<uint64_t>(
+	  "crimson_osd_txn_batch_max")))
   .then_interruptible([this, peers=pending_txn->second.weak_from_this()] {
     if (!peers) {
       // for now, only actingset_changed can cause peers
@@ -146,7 +153,8 @@ seastar::future<> ReplicatedBackend::stop()
 	crimson::common::system_shutdown_exception());
   }
   pending_trans.clear();
-  return seastar::now();
+  // the batched transactions are still committed
+  return txn_batcher.stop();
 }
 
 seastar::future<>
@@ -5,12 +5,14 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <seastar/core/future.hh>
+#include <seastar/core/shared_future.hh>
 #include <seastar/core/weak_ptr.hh>
 #include "include/buffer_fwd.h"
 #include "osd/osd_types.h"
 
 #include "acked_peers.h"
 #include "pg_backend.h"
+#include "txn_batcher.h"
 
 namespace crimson::osd {
   class ShardServices;
@@ -57,6 +59,10 @@ private:
   using pending_transactions_t = std::map<ceph_tid_t, pending_on_t>;
   pending_transactions_t pending_trans;
 
+  /// the local transactions of the client writes, see
+  /// crimson_osd_txn_batch_max
+  crimson::osd::TxnBatcher txn_batcher;
+
   seastar::future<> request_committed(
     const osd_reqid_t& reqid, const eversion_t& at_version) final;
 };
@@ -0,0 +1,76 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "txn_batcher.h"
+
+#include <seastar/core/later.hh>
+
+#include "crimson/common/log.h"
+
+namespace {
+  seastar::logger& logger() {
+    return crimson::get_logger(ceph_subsys_osd);
+  }
+}
+
+namespace crimson::osd {
+
+seastar::future<> TxnBatcher::add(const hobject_t& hoid,
+				  ceph::os::Transaction&& txn,
+				  uint64_t batch_max)
+{
+  if (batch && batch->objects.count(hoid)) {
+    flush();
+  }
+  if (!batch) {
+    batch = std::make_unique<batch_t>(next_seq++);
+    if (batch_max > 1) {
+      // give the ops which are ready to run in this reactor task a chance
+      // to join the batch
+      (void)seastar::with_gate(gate, [this, seq=batch->seq] {
+	return seastar::later().then([this, seq] {
+	  if (batch && batch->seq == seq) {
+	    flush();
+	  }
+	});
+      });
+    }
+  }
+  if (batch->objects.empty()) {
+    batch->txn = std::move(txn);
+  } else {
+    batch->txn.append(txn);
+  }
+  batch->objects.insert(hoid);
+  auto committed = batch->committed.get_shared_future();
+  if (batch->objects.size() >= batch_max) {
+    flush();
+  }
+  return committed;
+}
+
+void TxnBatcher::flush()
+{
+  logger().debug("TxnBatcher::{}: {} objects", __func__, batch->objects.size());
+  (void)seastar::with_gate(gate, [this, batch=std::move(batch)]() mutable {
+    auto txn = std::move(batch->txn);
+    return do_transaction(std::move(txn)).then_wrapped(
+      [batch=std::move(batch)](auto&& f) {
+      if (f.failed()) {
+	batch->committed.set_exception(f.get_exception());
+      } else {
+	batch->committed.set_value();
+      }
+    });
+  });
+}
+
+seastar::future<> TxnBatcher::stop()
+{
+  if (batch) {
+    flush();
+  }
+  return gate.close();
+}
+
+}
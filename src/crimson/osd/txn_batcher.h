@@ -0,0 +1,61 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/shared_future.hh>
+
+#include "common/hobject.h"
+#include "os/Transaction.h"
+
+namespace crimson::osd {
+
+/// combines the local transactions of the client writes of a PG which are
+/// submitted in the same reactor task into one store transaction.
+///
+/// only the writes to distinct objects are combined: a second write to an
+/// object of the pending batch flushes the batch first, so the writes to an
+/// object are still committed in order. a failed store transaction fails
+/// all the writes of its batch.
+class TxnBatcher {
+public:
+  using do_transaction_t =
+    std::function<seastar::future<>(ceph::os::Transaction&&)>;
+  explicit TxnBatcher(do_transaction_t&& do_transaction)
+    : do_transaction{std::move(do_transaction)}
+  {}
+
+  /// add @p txn to the pending batch, and return the future of its commit.
+  /// the batch is submitted once it holds @p batch_max objects, or once
+  /// the current task yields. with batch_max == 1, @p txn is submitted
+  /// right away.
+  seastar::future<> add(const hobject_t& hoid,
+			ceph::os::Transaction&& txn,
+			uint64_t batch_max);
+  /// submit the pending batch, and wait until the store is done with all of
+  /// them
+  seastar::future<> stop();
+
+private:
+  struct batch_t {
+    const uint64_t seq;
+    ceph::os::Transaction txn;
+    std::set<hobject_t> objects;
+    seastar::shared_promise<> committed;
+    explicit batch_t(uint64_t seq) : seq{seq} {}
+  };
+  do_transaction_t do_transaction;
+  std::unique_ptr<batch_t> batch;
+  uint64_t next_seq = 0;
+  /// covers the deferred flushes and the store transactions in flight
+  seastar::gate gate;
+
+  void flush();
+};
+
+}
@@ -119,6 +119,32 @@ struct error_code;
   /// enable/disable tracking of cached crcs
   void track_cached_crc(bool b);
 
+  /// the allocations of a NUMA node pool, see enable_numa_pools()
+  struct numa_pool_stats_t {
+    uint64_t allocs = 0;          ///< buffers allocated from the pool
+    uint64_t alloc_bytes = 0;     ///< bytes allocated from the pool
+    uint64_t fallbacks = 0;       ///< buffers the pool could not serve
+    uint64_t in_use_bytes = 0;    ///< bytes of the buffers still in use
+    uint64_t mapped_bytes = 0;    ///< bytes mapped for the pool
+    uint64_t huge_page_bytes = 0; ///< of which backed by hugetlb pages
+  };
+  /**
+   * Allocate the page aligned buffers of up to 1 MiB from pools local to
+   * the NUMA node of the allocating cpu.
+   *
+   * @param cpu_nodes the NUMA node of each cpu
+   * @param max_bytes the most memory mapped for the pool of each node
+   * @param huge_pages back the pools with hugetlb pages when there are
+   *        some, instead of transparent huge pages
+   *
+   * Can only be called once. The memory of the pools is never unmapped.
+   */
+  int enable_numa_pools(const std::vector<int>& cpu_nodes,
+			uint64_t max_bytes, bool huge_pages);
+  /// the number of NUMA node pools, 0 if they are not enabled
+  int get_num_numa_pools();
+  numa_pool_stats_t get_numa_pool_stats(int node);
+
   /*
    * an abstract raw buffer.  with a reference count.
    */
@@ -132,6 +158,7 @@ struct error_code;
   class raw_unshareable; // diagnostic, unshareable char buffer
   class raw_combined;
   class raw_claim_buffer;
+  class raw_numa_pooled;
 
 
   /*
@@ -135,6 +135,16 @@ You can also interrogate a specific pool programmatically with
 
 The runtime complexity is O(num_shards).
 
+Each thread batches its allocations and deallocations in a thread
+local cache, and only adds them to the shards of the pool once the
+cached delta of that pool exceeds flush_bytes or flush_items, or when
+the thread exits.  The figures above are exact for the calling thread,
+but may miss up to that much of the recent activity of every other
+thread.  request_thread_cache_flush() makes every thread flush its
+cache the next time it accounts for an allocation; dump() and the
+periodic users of the totals call it.  Thread pools flush the cache of
+their workers before they go idle.
+
 Note that you cannot easily query per-type, primarily because debug
 mode is optional and you should not rely on that information being
 available.
@@ -219,6 +229,13 @@ struct shard_t {
 
 static_assert(sizeof(shard_t) == 128, "shard_t should be cacheline-sized");
 
+// a thread flushes its cached delta of a pool to a shard once it grows
+// past either of these
+enum {
+  flush_bytes = 64 << 10,
+  flush_items = 1024
+};
+
 struct stats_t {
   ssize_t items = 0;
   ssize_t bytes = 0;
@@ -262,7 +279,11 @@ public:
   size_t allocated_bytes() const;
   size_t allocated_items() const;
 
+  // account for an allocation (or a deallocation, if negative) in the
+  // cache of the calling thread
   void adjust_count(ssize_t items, ssize_t bytes);
+  // add the cached delta of the calling thread to the shards
+  void flush_thread_cache();
 
   static size_t pick_a_shard_int() {
     // Dirt cheap, see:
@@ -294,10 +315,20 @@ public:
 		 std::map<std::string, stats_t> *by_type) const;
 
   void dump(ceph::Formatter *f, stats_t *ptotal=0) const;
+
+private:
+  // sum up the shards and the cache of the calling thread
+  stats_t _get_total() const;
 };
 
 void dump(ceph::Formatter *f);
 
+// add the counts cached by the calling thread to the shards
+void flush_thread_cache();
+// have every thread flush its cache the next time it accounts for an
+// allocation
+void request_thread_cache_flush();
+
 
 // STL allocator for use with containers.  All actual state
 // is stored in the static pool_allocator_base_t, which saves us from
@@ -339,9 +370,7 @@ public:
 
   T* allocate(size_t n, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes += total;
-    shard->items += n;
+    pool->adjust_count(n, total);
     if (type) {
       type->items += n;
     }
@@ -351,9 +380,7 @@ public:
 
   void deallocate(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes -= total;
-    shard->items -= n;
+    pool->adjust_count(-(ssize_t)n, -(ssize_t)total);
     if (type) {
       type->items -= n;
     }
@@ -362,9 +389,7 @@ public:
 
   T* allocate_aligned(size_t n, size_t align, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes += total;
-    shard->items += n;
+    pool->adjust_count(n, total);
     if (type) {
       type->items += n;
     }
@@ -378,9 +403,7 @@ public:
 
   void deallocate_aligned(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes -= total;
-    shard->items -= n;
+    pool->adjust_count(-(ssize_t)n, -(ssize_t)total);
     if (type) {
       type->items -= n;
     }
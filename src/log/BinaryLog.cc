@@ -0,0 +1,529 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "BinaryLog.h"
+
+#include "common/errno.h"
+#include "common/safe_io.h"
+#include "include/compat.h"
+#include "include/crc32c.h"
+#include "include/intarith.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <new>
+
+#include <fmt/format.h>
+
+namespace ceph {
+namespace logging {
+
+namespace {
+
+struct format_registry_t {
+  std::mutex lock;
+  std::vector<const char*> formats;
+};
+
+format_registry_t& format_registry()
+{
+  static format_registry_t registry;
+  return registry;
+}
+
+uint32_t register_format(const char* fmt)
+{
+  auto& registry = format_registry();
+  std::scoped_lock l(registry.lock);
+  registry.formats.push_back(fmt);
+  return registry.formats.size() - 1;
+}
+
+const char* get_format(uint32_t id)
+{
+  auto& registry = format_registry();
+  std::scoped_lock l(registry.lock);
+  return id < registry.formats.size() ? registry.formats[id] : nullptr;
+}
+
+constexpr char BINARY_LOG_MAGIC[8] = {'c', 'e', 'p', 'h', 'b', 'l', 'o', 'g'};
+constexpr uint32_t BINARY_LOG_VERSION = 1;
+constexpr uint64_t RECORD_ALIGN = 8;
+
+/// the record of an entry in the ring, followed by its arguments
+struct record_t {
+  uint64_t pos;     ///< offset of the record in the ring, stored last
+  uint32_t len;     ///< with the arguments, without the padding
+  uint32_t format;
+  uint64_t stamp;   ///< ns since the epoch, or'ed with STAMP_COARSE
+  uint64_t thread;
+  int16_t prio;
+  uint16_t subsys;
+  uint32_t crc;     ///< of the fields from len on, and of the arguments
+};
+static_assert(sizeof(record_t) % RECORD_ALIGN == 0);
+
+constexpr uint64_t STAMP_COARSE = 1ull << 63;
+
+uint32_t record_crc(const record_t& rec, std::string_view args)
+{
+  static_assert(offsetof(record_t, crc) + sizeof(record_t::crc) == sizeof(record_t));
+  auto p = reinterpret_cast<const unsigned char*>(&rec.len);
+  uint32_t crc = ceph_crc32c(-1, p, offsetof(record_t, crc) - offsetof(record_t, len));
+  return ceph_crc32c(crc, reinterpret_cast<const unsigned char*>(args.data()),
+		     args.size());
+}
+
+/// a format string in the format table
+struct format_record_t {
+  uint32_t id;
+  uint32_t len;
+};
+
+}
+
+namespace binary {
+
+/// the header of the file, followed by the format table and the ring
+struct file_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t formats_size;
+  uint64_t ring_size;
+  uint64_t formats_used;  ///< bytes of the format table in use
+  std::atomic<uint64_t> head;  ///< offset of the next record in the ring
+};
+
+}
+
+BinaryFormat::BinaryFormat(const char* fmt)
+  : fmt(fmt),
+    id(register_format(fmt))
+{}
+
+namespace binary {
+
+namespace {
+
+struct arg_value_t {
+  arg_t type;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+  };
+  std::string_view s;
+};
+using arg_values_t = boost::container::small_vector<arg_value_t, 8>;
+
+template <typename T>
+bool take_raw(std::string_view& args, T* v)
+{
+  if (args.size() < sizeof(T)) {
+    return false;
+  }
+  memcpy(v, args.data(), sizeof(T));
+  args.remove_prefix(sizeof(T));
+  return true;
+}
+
+bool decode_args(std::string_view args, arg_values_t* values)
+{
+  while (!args.empty()) {
+    arg_value_t v;
+    v.type = static_cast<arg_t>(args[0]);
+    args.remove_prefix(1);
+    switch (v.type) {
+    case arg_t::SIGNED:
+      if (!take_raw(args, &v.i)) {
+	return false;
+      }
+      break;
+    case arg_t::UNSIGNED:
+    case arg_t::POINTER:
+      if (!take_raw(args, &v.u)) {
+	return false;
+      }
+      break;
+    case arg_t::DOUBLE:
+      if (!take_raw(args, &v.d)) {
+	return false;
+      }
+      break;
+    case arg_t::BOOL:
+    case arg_t::CHAR:
+      {
+	char c;
+	if (!take_raw(args, &c)) {
+	  return false;
+	}
+	v.i = c;
+      }
+      break;
+    case arg_t::STRING:
+      {
+	uint32_t len;
+	if (!take_raw(args, &len) || args.size() < len) {
+	  return false;
+	}
+	v.s = args.substr(0, len);
+	args.remove_prefix(len);
+      }
+      break;
+    default:
+      return false;
+    }
+    values->push_back(v);
+  }
+  return true;
+}
+
+template <typename T>
+std::string format_one(const std::string& spec, T v)
+{
+  return fmt::vformat(spec, fmt::make_format_args(v));
+}
+
+std::string format_arg(const std::string& spec, const arg_value_t& v)
+{
+  switch (v.type) {
+  case arg_t::SIGNED:
+    return format_one(spec, v.i);
+  case arg_t::UNSIGNED:
+    return format_one(spec, v.u);
+  case arg_t::DOUBLE:
+    return format_one(spec, v.d);
+  case arg_t::BOOL:
+    return format_one(spec, v.i != 0);
+  case arg_t::CHAR:
+    return format_one(spec, static_cast<char>(v.i));
+  case arg_t::STRING:
+    return format_one(spec, v.s);
+  case arg_t::POINTER:
+    return format_one(spec, reinterpret_cast<const void*>(
+			static_cast<uintptr_t>(v.u)));
+  }
+  return {};
+}
+
+}
+
+void render(std::ostream& out, std::string_view fmt, std::string_view args)
+{
+  arg_values_t values;
+  if (!decode_args(args, &values)) {
+    out << fmt << " <bad arguments>";
+    return;
+  }
+  std::size_t next_arg = 0;
+  while (!fmt.empty()) {
+    auto i = fmt.find_first_of("{}");
+    out << fmt.substr(0, i);
+    if (i == fmt.npos) {
+      break;
+    }
+    char c = fmt[i];
+    fmt.remove_prefix(i + 1);
+    // "{{" and "}}" are escaped braces
+    if (c == '}' || (!fmt.empty() && fmt[0] == '{')) {
+      out << c;
+      if (!fmt.empty() && fmt[0] == c) {
+	fmt.remove_prefix(1);
+      }
+      continue;
+    }
+    auto end = fmt.find('}');
+    if (end == fmt.npos) {
+      out << c << fmt;
+      break;
+    }
+    // "[index][:spec]"
+    auto field = fmt.substr(0, end);
+    fmt.remove_prefix(end + 1);
+    auto colon = field.find(':');
+    auto index = field.substr(0, colon);
+    std::size_t n = 0;
+    if (index.empty()) {
+      n = next_arg++;
+    } else {
+      for (auto d : index) {
+	if (d < '0' || d > '9') {
+	  n = values.size();
+	  break;
+	}
+	n = n * 10 + (d - '0');
+      }
+    }
+    if (n >= values.size()) {
+      out << '{' << field << '}';
+      continue;
+    }
+    std::string spec = "{";
+    if (colon != field.npos) {
+      spec.append(field.substr(colon));
+    }
+    spec.push_back('}');
+    try {
+      out << format_arg(spec, values[n]);
+    } catch (const fmt::format_error&) {
+      out << '{' << field << '}';
+    }
+  }
+}
+
+}
+
+BinaryLog::~BinaryLog()
+{
+  if (m_base) {
+    ::munmap(m_base, m_size);
+  }
+}
+
+int BinaryLog::open(const std::string& path, std::size_t size)
+{
+  ceph_assert(!m_base);
+  size = p2align<std::size_t>(std::max(size, MIN_SIZE), RECORD_ALIGN);
+
+  // keep the entries of the previous run around, it might have crashed
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0 && st.st_size > 0) {
+    std::string old = path + ".old";
+    if (::rename(path.c_str(), old.c_str()) < 0) {
+      return -errno;
+    }
+  }
+  int fd = ::open(path.c_str(), O_CREAT|O_TRUNC|O_RDWR|O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -errno;
+  }
+  int r = 0;
+  if (::ftruncate(fd, size) < 0) {
+    r = -errno;
+    VOID_TEMP_FAILURE_RETRY(::close(fd));
+    return r;
+  }
+  void* p = ::mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    r = -errno;
+  }
+  // the mapping keeps the file open
+  VOID_TEMP_FAILURE_RETRY(::close(fd));
+  if (r < 0) {
+    return r;
+  }
+
+  m_path = path;
+  m_base = static_cast<char*>(p);
+  m_size = size;
+  std::size_t header_size =
+    p2roundup<std::size_t>(sizeof(binary::file_header_t), RECORD_ALIGN);
+  m_formats = m_base + header_size;
+  m_ring = m_formats + FORMATS_SIZE;
+  m_ring_size = size - header_size - FORMATS_SIZE;
+
+  m_header = new (m_base) binary::file_header_t;
+  m_header->version = BINARY_LOG_VERSION;
+  m_header->header_size = header_size;
+  m_header->formats_size = FORMATS_SIZE;
+  m_header->ring_size = m_ring_size;
+  m_header->formats_used = 0;
+  m_header->head = 0;
+  // written last, so a partially initialized file is not taken for a log
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(m_header->magic, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+  return 0;
+}
+
+bool BinaryLog::_add_formats(uint32_t id)
+{
+  std::scoped_lock l(m_formats_lock);
+  // the formats are stored in the order of their ids
+  for (uint32_t i = m_num_formats; i <= id; i++) {
+    const char* fmt = get_format(i);
+    ceph_assert(fmt);
+    format_record_t rec{i, static_cast<uint32_t>(strlen(fmt))};
+    auto used = m_header->formats_used;
+    if (used + sizeof(rec) + rec.len > FORMATS_SIZE) {
+      return false;
+    }
+    memcpy(m_formats + used, &rec, sizeof(rec));
+    memcpy(m_formats + used + sizeof(rec), fmt, rec.len);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->formats_used = used + sizeof(rec) + rec.len;
+    m_num_formats.store(i + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+void BinaryLog::_write(uint64_t pos, const void* p, std::size_t len)
+{
+  auto off = pos % m_ring_size;
+  auto first = std::min<std::size_t>(len, m_ring_size - off);
+  memcpy(m_ring + off, p, first);
+  if (first < len) {
+    memcpy(m_ring, static_cast<const char*>(p) + first, len - first);
+  }
+}
+
+bool BinaryLog::submit(log_time stamp, short prio, short subsys,
+		       const BinaryFormat& f, std::string_view args)
+{
+  if (f.id >= m_num_formats.load(std::memory_order_acquire) &&
+      !_add_formats(f.id)) {
+    return false;
+  }
+  uint64_t len = sizeof(record_t) + args.size();
+  uint64_t padded = p2roundup<uint64_t>(len, RECORD_ALIGN);
+  if (padded > m_ring_size / 2) {
+    return false;
+  }
+  auto rep = stamp.time_since_epoch().count();
+  record_t rec;
+  rec.len = len;
+  rec.format = f.id;
+  rec.stamp = rep.count | (rep.coarse ? STAMP_COARSE : 0);
+  rec.thread = (unsigned long)pthread_self();
+  rec.prio = prio;
+  rec.subsys = subsys;
+  rec.crc = record_crc(rec, args);
+  // a writer lapped by the others overwrites newer records, the crc tells
+  // the decoder about them. keep the window short.
+  uint64_t pos = m_header->head.fetch_add(padded, std::memory_order_relaxed);
+  // invalid until the whole record is written
+  rec.pos = ~pos;
+  _write(pos, &rec, sizeof(rec));
+  _write(pos + sizeof(rec), args.data(), args.size());
+  std::atomic_thread_fence(std::memory_order_release);
+  // records are aligned, so pos is never split by the end of the ring
+  memcpy(m_ring + pos % m_ring_size, &pos, sizeof(pos));
+  return true;
+}
+
+int read_binary_log(const std::string& path,
+		    std::vector<BinaryLogEntry>* entries,
+		    std::ostream* err)
+{
+  int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+  if (fd < 0) {
+    int r = -errno;
+    *err << "failed to open " << path << ": " << cpp_strerror(r);
+    return r;
+  }
+  std::string buf;
+  {
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+      int r = -errno;
+      VOID_TEMP_FAILURE_RETRY(::close(fd));
+      *err << "failed to stat " << path << ": " << cpp_strerror(r);
+      return r;
+    }
+    buf.resize(st.st_size);
+    auto r = safe_read_exact(fd, buf.data(), buf.size());
+    VOID_TEMP_FAILURE_RETRY(::close(fd));
+    if (r < 0) {
+      *err << "failed to read " << path << ": " << cpp_strerror(r);
+      return r;
+    }
+  }
+
+  if (buf.size() < sizeof(binary::file_header_t)) {
+    *err << path << " is not a binary log";
+    return -EINVAL;
+  }
+  auto& header = *reinterpret_cast<const binary::file_header_t*>(buf.data());
+  if (memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0) {
+    *err << path << " is not a binary log";
+    return -EINVAL;
+  }
+  if (header.version != BINARY_LOG_VERSION) {
+    *err << path << " has unsupported version " << header.version;
+    return -EINVAL;
+  }
+  if (header.header_size + header.formats_size + header.ring_size > buf.size() ||
+      header.formats_used > header.formats_size ||
+      header.ring_size % RECORD_ALIGN != 0) {
+    *err << path << " is truncated or corrupted";
+    return -EINVAL;
+  }
+  std::string_view formats(buf.data() + header.header_size,
+			   header.formats_used);
+  std::string_view ring(buf.data() + header.header_size + header.formats_size,
+			header.ring_size);
+
+  std::map<uint32_t, std::string_view> fmts;
+  while (formats.size() >= sizeof(format_record_t)) {
+    format_record_t rec;
+    memcpy(&rec, formats.data(), sizeof(rec));
+    formats.remove_prefix(sizeof(rec));
+    if (rec.len > formats.size()) {
+      break;
+    }
+    fmts[rec.id] = formats.substr(0, rec.len);
+    formats.remove_prefix(rec.len);
+  }
+
+  auto read = [&ring](uint64_t pos, void* p, std::size_t len) {
+    auto off = pos % ring.size();
+    auto first = std::min<std::size_t>(len, ring.size() - off);
+    memcpy(p, ring.data() + off, first);
+    if (first < len) {
+      memcpy(static_cast<char*>(p) + first, ring.data(), len - first);
+    }
+  };
+
+  // the oldest records have been overwritten, and the ones being written
+  // when the file was read are not complete. skip to the next valid record
+  // when we find one of them.
+  uint64_t head = header.head.load();
+  uint64_t pos = head > ring.size() ? head - ring.size() : 0;
+  std::string args;
+  while (pos + sizeof(record_t) <= head) {
+    record_t rec;
+    read(pos, &rec, sizeof(rec));
+    auto fmt = fmts.find(rec.format);
+    if (rec.pos != pos ||
+	rec.len < sizeof(rec) ||
+	pos + rec.len > head ||
+	fmt == fmts.end()) {
+      pos += RECORD_ALIGN;
+      continue;
+    }
+    args.resize(rec.len - sizeof(rec));
+    read(pos + sizeof(rec), args.data(), args.size());
+    if (record_crc(rec, args) != rec.crc) {
+      pos += RECORD_ALIGN;
+      continue;
+    }
+
+    CachedStackStringStream css;
+    binary::render(*css, fmt->second, args);
+    entries->push_back(BinaryLogEntry{
+	log_time(log_clock::duration(_logclock::taggedrep(
+	  rec.stamp & ~STAMP_COARSE, rec.stamp & STAMP_COARSE))),
+	rec.thread,
+	rec.prio,
+	static_cast<short>(rec.subsys),
+	std::string(css->strv())});
+    pos += p2roundup<uint64_t>(rec.len, RECORD_ALIGN);
+  }
+  // the threads reserve their records in about the order of their stamps
+  std::stable_sort(entries->begin(), entries->end(),
+		   [](const auto& lhs, const auto& rhs) {
+		     return lhs.stamp < rhs.stamp;
+		   });
+  return 0;
+}
+
+}
+}
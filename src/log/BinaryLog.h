@@ -0,0 +1,178 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_LOG_BINARYLOG_H
+#define CEPH_LOG_BINARYLOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "boost/container/small_vector.hpp"
+
+#include "common/StackStringStream.h"
+#include "log/LogClock.h"
+
+namespace ceph {
+namespace logging {
+
+/**
+ * The format string of an ldout_bin() call site.
+ *
+ * It is registered once per process. The binary logs store each format
+ * string once, and refer to it from the entries by its id.
+ */
+class BinaryFormat {
+public:
+  explicit BinaryFormat(const char* fmt);
+  BinaryFormat(const BinaryFormat&) = delete;
+  BinaryFormat& operator=(const BinaryFormat&) = delete;
+
+  const char* const fmt;
+  const uint32_t id;
+};
+
+namespace binary {
+
+enum class arg_t : uint8_t {
+  SIGNED = 1,
+  UNSIGNED,
+  DOUBLE,
+  BOOL,
+  CHAR,
+  STRING,
+  POINTER,
+};
+
+using arg_buffer_t = boost::container::small_vector<char, 256>;
+
+template <typename T>
+void append_raw(arg_buffer_t& buf, const T& v) {
+  auto p = reinterpret_cast<const char*>(&v);
+  buf.insert(buf.end(), p, p + sizeof(v));
+}
+
+inline void append_string(arg_buffer_t& buf, std::string_view s) {
+  buf.push_back(static_cast<char>(arg_t::STRING));
+  append_raw(buf, static_cast<uint32_t>(s.size()));
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+/// encode an argument along with its type. the arguments which are not
+/// numbers, strings or pointers are streamed into a string.
+template <typename T>
+void append_arg(arg_buffer_t& buf, const T& v) {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    buf.push_back(static_cast<char>(arg_t::BOOL));
+    buf.push_back(v ? 1 : 0);
+  } else if constexpr (std::is_same_v<U, char>) {
+    buf.push_back(static_cast<char>(arg_t::CHAR));
+    buf.push_back(v);
+  } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+    buf.push_back(static_cast<char>(arg_t::SIGNED));
+    append_raw(buf, static_cast<int64_t>(v));
+  } else if constexpr (std::is_integral_v<U>) {
+    buf.push_back(static_cast<char>(arg_t::UNSIGNED));
+    append_raw(buf, static_cast<uint64_t>(v));
+  } else if constexpr (std::is_floating_point_v<U>) {
+    buf.push_back(static_cast<char>(arg_t::DOUBLE));
+    append_raw(buf, static_cast<double>(v));
+  } else if constexpr (std::is_same_v<U, const char*> ||
+		       std::is_same_v<U, char*>) {
+    append_string(buf, v ? std::string_view(v) : std::string_view("(null)"));
+  } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    append_string(buf, std::string_view(v));
+  } else if constexpr (std::is_pointer_v<U>) {
+    buf.push_back(static_cast<char>(arg_t::POINTER));
+    append_raw(buf, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v)));
+  } else {
+    CachedStackStringStream css;
+    *css << v;
+    append_string(buf, css->strv());
+  }
+}
+
+/**
+ * Format the encoded arguments like fmt::format() would.
+ *
+ * The replacement fields may have an argument index and a format spec, but
+ * nested replacement fields are not supported.
+ */
+void render(std::ostream& out, std::string_view fmt, std::string_view args);
+
+struct file_header_t;
+
+}
+
+/**
+ * A binary log, kept in a ring file mapped in memory.
+ *
+ * The entries record the id of their format string and their arguments,
+ * they are only formatted when the file is decoded. Submitting an entry
+ * takes no lock, the threads reserve their room in the ring by bumping its
+ * head. As the file is shared with the kernel, the entries are not lost if
+ * the process crashes.
+ */
+class BinaryLog {
+public:
+  static constexpr std::size_t FORMATS_SIZE = 1 << 20;
+  static constexpr std::size_t MIN_SIZE = 2 * FORMATS_SIZE;
+
+  BinaryLog() = default;
+  BinaryLog(const BinaryLog&) = delete;
+  BinaryLog& operator=(const BinaryLog&) = delete;
+  ~BinaryLog();
+
+  /// create the log file, any previous one is renamed to <path>.old
+  int open(const std::string& path, std::size_t size);
+
+  const std::string& get_path() const {
+    return m_path;
+  }
+
+  /// false if the entry could not be recorded
+  bool submit(log_time stamp, short prio, short subsys,
+	      const BinaryFormat& f, std::string_view args);
+
+private:
+  std::string m_path;
+  char* m_base = nullptr;
+  std::size_t m_size = 0;
+  binary::file_header_t* m_header = nullptr;
+  char* m_formats = nullptr;
+  char* m_ring = nullptr;
+  std::size_t m_ring_size = 0;
+
+  /// the formats with a smaller id are stored in the file
+  std::atomic<uint32_t> m_num_formats = {0};
+  std::mutex m_formats_lock;
+
+  bool _add_formats(uint32_t id);
+  void _write(uint64_t pos, const void* p, std::size_t len);
+};
+
+/// an entry decoded from a binary log
+struct BinaryLogEntry {
+  log_time stamp;
+  uint64_t thread;
+  short prio;
+  short subsys;
+  std::string message;
+};
+
+/// decode the entries of a binary log file, oldest first
+int read_binary_log(const std::string& path,
+		    std::vector<BinaryLogEntry>* entries,
+		    std::ostream* err);
+
+}
+}
+
+#endif
@@ -22,8 +22,12 @@
 #include <fcntl.h>
 #include <syslog.h>
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <numeric>
 #include <set>
+#include <thread>
 
 #include <fmt/format.h>
 
@@ -34,6 +38,27 @@ namespace logging {
 
 static OnExitManager exit_callbacks;
 
+static std::atomic<uint64_t> next_log_id = {0};
+
+namespace {
+/// the entry queues of the calling thread, one per log it submitted to
+struct ThreadEntryQueues {
+  std::vector<std::pair<uint64_t, std::shared_ptr<ThreadEntryQueue>>> queues;
+  ~ThreadEntryQueues();
+};
+thread_local ThreadEntryQueues thread_entry_queues;
+// still usable while the thread_locals are being destroyed
+thread_local bool thread_entry_queues_destroyed = false;
+
+ThreadEntryQueues::~ThreadEntryQueues()
+{
+  thread_entry_queues_destroyed = true;
+  for (auto& [log_id, q] : queues) {
+    q->m_exited = true;
+  }
+}
+}
+
 static void log_on_exit(void *p)
 {
   Log *l = *(Log **)p;
@@ -45,6 +70,7 @@ static void log_on_exit(void *p)
 Log::Log(const SubsystemMap *s)
   : m_indirect_this(nullptr),
     m_subs(s),
+    m_id(next_log_id++),
     m_recent(DEFAULT_MAX_RECENT)
 {
   m_log_buf.reserve(MAX_LOG_BUF);
@@ -96,6 +122,12 @@ void Log::set_max_recent(std::size_t n)
   m_max_recent = n;
 }
 
+void Log::set_drop_on_full(bool drop)
+{
+  std::scoped_lock lock(m_queue_mutex);
+  m_drop_on_full = drop;
+}
+
 void Log::set_log_file(std::string_view fn)
 {
   std::scoped_lock lock(m_flush_mutex);
@@ -108,6 +140,45 @@ void Log::set_log_stderr_prefix(std::string_view p)
   m_log_stderr_prefix = p;
 }
 
+int Log::set_binary_log(const std::string& path, std::size_t size)
+{
+  std::scoped_lock lock(m_flush_mutex);
+  auto current = m_binary.load();
+  if (current && current->get_path() == path) {
+    return 0;
+  }
+  if (path.empty()) {
+    m_binary = nullptr;
+    _retire_binary_log();
+    m_binary_log.reset();
+    return 0;
+  }
+  auto binary = std::make_unique<BinaryLog>();
+  int r = binary->open(path, size);
+  if (r < 0) {
+    std::cerr << "failed to open binary log " << path << ": "
+	      << cpp_strerror(r) << std::endl;
+    return r;
+  }
+  m_binary = binary.get();
+  _retire_binary_log();
+  m_binary_log = std::move(binary);
+  return 0;
+}
+
+// wait for the submitters which might still use the log m_binary pointed
+// to before it was changed. flip the generation twice so the new
+// submitters count in the other slot while we wait for each of them.
+void Log::_retire_binary_log()
+{
+  for (int i = 0; i < 2; i++) {
+    unsigned gen = m_binary_gen.fetch_add(1);
+    while (m_binary_users[gen & 1].load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
 void Log::reopen_log_file()
 {
   std::scoped_lock lock(m_flush_mutex);
@@ -205,18 +276,113 @@ void Log::stop_journald_logger()
   m_journald.reset();
 }
 
-void Log::submit_entry(Entry&& e)
+ThreadEntryQueue* Log::_get_thread_queue()
 {
-  std::unique_lock lock(m_queue_mutex);
-  m_queue_mutex_holder = pthread_self();
+  if (unlikely(thread_entry_queues_destroyed)) {
+    return nullptr;
+  }
+  auto& queues = thread_entry_queues.queues;
+  for (auto& [log_id, q] : queues) {
+    if (log_id == m_id) {
+      return q.get();
+    }
+  }
+  // forget the queues of the logs which are gone
+  queues.erase(std::remove_if(queues.begin(), queues.end(),
+			      [](auto& p) { return p.second.use_count() == 1; }),
+	       queues.end());
+  auto q = std::make_shared<ThreadEntryQueue>(DEFAULT_THREAD_MAX_NEW);
+  {
+    std::scoped_lock lock(m_queue_mutex);
+    m_thread_queues.push_back(q);
+  }
+  queues.emplace_back(m_id, q);
+  return q.get();
+}
+
+bool Log::_has_new_entries() const
+{
+  return !m_new.empty() ||
+    std::any_of(m_thread_queues.begin(), m_thread_queues.end(),
+		[](auto& q) { return !q->empty(); });
+}
+
+void Log::_take_new_entries(EntryVector& t)
+{
+  assert(t.empty());
+  for (auto q = m_thread_queues.begin(); q != m_thread_queues.end(); ) {
+    // check before draining, the thread does not add more once exited
+    bool exited = (*q)->m_exited;
+    (*q)->drain([&t](ConcreteEntry&& e) {
+      t.emplace_back(std::move(e));
+    });
+    if (exited) {
+      q = m_thread_queues.erase(q);
+    } else {
+      ++q;
+    }
+  }
+  // a thread only adds to m_new when its queue is full, so they follow
+  // the ones in its queue
+  std::move(m_new.begin(), m_new.end(), std::back_inserter(t));
+  m_new.clear();
+  // the entries of each thread are in order, interleave them. sort their
+  // indexes instead of the entries, which are expensive to move around.
+  auto by_stamp = [](const ConcreteEntry& lhs, const ConcreteEntry& rhs) {
+    return lhs.m_stamp < rhs.m_stamp;
+  };
+  if (!std::is_sorted(t.begin(), t.end(), by_stamp)) {
+    std::vector<std::size_t> order(t.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+      return by_stamp(t[lhs], t[rhs]);
+    });
+    EntryVector sorted;
+    sorted.reserve(t.size());
+    for (auto i : order) {
+      sorted.emplace_back(std::move(t[i]));
+    }
+    t.swap(sorted);
+  }
+}
 
+void Log::submit_entry(Entry&& e)
+{
   if (unlikely(m_inject_segv))
     *(volatile int *)(0) = 0xdead;
 
-  // wait for flush to catch up
-  while (is_started() &&
-	 m_new.size() > m_max_new) {
+  auto q = _get_thread_queue();
+  if (q && q->try_push(std::move(e))) {
+    if (m_flusher_waiting) {
+      std::scoped_lock lock(m_queue_mutex);
+      m_cond_flusher.notify_all();
+    }
+    return;
+  }
+
+  // the queue of this thread is full, or gone
+  std::unique_lock lock(m_queue_mutex);
+  m_queue_mutex_holder = pthread_self();
+
+  while (true) {
+    // the queues are drained along with m_new while holding the lock, so
+    // if there is room now, m_new has no entry of ours, and the order of
+    // our entries is kept
+    if (q && q->try_push(std::move(e))) {
+      m_cond_flusher.notify_all();
+      m_queue_mutex_holder = 0;
+      return;
+    }
+    // wait for flush to catch up
+    if (!is_started() || m_new.size() <= m_max_new) {
+      break;
+    }
     if (m_stop) break; // force addition
+    if (m_drop_on_full) {
+      m_dropped++;
+      m_queue_mutex_holder = 0;
+      return;
+    }
     m_cond_loggers.wait(lock);
   }
 
@@ -225,6 +391,24 @@ void Log::submit_entry(Entry&& e)
   m_queue_mutex_holder = 0;
 }
 
+void Log::submit_binary_entry(short prio, short subsys, const BinaryFormat& f,
+			      std::string_view args)
+{
+  if (m_subs->get_log_level(subsys) < prio) {
+    auto& users = m_binary_users[m_binary_gen.load() & 1];
+    users.fetch_add(1);
+    auto b = m_binary.load();
+    bool gathered = b && b->submit(Entry::clock().now(), prio, subsys, f, args);
+    users.fetch_sub(1, std::memory_order_release);
+    if (gathered) {
+      return;
+    }
+  }
+  MutableEntry e(prio, subsys);
+  binary::render(e.get_ostream(), f.fmt, args);
+  submit_entry(std::move(e));
+}
+
 void Log::flush()
 {
   std::scoped_lock lock1(m_flush_mutex);
@@ -233,13 +417,15 @@ void Log::flush()
   {
     std::scoped_lock lock2(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
+    _take_new_entries(m_flush);
     m_cond_loggers.notify_all();
     m_queue_mutex_holder = 0;
   }
 
   _flush(m_flush, false);
+  if (auto dropped = m_dropped.exchange(0); dropped > 0) {
+    _log_message(fmt::format("--- {} log entries dropped ---", dropped), false);
+  }
   m_flush_mutex_holder = 0;
 }
 
@@ -380,8 +566,7 @@ void Log::dump_recent()
   {
     std::scoped_lock lock2(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
+    _take_new_entries(m_flush);
     m_queue_mutex_holder = 0;
   }
 
@@ -423,6 +608,9 @@ void Log::dump_recent()
   _log_message(fmt::format("  max_recent {:9}", m_max_recent), true);
   _log_message(fmt::format("  max_new    {:9}", m_max_recent), true);
   _log_message(fmt::format("  log_file {}", m_log_file), true);
+  if (auto binary = m_binary.load(); binary) {
+    _log_message(fmt::format("  binary log_file {}", binary->get_path()), true);
+  }
 
   _log_message("--- end dump of recent events ---", true);
 
@@ -461,7 +649,7 @@ void *Log::entry()
     std::unique_lock lock(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
     while (!m_stop) {
-      if (!m_new.empty()) {
+      if (_has_new_entries()) {
         m_queue_mutex_holder = 0;
         lock.unlock();
         flush();
@@ -470,7 +658,13 @@ void *Log::entry()
         continue;
       }
 
-      m_cond_flusher.wait(lock);
+      // the submitters don't take the lock unless we are waiting, so check
+      // again after telling them
+      m_flusher_waiting = true;
+      if (!_has_new_entries()) {
+        m_cond_flusher.wait(lock);
+      }
+      m_flusher_waiting = false;
     }
     m_queue_mutex_holder = 0;
   }
@@ -6,16 +6,20 @@
 
 #include <boost/circular_buffer.hpp>
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "common/Thread.h"
 #include "common/likely.h"
 
+#include "log/BinaryLog.h"
 #include "log/Entry.h"
 
 struct uuid_d;
@@ -27,6 +31,52 @@ class Graylog;
 class JournaldLogger;
 class SubsystemMap;
 
+/**
+ * The entries submitted by a thread and not flushed yet.
+ *
+ * It is a ring written only by the submitting thread and read only by the
+ * thread flushing the log, so neither of them needs a lock.
+ */
+class ThreadEntryQueue {
+  std::vector<std::optional<ConcreteEntry>> m_slots;
+  std::atomic<std::size_t> m_head = {0}; ///< next slot to write
+  std::atomic<std::size_t> m_tail = {0}; ///< next slot to read
+
+public:
+  std::atomic<bool> m_exited = {false}; ///< the thread is gone
+
+  explicit ThreadEntryQueue(std::size_t size) : m_slots(size) {}
+
+  bool empty() const {
+    return m_head.load() == m_tail.load();
+  }
+
+  /// called by the submitting thread, false if the queue is full
+  bool try_push(Entry&& e) {
+    auto head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == m_slots.size()) {
+      return false;
+    }
+    m_slots[head % m_slots.size()].emplace(std::move(e));
+    // seq_cst, so the flusher either sees the entry or is seen sleeping
+    m_head.store(head + 1);
+    return true;
+  }
+
+  /// called by the flushing thread
+  template <typename Func>
+  void drain(Func&& f) {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    auto head = m_head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      auto& slot = m_slots[tail % m_slots.size()];
+      f(std::move(*slot));
+      slot.reset();
+    }
+    m_tail.store(tail, std::memory_order_release);
+  }
+};
+
 class Log : private Thread
 {
   using EntryRing = boost::circular_buffer<ConcreteEntry>;
@@ -34,10 +84,12 @@ class Log : private Thread
 
   static const std::size_t DEFAULT_MAX_NEW = 100;
   static const std::size_t DEFAULT_MAX_RECENT = 10000;
+  static const std::size_t DEFAULT_THREAD_MAX_NEW = 64;
 
   Log **m_indirect_this;
 
   const SubsystemMap *m_subs;
+  const uint64_t m_id; ///< tells the logs apart in the per-thread queues
 
   std::mutex m_queue_mutex;
   std::mutex m_flush_mutex;
@@ -47,10 +99,25 @@ class Log : private Thread
   pthread_t m_queue_mutex_holder;
   pthread_t m_flush_mutex_holder;
 
-  EntryVector m_new;    ///< new entries
+  EntryVector m_new;    ///< new entries, if the queue of their thread is full
+  std::vector<std::shared_ptr<ThreadEntryQueue>> m_thread_queues; ///< new entries
   EntryRing m_recent; ///< recent (less new) entries we've already written at low detail
   EntryVector m_flush; ///< entries to be flushed (here to optimize heap allocations)
 
+  /// the flush thread is waiting for new entries, submitters need to wake it
+  std::atomic<bool> m_flusher_waiting = {false};
+  /// entries dropped instead of waiting for the flush to catch up
+  std::atomic<uint64_t> m_dropped = {0};
+
+  /// where the entries we only gather go, if set
+  std::atomic<BinaryLog*> m_binary = {nullptr};
+  std::unique_ptr<BinaryLog> m_binary_log; ///< owns m_binary
+  /// the submitters which might be using m_binary, counted in the slot of
+  /// the generation they started in, so a replaced log can be released
+  /// once the slots have drained
+  std::atomic<unsigned> m_binary_gen = {0};
+  std::atomic<unsigned> m_binary_users[2] = {0, 0};
+
   std::string m_log_file;
   int m_fd = -1;
   uid_t m_uid = 0;
@@ -74,13 +141,19 @@ class Log : private Thread
 
   std::size_t m_max_new = DEFAULT_MAX_NEW;
   std::size_t m_max_recent = DEFAULT_MAX_RECENT;
+  bool m_drop_on_full = false;
 
   bool m_inject_segv = false;
 
   void *entry() override;
 
+  ThreadEntryQueue* _get_thread_queue();
+  bool _has_new_entries() const;
+  void _take_new_entries(EntryVector& q);
+
   void _log_safe_write(std::string_view sv);
   void _flush_logbuf();
+  void _retire_binary_log();
   void _flush(EntryVector& q, bool crash);
 
   void _log_message(std::string_view s, bool crash);
@@ -96,10 +169,12 @@ public:
   void set_coarse_timestamps(bool coarse);
   void set_max_new(std::size_t n);
   void set_max_recent(std::size_t n);
+  void set_drop_on_full(bool drop);
   void set_log_file(std::string_view fn);
   void reopen_log_file();
   void chown_log_file(uid_t uid, gid_t gid);
   void set_log_stderr_prefix(std::string_view p);
+  int set_binary_log(const std::string& path, std::size_t size);
 
   void flush();
 
@@ -122,6 +197,18 @@ public:
 
   void submit_entry(Entry&& e);
 
+  /// submit an ldout_bin() entry. unless it is written to the log file, it
+  /// is recorded in the binary log without being formatted.
+  template <typename... Args>
+  void submit_binary(short prio, short subsys, const BinaryFormat& f,
+		     const Args&... args) {
+    binary::arg_buffer_t buf;
+    (binary::append_arg(buf, args), ...);
+    submit_binary_entry(prio, subsys, f, std::string_view(buf.data(), buf.size()));
+  }
+  void submit_binary_entry(short prio, short subsys, const BinaryFormat& f,
+			   std::string_view args);
+
   void start();
   void stop();
 
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "log/BinaryLog.h"
 #include "log/Log.h"
 #include "common/Clock.h"
 #include "include/coredumpctl.h"
@@ -367,6 +373,150 @@ TEST(Log, GarbleRecovery)
   ASSERT_GT(file_status.st_size, 2000);
 }
 
+TEST(Log, ManyThreads)
+{
+  static const char* test_file="log_many_threads";
+  SubsystemMap subs;
+  subs.set_log_level(1, 20);
+  subs.set_gather_level(1, 10);
+  Log log(&subs);
+  log.start();
+  unlink(test_file);
+  log.set_log_file(test_file);
+  log.reopen_log_file();
+
+  // more entries than the per-thread queues hold
+  const int num_threads = 8;
+  const int num_entries = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&log, t] {
+      for (int i = 0; i < num_entries; i++) {
+	MutableEntry e(10, 1);
+	e.get_ostream() << "thread " << t << " entry " << i;
+	log.submit_entry(std::move(e));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  log.flush();
+  log.stop();
+
+  // nothing is lost, and the entries of each thread stay in order
+  std::ifstream in(test_file);
+  std::vector<int> next(num_threads, 0);
+  std::string line;
+  while (std::getline(in, line)) {
+    auto pos = line.find("thread ");
+    ASSERT_NE(std::string::npos, pos);
+    int t, i;
+    ASSERT_EQ(2, sscanf(line.c_str() + pos, "thread %d entry %d", &t, &i));
+    ASSERT_EQ(next[t], i);
+    next[t]++;
+  }
+  for (int t = 0; t < num_threads; t++) {
+    ASSERT_EQ(num_entries, next[t]);
+  }
+}
+
+TEST(Log, Binary)
+{
+  static const char* test_file="log_binary";
+  static const char* binary_file="log_binary.blog";
+
+  Log* saved = g_ceph_context->_log;
+  Log log(&g_ceph_context->_conf->subsys);
+  log.start();
+  unlink(test_file);
+  log.set_log_file(test_file);
+  log.reopen_log_file();
+  ASSERT_EQ(0, log.set_binary_log(binary_file, BinaryLog::MIN_SIZE));
+  g_ceph_context->_log = &log;
+  g_ceph_context->_conf->subsys.set_log_level(ceph_subsys_context, 1);
+  g_ceph_context->_conf->subsys.set_gather_level(ceph_subsys_context, 20);
+
+  // written to the log file, the other one to the binary log only
+  lsubdout_bin(g_ceph_context, context, 1, "text {} {:x}", 7, 255u);
+  lsubdout_bin(g_ceph_context, context, 20, "binary {} {:>4} {} {}{{}} {}",
+	       -5, "ab", std::string("str"), 1.5, utime_t(1, 0));
+  log.flush();
+
+  std::vector<BinaryLogEntry> entries;
+  ASSERT_EQ(0, read_binary_log(binary_file, &entries, &std::cerr));
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ(20, entries[0].prio);
+  ASSERT_EQ(ceph_subsys_context, entries[0].subsys);
+  CachedStackStringStream css;
+  *css << "binary -5   ab str 1.5{} " << utime_t(1, 0);
+  ASSERT_EQ(css->strv(), entries[0].message);
+
+  // wrap around the ring a few times, the latest entries are kept
+  const int num_entries = 100000;
+  for (int i = 0; i < num_entries; i++) {
+    lsubdout_bin(g_ceph_context, context, 20, "entry {}", i);
+  }
+  entries.clear();
+  ASSERT_EQ(0, read_binary_log(binary_file, &entries, &std::cerr));
+  ASSERT_LT(0u, entries.size());
+  ASSERT_GT(static_cast<size_t>(num_entries), entries.size());
+  int i = num_entries - entries.size();
+  for (auto& e : entries) {
+    ASSERT_EQ(fmt::format("entry {}", i++), e.message);
+  }
+
+  g_ceph_context->_log = saved;
+  log.flush();
+  log.stop();
+
+  std::ifstream in(test_file);
+  std::string contents((std::istreambuf_iterator<char>(in)),
+		       std::istreambuf_iterator<char>());
+  ASSERT_NE(std::string::npos, contents.find("text 7 ff"));
+  ASSERT_EQ(std::string::npos, contents.find("binary"));
+  ASSERT_EQ(std::string::npos, contents.find("entry"));
+}
+
+TEST(Log, BinarySwitch)
+{
+  static const char* binary_files[] = {"log_binary_a.blog", "log_binary_b.blog"};
+
+  Log* saved = g_ceph_context->_log;
+  Log log(&g_ceph_context->_conf->subsys);
+  log.start();
+  g_ceph_context->_log = &log;
+  g_ceph_context->_conf->subsys.set_log_level(ceph_subsys_context, 1);
+  g_ceph_context->_conf->subsys.set_gather_level(ceph_subsys_context, 20);
+
+  // the replaced logs are unmapped while the submitters are still busy
+  std::atomic<bool> stop = false;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&stop, t] {
+      for (int i = 0; !stop; i++) {
+	lsubdout_bin(g_ceph_context, context, 20, "thread {} entry {}", t, i);
+      }
+    });
+  }
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(0, log.set_binary_log(binary_files[i % 2], BinaryLog::MIN_SIZE));
+  }
+  ASSERT_EQ(0, log.set_binary_log("", 0));
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto f : binary_files) {
+    std::vector<BinaryLogEntry> entries;
+    ASSERT_EQ(0, read_binary_log(f, &entries, &std::cerr));
+  }
+
+  g_ceph_context->_log = saved;
+  log.flush();
+  log.stop();
+}
+
 int main(int argc, char **argv)
 {
   auto args = argv_to_vec(argc, argv);
@@ -121,7 +121,7 @@ public:
   ceph::mutex lock = ceph::make_mutex("Monitor::lock");
   SafeTimer timer;
   Finisher finisher;
-  ThreadPool cpu_tp;  ///< threadpool for CPU intensive work
+  WorkStealingThreadPool cpu_tp;  ///< threadpool for CPU intensive work
 
   ceph::mutex auth_lock = ceph::make_mutex("Monitor::auth_lock");
 
@@ -407,8 +407,14 @@ int BlueFS::add_block_device(unsigned id, const string& path, bool trim,
            << reserved << dendl;
   ceph_assert(id < bdev.size());
   ceph_assert(bdev[id] == NULL);
+  // the WAL device may use its own driver, e.g. pmem
+  string dev_type;
+  if (id == BDEV_WAL || id == BDEV_NEWWAL) {
+    dev_type = cct->_conf.get_val<string>("bluefs_wal_bdev_type");
+  }
   BlockDevice *b = BlockDevice::create(cct, path, NULL, NULL,
-				       discard_cb[id], static_cast<void*>(this));
+				       discard_cb[id], static_cast<void*>(this),
+				       dev_type);
   block_reserved[id] = reserved;
   if (_shared_alloc) {
     b->set_no_exclusive_lock();
@@ -4199,12 +4199,17 @@ void *BlueStore::MempoolThread::entry()
   if (store->cache_autotune && binned_kv_cache != nullptr) {
     pcm = std::make_shared<PriorityCache::Manager>(
         store->cct, min, max, target, true, "bluestore-pricache");
+    // the onode caches and the data cache can be given a min and a max
+    // share of the memory, see _update_cache_groups()
+    pcm->add_group("meta_group", 0, 1.0);
+    pcm->add_group("data_group", 0, 1.0);
     pcm->insert("kv", binned_kv_cache, true);
-    pcm->insert("meta", meta_cache, true);
-    pcm->insert("data", data_cache, true);
+    pcm->insert("meta", meta_cache, true, "meta_group");
+    pcm->insert("data", data_cache, true, "data_group");
     if (binned_kv_onode_cache != nullptr) {
-      pcm->insert("kv_onode", binned_kv_onode_cache, true);
+      pcm->insert("kv_onode", binned_kv_onode_cache, true, "meta_group");
     }
+    _update_cache_groups();
   }
 
   utime_t next_balance = ceph_clock_now();
@@ -4298,6 +4303,8 @@ void *BlueStore::MempoolThread::entry()
     interval_stats_trim = false;
 
     store->_update_cache_logger();
+    // have the next pass see the counts cached by the other threads
+    mempool::request_thread_cache_flush();
     auto wait = ceph::make_timespan(
       store->cct->_conf->bluestore_cache_trim_interval);
     cond.wait_for(l, wait);
@@ -4402,6 +4409,30 @@ void BlueStore::MempoolThread::_update_cache_settings()
                 << " pcm min: " << min
                 << " pcm max: " << max
                 << dendl;
+
+  _update_cache_groups();
+}
+
+void BlueStore::MempoolThread::_update_cache_groups()
+{
+  auto& conf = store->cct->_conf;
+  for (const char* group : {"meta", "data"}) {
+    std::string prefix = std::string("bluestore_cache_") + group;
+    double min_ratio = conf.get_val<double>(prefix + "_min_ratio");
+    double max_ratio = conf.get_val<double>(prefix + "_max_ratio");
+    int r = pcm->set_group_ratios(std::string(group) + "_group",
+                                  min_ratio, max_ratio);
+    if (r < 0) {
+      derr << __func__ << " invalid " << prefix << "_min_ratio ("
+           << min_ratio << ") or " << prefix << "_max_ratio ("
+           << max_ratio << "): " << cpp_strerror(r)
+           << ", the ratios must be in range [0,1.0], the min ratios must not"
+           << " add up to more than 1.0" << dendl;
+    } else {
+      dout(5) << __func__ << " " << group << " min ratio: " << min_ratio
+              << " max ratio: " << max_ratio << dendl;
+    }
+  }
 }
 
 // =======================================================
@@ -4588,7 +4619,8 @@ BlueStore::BlueStore(CephContext *cct,
   uint64_t _min_alloc_size)
   : ObjectStore(cct, path),
     throttle(cct),
-    finisher(cct, "commit_finisher", "cfin"),
+    finisher(cct, "commit_finisher", "cfin",
+	     cct->_conf.get_val<uint64_t>("bluestore_finisher_threads")),
     kv_sync_thread(this),
     kv_finalize_thread(this),
 #ifdef HAVE_LIBZBD
@@ -4662,6 +4694,10 @@ const char **BlueStore::get_tracked_conf_keys() const
     "bluestore_cache_kv_onode_age_bins",
     "bluestore_cache_meta_age_bins",
     "bluestore_cache_data_age_bins",
+    "bluestore_cache_meta_min_ratio",
+    "bluestore_cache_meta_max_ratio",
+    "bluestore_cache_data_min_ratio",
+    "bluestore_cache_data_max_ratio",
     "bluestore_warn_on_legacy_statfs",
     "bluestore_warn_on_no_per_pool_omap",
     "bluestore_warn_on_no_per_pg_omap",
@@ -4736,6 +4772,13 @@ void BlueStore::handle_conf_change(const ConfigProxy& conf,
       changed.count("osd_memory_expected_fragmentation")) {
     _update_osd_memory_options();
   }
+  if (changed.count("bluestore_cache_meta_min_ratio") ||
+      changed.count("bluestore_cache_meta_max_ratio") ||
+      changed.count("bluestore_cache_data_min_ratio") ||
+      changed.count("bluestore_cache_data_max_ratio")) {
+    // picked up by the MempoolThread
+    config_changed++;
+  }
 }
 
 void BlueStore::_set_compression()
@@ -5180,6 +5223,21 @@ void BlueStore::_init_logger()
 	    "Sum for beneficial compress ops");
   b.add_u64_counter(l_bluestore_compress_rejected_count, "compress_rejected_count",
 	    "Sum for compress ops rejected due to low net gain of space");
+  b.add_u64_counter(l_bluestore_compress_in_bytes, "compress_in_bytes",
+	    "Sum for bytes passed to the compressor "
+	    "(compress_lat over it is the cost per byte)",
+	    NULL, PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_compress_out_bytes, "compress_out_bytes",
+	    "Sum for bytes produced by the compressor, including rejected ones "
+	    "(over compress_in_bytes it is the ratio achieved)",
+	    NULL, PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_decompress_out_bytes, "decompress_out_bytes",
+	    "Sum for bytes produced by the decompressor",
+	    NULL, PerfCountersBuilder::PRIO_USEFUL, unit_t(UNIT_BYTES));
+  b.add_u64(l_bluestore_compress_queue_depth, "compress_queue_depth",
+	    "Number of compress thread requests not picked up yet");
+  b.add_time_avg(l_bluestore_compress_wait_lat, "compress_wait_lat",
+	    "Average time a write spent compressing its blobs in parallel");
   //****************************************
 
   // onode cache stats
@@ -11035,9 +11093,8 @@ int BlueStore::_do_read(
   int r = 0;
   int read_cache_policy = 0; // do not bypass clean or dirty cache
 
-  dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
-           << " size 0x" << o->onode.size << " (" << std::dec
-           << o->onode.size << ")" << dendl;
+  ldout_bin(cct, 20, "bluestore({}) {} 0x{:x}~{:x} size 0x{:x} ({})",
+	    path, __func__, offset, length, o->onode.size, o->onode.size);
   bl.clear();
 
   if (offset >= o->onode.size) {
@@ -11214,10 +11271,14 @@ int BlueStore::_decompress(bufferlist& source, bufferlist* result)
     _set_compression_alert(false, alg_name);
     r = -EIO;
   } else {
+    auto prev_len = result->length();
     r = cp->decompress(i, chdr.length, *result, chdr.compressor_message);
     if (r < 0) {
       derr << __func__ << " decompression failed with exit code " << r << dendl;
       r = -EIO;
+    } else {
+      logger->inc(l_bluestore_decompress_out_bytes,
+		  result->length() - prev_len);
     }
   }
   log_latency(__func__,
@@ -12825,7 +12886,7 @@ void BlueStore::_txc_committed_kv(TransContext *txc)
     if (txc->ch->commit_queue) {
       txc->ch->commit_queue->queue(txc->oncommits);
     } else {
-      finisher.queue(txc->oncommits);
+      finisher.queue(txc->osr->get_sequencer_id(), txc->oncommits);
     }
   }
   throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_committing_lat);
@@ -13110,6 +13171,7 @@ void BlueStore::_kv_start()
   finisher.start();
   kv_sync_thread.create("bstore_kv_sync");
   kv_finalize_thread.create("bstore_kv_final");
+  _compress_start();
 }
 
 void BlueStore::_kv_stop()
@@ -13145,9 +13207,87 @@ void BlueStore::_kv_stop()
   dout(10) << __func__ << " stopping finishers" << dendl;
   finisher.wait_for_empty();
   finisher.stop();
+  _compress_stop();
   dout(10) << __func__ << " stopped" << dendl;
 }
 
+void BlueStore::_compress_start()
+{
+  auto num = cct->_conf.get_val<uint64_t>("bluestore_compression_threads");
+  dout(10) << __func__ << " " << num << " threads" << dendl;
+  for (uint64_t i = 0; i < num; ++i) {
+    compress_threads.emplace_back(std::make_unique<CompressThread>(this));
+    compress_threads.back()->create("bstore_compress");
+  }
+}
+
+void BlueStore::_compress_stop()
+{
+  dout(10) << __func__ << dendl;
+  {
+    std::lock_guard l{compress_lock};
+    compress_stop = true;
+    compress_cond.notify_all();
+  }
+  for (auto& t : compress_threads) {
+    t->join();
+  }
+  compress_threads.clear();
+  std::lock_guard l{compress_lock};
+  ceph_assert(compress_queue.empty());
+  compress_stop = false;
+}
+
+void BlueStore::_compress_thread()
+{
+  dout(10) << __func__ << " start" << dendl;
+  std::unique_lock l{compress_lock};
+  while (true) {
+    if (compress_queue.empty()) {
+      if (compress_stop) {
+	break;
+      }
+      compress_cond.wait(l);
+      continue;
+    }
+    auto batch = std::move(compress_queue.front());
+    compress_queue.pop_front();
+    logger->set(l_bluestore_compress_queue_depth, compress_queue.size());
+    l.unlock();
+    batch->run();
+    l.lock();
+  }
+  dout(10) << __func__ << " finish" << dendl;
+}
+
+void BlueStore::_compress_parallel(
+  size_t num,
+  std::function<void(size_t)>&& compress_one)
+{
+  if (num < 2 || compress_threads.empty()) {
+    for (size_t i = 0; i < num; ++i) {
+      compress_one(i);
+    }
+    return;
+  }
+  // the op thread compresses as well, so the helpers are only needed for
+  // the remaining blobs; a helper showing up late finds nothing left to do
+  auto batch = std::make_shared<CompressBatch>(std::move(compress_one), num);
+  size_t helpers = std::min(num - 1, compress_threads.size());
+  {
+    std::lock_guard l{compress_lock};
+    for (size_t i = 0; i < helpers; ++i) {
+      compress_queue.push_back(batch);
+    }
+    logger->set(l_bluestore_compress_queue_depth, compress_queue.size());
+    compress_cond.notify_all();
+  }
+  auto start = mono_clock::now();
+  batch->run();
+  batch->wait();
+  logger->tinc(l_bluestore_compress_wait_lat, mono_clock::now() - start);
+}
+
 void BlueStore::_kv_sync_thread()
 {
   dout(10) << __func__ << " start" << dendl;
@@ -13873,7 +14013,7 @@ void BlueStore::_deferred_aio_finish(OpSequencer *osr)
       osr->deferred_lock.unlock();
       if (deferred_aggressive) {
 	dout(20) << __func__ << " queuing async deferred_try_submit" << dendl;
-	finisher.queue(new C_DeferredTrySubmit(this));
+	finisher.queue(osr->get_sequencer_id(), new C_DeferredTrySubmit(this));
       } else {
 	dout(20) << __func__ << " leaving queued, more pending" << dendl;
       }
@@ -14059,7 +14199,7 @@ int BlueStore::queue_transactions(
     if (c->commit_queue) {
       c->commit_queue->queue(on_applied);
     } else {
-      finisher.queue(on_applied);
+      finisher.queue(osr->get_sequencer_id(), on_applied);
     }
   }
 
@@ -15363,18 +15503,39 @@ int BlueStore::_do_alloc_write(
   // compress (as needed) and calc needed space
   uint64_t need = 0;
   auto max_bsize = std::max(wctx->target_blob_size, min_alloc_size);
+  struct compress_result_t {
+    int r = 0;
+    bufferlist bl;
+    std::optional<int32_t> compressor_message;
+    ceph::timespan lat;
+  };
+  std::vector<WriteContext::write_item*> to_compress;
+  if (c) {
+    for (auto& wi : wctx->writes) {
+      if (wi.blob_length > min_alloc_size) {
+	ceph_assert(wi.b_off == 0);
+	ceph_assert(wi.blob_length == wi.bl.length());
+	to_compress.push_back(&wi);
+      }
+    }
+  }
+  std::vector<compress_result_t> compress_results(to_compress.size());
+  _compress_parallel(to_compress.size(), [&](size_t i) {
+    auto start = mono_clock::now();
+    auto& res = compress_results[i];
+    // FIXME: memory alignment here is bad
+    res.r = c->compress(to_compress[i]->bl, res.bl, res.compressor_message);
+    res.lat = mono_clock::now() - start;
+  });
+  auto p_result = compress_results.begin();
   for (auto& wi : wctx->writes) {
     if (c && wi.blob_length > min_alloc_size) {
-      auto start = mono_clock::now();
-
-      // compress
-      ceph_assert(wi.b_off == 0);
-      ceph_assert(wi.blob_length == wi.bl.length());
-
-      // FIXME: memory alignment here is bad
-      bufferlist t;
-      std::optional<int32_t> compressor_message;
-      int r = c->compress(wi.bl, t, compressor_message);
+      ceph_assert(p_result != compress_results.end());
+      auto& [r, t, compressor_message, lat] = *p_result++;
+      logger->inc(l_bluestore_compress_in_bytes, wi.blob_length);
+      if (r == 0) {
+	logger->inc(l_bluestore_compress_out_bytes, t.length());
+      }
       uint64_t want_len_raw = wi.blob_length * crr;
       uint64_t want_len = p2roundup(want_len_raw, min_alloc_size);
       bool rejected = false;
@@ -15437,7 +15598,7 @@ int BlueStore::_do_alloc_write(
       }
       log_latency("compress@_do_alloc_write",
 	l_bluestore_compress_lat,
-        mono_clock::now() - start,
+	lat,
 	cct->_conf->bluestore_log_op_age );
     } else {
       need += wi.blob_length;
@@ -158,6 +158,11 @@ enum {
   l_bluestore_decompress_lat,
   l_bluestore_compress_success_count,
   l_bluestore_compress_rejected_count,
+  l_bluestore_compress_in_bytes,
+  l_bluestore_compress_out_bytes,
+  l_bluestore_decompress_out_bytes,
+  l_bluestore_compress_queue_depth,
+  l_bluestore_compress_wait_lat,
   //****************************************
 
   // onode cache stats
@@ -2090,6 +2095,45 @@ public:
     }
   };
 
+  struct CompressThread : public Thread {
+    BlueStore *store;
+    explicit CompressThread(BlueStore *s) : store(s) {}
+    void *entry() override {
+      store->_compress_thread();
+      return NULL;
+    }
+  };
+
+  /// blobs of a write compressed by the op thread with help of the
+  /// compress threads; each one claims the next blob until none is left
+  struct CompressBatch {
+    std::function<void(size_t)> compress_one;
+    const size_t num;
+    std::atomic<size_t> next = {0};
+    ceph::mutex lock = ceph::make_mutex("BlueStore::CompressBatch::lock");
+    ceph::condition_variable cond;
+    size_t done = 0;
+
+    CompressBatch(std::function<void(size_t)>&& f, size_t n)
+      : compress_one(std::move(f)), num(n) {}
+
+    void run() {
+      size_t i;
+      while ((i = next++) < num) {
+	compress_one(i);
+	std::lock_guard l{lock};
+	if (++done == num) {
+	  cond.notify_all();
+	}
+      }
+    }
+    void wait() {
+      std::unique_lock l{lock};
+      cond.wait(l, [this] { return done == num; });
+    }
+  };
+  using CompressBatchRef = std::shared_ptr<CompressBatch>;
+
 #ifdef HAVE_LIBZBD
   struct ZonedCleanerThread : public Thread {
     BlueStore *store;
@@ -2174,7 +2218,7 @@ private:
   deferred_osr_queue_t deferred_queue; ///< osr's with deferred io pending
   std::atomic_int deferred_queue_size = {0};         ///< num txc's queued across all osrs
   std::atomic_int deferred_aggressive = {0}; ///< aggressive wakeup of kv thread
-  Finisher  finisher;
+  ShardedFinisher finisher;  ///< ordered per OpSequencer
   utime_t  deferred_last_submitted = utime_t();
 
   KVSyncThread kv_sync_thread;
@@ -2198,6 +2242,12 @@ private:
   std::deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
   bool kv_finalize_in_progress = false;
 
+  std::vector<std::unique_ptr<CompressThread>> compress_threads;
+  ceph::mutex compress_lock = ceph::make_mutex("BlueStore::compress_lock");
+  ceph::condition_variable compress_cond;
+  std::deque<CompressBatchRef> compress_queue; ///< one entry per helper wanted
+  bool compress_stop = false;
+
 #ifdef HAVE_LIBZBD
   ZonedCleanerThread zoned_cleaner_thread;
   ceph::mutex zoned_cleaner_lock = ceph::make_mutex("BlueStore::zoned_cleaner_lock");
@@ -2522,6 +2572,7 @@ private:
 
   private:
     void _update_cache_settings();
+    void _update_cache_groups();
     void _resize_shards(bool interval_stats);
   } mempool_thread;
 
@@ -2666,6 +2717,13 @@ private:
   void _kv_sync_thread();
   void _kv_finalize_thread();
 
+  void _compress_start();
+  void _compress_stop();
+  void _compress_thread();
+  /// call compress_one() for [0, num), in parallel if compress threads exist
+  void _compress_parallel(size_t num,
+			  std::function<void(size_t)>&& compress_one);
+
 #ifdef HAVE_LIBZBD
   void _zoned_cleaner_start();
   void _zoned_cleaner_stop();
@@ -2294,6 +2294,10 @@ OSD::~OSD()
     delete shards.back();
     shards.pop_back();
   }
+  for (auto l : numa_buffers_perf) {
+    cct->get_perfcounters_collection()->remove(l);
+    delete l;
+  }
   cct->get_perfcounters_collection()->remove(recoverystate_perf);
   cct->get_perfcounters_collection()->remove(logger);
   delete recoverystate_perf;
@@ -2412,6 +2416,48 @@ int OSD::set_numa_affinity()
   return 0;
 }
 
+void OSD::enable_numa_buffers()
+{
+  if (!cct->_conf.get_val<bool>("osd_numa_buffers")) {
+    return;
+  }
+  std::vector<int> cpu_nodes;
+  int r = get_cpu_numa_nodes(&cpu_nodes);
+  if (r == 0) {
+    r = ceph::buffer::enable_numa_pools(
+      cpu_nodes,
+      cct->_conf.get_val<Option::size_t>("osd_numa_buffers_max"),
+      cct->_conf.get_val<bool>("osd_numa_buffers_huge_pages"));
+  }
+  if (r < 0) {
+    derr << __func__ << " unable to allocate the buffers from numa node pools: "
+	 << cpp_strerror(r) << dendl;
+    return;
+  }
+  int num_nodes = ceph::buffer::get_num_numa_pools();
+  dout(1) << __func__ << " allocating the buffers from " << num_nodes
+	  << " numa node pools" << dendl;
+  for (int node = 0; node < num_nodes; ++node) {
+    auto l = build_numa_buffers_perf(cct, node);
+    cct->get_perfcounters_collection()->add(l);
+    numa_buffers_perf.push_back(l);
+  }
+}
+
+void OSD::update_numa_buffers_perf()
+{
+  for (size_t node = 0; node < numa_buffers_perf.size(); ++node) {
+    auto l = numa_buffers_perf[node];
+    auto stats = ceph::buffer::get_numa_pool_stats(node);
+    l->set(l_numa_buffers_alloc, stats.allocs);
+    l->set(l_numa_buffers_alloc_bytes, stats.alloc_bytes);
+    l->set(l_numa_buffers_fallback, stats.fallbacks);
+    l->set(l_numa_buffers_in_use_bytes, stats.in_use_bytes);
+    l->set(l_numa_buffers_mapped_bytes, stats.mapped_bytes);
+    l->set(l_numa_buffers_huge_page_bytes, stats.huge_page_bytes);
+  }
+}
+
 // asok
 
 class OSDSocketHook : public AdminSocketHook {
@@ -3789,6 +3835,8 @@ int OSD::init()
     }
   }
 
+  enable_numa_buffers();
+
   osd_op_tp.start();
 
   // start the heartbeat
@@ -5302,6 +5350,25 @@ void OSD::build_initial_pg_history(
 	   << dendl;
 }
 
+/// the longest ping interval of a stable heartbeat peer
+static double heartbeat_interval_max(CephContext *cct)
+{
+  // do not delay the detection of a failed peer by more than half the grace
+  return std::max<double>(
+    cct->_conf->osd_heartbeat_interval,
+    std::min<double>(cct->_conf.get_val<int64_t>("osd_heartbeat_interval_max"),
+		     cct->_conf->osd_heartbeat_grace / 2.0));
+}
+
+static ceph::timespan thread_cpu_time()
+{
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+    return ceph::timespan::zero();
+  }
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
 void OSD::_add_heartbeat_peer(int p)
 {
   if (p == whoami)
@@ -5333,6 +5400,11 @@ void OSD::_add_heartbeat_peer(int p)
     hi->con_front = cons.second.get();
     hi->con_front->set_priv(sf);
 
+    hi->host = hi->con_back->get_peer_addr();
+    hi->host.set_port(0);
+    hi->host.set_nonce(0);
+    hi->reset_interval(cct->_conf->osd_heartbeat_interval);
+
     dout(10) << "_add_heartbeat_peer: new peer osd." << p
 	     << " " << hi->con_back->get_peer_addr()
 	     << " " << hi->con_front->get_peer_addr()
@@ -5513,6 +5585,7 @@ void OSD::handle_osd_ping(MOSDPing *m)
   }
 
   int from = m->get_source().num();
+  auto cpu_start = thread_cpu_time();
 
   heartbeat_lock.lock();
   if (is_stopping()) {
@@ -5789,6 +5862,16 @@ void OSD::handle_osd_ping(MOSDPing *m)
                 if (i->second.con_front != NULL)
 		  service.osd_stat.hb_pingtime[from].front_last = front_pingtime;
 	    }
+	    i->second.got_reply(
+	      std::max(back_pingtime, front_pingtime) / 1000000.0,
+	      cct->_conf->osd_heartbeat_interval,
+	      heartbeat_interval_max(cct),
+	      cct->_conf.get_val<uint64_t>("osd_heartbeat_stable_replies"),
+	      cct->_conf.get_val<double>("osd_heartbeat_suspect_jitter"));
+	    dout(25) << "handle_osd_ping osd." << from
+		     << " srtt " << i->second.hb_srtt
+		     << " rttvar " << i->second.hb_rttvar
+		     << " interval " << i->second.hb_interval << dendl;
             i->second.ping_history.erase(i->second.ping_history.begin(), ++acked);
           }
 
@@ -5846,6 +5929,7 @@ void OSD::handle_osd_ping(MOSDPing *m)
     break;
   }
 
+  logger->tinc(l_osd_hb_ping_cpu_time, thread_cpu_time() - cpu_start);
   heartbeat_lock.unlock();
   m->put();
 }
@@ -5856,7 +5940,9 @@ void OSD::heartbeat_entry()
   if (is_stopping())
     return;
   while (!heartbeat_stop) {
+    auto cpu_start = thread_cpu_time();
     heartbeat();
+    logger->tinc(l_osd_hb_cpu_time, thread_cpu_time() - cpu_start);
 
     double wait;
     if (cct->_conf.get_val<bool>("debug_disable_randomized_ping")) {
@@ -5954,11 +6040,36 @@ void OSD::heartbeat()
   utime_t deadline = now;
   deadline += cct->_conf->osd_heartbeat_grace;
 
+  // the peers on the same host are pinged together, as soon as one of
+  // them is due
+  double base_interval = cct->_conf->osd_heartbeat_interval;
+  double jitter = cct->_conf.get_val<double>("osd_heartbeat_suspect_jitter");
+  map<entity_addr_t, bool> due_hosts;
+  for (auto& [peer, hi] : heartbeat_peers) {
+    if (!hi.hb_suspect && hi.is_suspect(now, jitter)) {
+      dout(10) << "heartbeat osd." << peer << " is suspect, no reply since "
+	       << hi.ping_history.begin()->first << " with srtt " << hi.hb_srtt
+	       << " rttvar " << hi.hb_rttvar << dendl;
+      hi.hb_suspect = true;
+      hi.reset_interval(base_interval);
+      logger->inc(l_osd_hb_suspect);
+    }
+    due_hosts[hi.host] |= hi.is_due(now, base_interval);
+  }
+
   // send heartbeats
+  uint64_t sent = 0, deferred = 0;
   for (map<int,HeartbeatInfo>::iterator i = heartbeat_peers.begin();
        i != heartbeat_peers.end();
        ++i) {
     int peer = i->first;
+    if (!due_hosts[i->second.host]) {
+      dout(30) << "heartbeat osd." << peer << " pinged at " << i->second.last_tx
+	       << " with interval " << i->second.hb_interval << ", deferring"
+	       << dendl;
+      ++deferred;
+      continue;
+    }
     Session *s = static_cast<Session*>(i->second.con_back->get_priv().get());
     if (!s) {
       dout(30) << "heartbeat osd." << peer << " has no open con" << dendl;
@@ -5999,9 +6110,13 @@ void OSD::heartbeat()
 		     service.get_up_epoch(),
 		     cct->_conf->osd_heartbeat_min_size,
 		     delta_ub));
+    ++sent;
   }
 
   logger->set(l_osd_hb_to, heartbeat_peers.size());
+  logger->set(l_osd_hb_to_hosts, due_hosts.size());
+  logger->inc(l_osd_hb_ping_sent, sent);
+  logger->inc(l_osd_hb_ping_deferred, deferred);
 
   // hmm.. am i all alone?
   dout(30) << "heartbeat lonely?" << dendl;
@@ -6124,6 +6239,7 @@ void OSD::tick_without_osd_lock()
   logger->set(l_osd_cached_crc, ceph::buffer::get_cached_crc());
   logger->set(l_osd_cached_crc_adjusted, ceph::buffer::get_cached_crc_adjusted());
   logger->set(l_osd_missed_crc, ceph::buffer::get_missed_crc());
+  update_numa_buffers_perf();
 
   // refresh osd stats
   struct store_statfs_t stbuf;
@@ -10912,6 +11028,9 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   // Access the stored item
   auto item = std::move(std::get<OpSchedulerItem>(work_item));
+  if (auto op = item.maybe_get_op(); op) {
+    (*op)->mark_stage(OpRequest::STAGE_DEQUEUED);
+  }
   if (osd->is_stopping()) {
     sdata->shard_lock.unlock();
     for (auto c : oncommits) {
@@ -1118,6 +1118,7 @@ protected:
   int numa_node = -1;
   size_t numa_cpu_set_size = 0;
   cpu_set_t numa_cpu_set;
+  std::vector<PerfCounters*> numa_buffers_perf;  ///< per numa node
 
   bool store_is_rotational = true;
   bool journal_is_rotational = true;
@@ -1413,6 +1414,68 @@ private:
     std::vector<uint32_t> hb_front_min;
     std::vector<uint32_t> hb_front_max;
 
+    /// the peer's host, the peers on the same host are pinged together
+    entity_addr_t host;
+    /// the adaptive ping interval (in seconds), see osd_heartbeat_interval_max
+    double hb_interval = 0;
+    /// replies without jitter since the interval was last changed
+    uint32_t hb_stable_replies = 0;
+    /// smoothed round trip time of the pings and its mean deviation
+    double hb_srtt = 0;
+    double hb_rttvar = 0;
+    /// a ping has been unanswered for much longer than the jitter explains
+    bool hb_suspect = false;
+    /// the shortest time a ping may go unanswered before the peer is suspect
+    static constexpr double HEARTBEAT_MIN_SUSPECT = 0.1;
+
+    double get_suspect_time(double jitter) const {
+      return std::max(hb_srtt + jitter * hb_rttvar, HEARTBEAT_MIN_SUSPECT);
+    }
+
+    bool is_suspect(utime_t now, double jitter) const {
+      if (ping_history.empty() || hb_srtt == 0) {
+	/// the peers which never replied are left to the grace
+	return false;
+      }
+      return now - ping_history.begin()->first > get_suspect_time(jitter);
+    }
+
+    /// a peer is due if waiting for the next heartbeat pass could leave
+    /// it unpinged for longer than its interval
+    bool is_due(utime_t now, double base_interval) const {
+      return last_tx == utime_t() || hb_suspect ||
+	now - last_tx >= hb_interval - base_interval;
+    }
+
+    void reset_interval(double base_interval) {
+      hb_interval = base_interval;
+      hb_stable_replies = 0;
+    }
+
+    /// account for the round trip time of a ping: the interval doubles
+    /// after every @p stable_replies replies without jitter, up to
+    /// @p max_interval, and drops back to @p base_interval otherwise
+    void got_reply(double rtt, double base_interval, double max_interval,
+		   uint32_t stable_replies, double jitter) {
+      bool jittery = false;
+      if (hb_srtt == 0) {
+	hb_srtt = rtt;
+	hb_rttvar = rtt / 2;
+      } else {
+	jittery = rtt > get_suspect_time(jitter);
+	hb_rttvar = 0.75 * hb_rttvar + 0.25 * std::abs(hb_srtt - rtt);
+	hb_srtt = 0.875 * hb_srtt + 0.125 * rtt;
+      }
+      hb_suspect = false;
+      if (jittery || hb_interval < base_interval || hb_interval > max_interval) {
+	reset_interval(base_interval);
+      } else if (++hb_stable_replies >= stable_replies &&
+		 hb_interval < max_interval) {
+	hb_interval = std::min(hb_interval * 2, max_interval);
+	hb_stable_replies = 0;
+      }
+    }
+
     bool is_stale(utime_t stale) const {
       if (ping_history.empty()) {
         return false;
@@ -2086,6 +2149,8 @@ public:
 
   int enable_disable_fuse(bool stop);
   int set_numa_affinity();
+  void enable_numa_buffers();
+  void update_numa_buffers_perf();
 
   void suicide(int exitcode);
   int shutdown();
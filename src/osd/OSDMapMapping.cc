@@ -130,12 +130,15 @@ void OSDMapMapping::_update_range(
 void ParallelPGMapper::Job::finish_one()
 {
   Context *fin = nullptr;
+  int r = 0;
   {
     std::lock_guard l(lock);
     if (--shards == 0) {
       if (!aborted) {
 	finish = ceph_clock_now();
 	complete();
+      } else {
+	r = -ECANCELED;
       }
       cond.notify_all();
       fin = onfinish;
@@ -143,12 +146,27 @@ void ParallelPGMapper::Job::finish_one()
     }
   }
   if (fin) {
-    fin->complete(0);
+    fin->complete(r);
   }
 }
 
+void ParallelPGMapper::Job::discard_one()
+{
+  {
+    std::lock_guard l(lock);
+    // the mapping will not be complete
+    aborted = true;
+  }
+  finish_one();
+}
+
 void ParallelPGMapper::WQ::_process(Item *i, ThreadPool::TPHandle &h)
 {
+  if (i->job->aborted) {
+    i->job->finish_one();
+    delete i;
+    return;
+  }
   ldout(m->cct, 20) << __func__ << " " << i->job << " pool " << i->pool
                     << " [" << i->begin << "," << i->end << ")"
                     << " pgs " << i->pgs
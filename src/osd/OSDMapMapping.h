@@ -91,6 +91,8 @@ public:
       ++shards;
     }
     void finish_one();
+    /// for an item dropped from the queue without being processed
+    void discard_one();
   };
 
 protected:
@@ -109,53 +111,28 @@ protected:
 	begin(b),
 	end(e) {}
   };
-  std::deque<Item*> q;
 
-  struct WQ : public ThreadPool::WorkQueue<Item> {
+  struct WQ : public WorkStealingThreadPool::WorkQueue<Item> {
     ParallelPGMapper *m;
 
-    WQ(ParallelPGMapper *m_, ThreadPool *tp)
-      : ThreadPool::WorkQueue<Item>(
+    WQ(ParallelPGMapper *m_, WorkStealingThreadPool *tp)
+      : WorkStealingThreadPool::WorkQueue<Item>(
 	"ParallelPGMapper::WQ",
 	ceph::make_timespan(m_->cct->_conf->threadpool_default_timeout),
 	ceph::timespan::zero(),
 	tp),
         m(m_) {}
 
-    bool _enqueue(Item *i) override {
-      m->q.push_back(i);
-      return true;
-    }
-    void _dequeue(Item *i) override {
-      ceph_abort();
-    }
-    Item *_dequeue() override {
-      while (!m->q.empty()) {
-	Item *i = m->q.front();
-	m->q.pop_front();
-	if (i->job->aborted) {
-	  i->job->finish_one();
-	  delete i;
-	} else {
-	  return i;
-	}
-      }
-      return nullptr;
-    }
-
     void _process(Item *i, ThreadPool::TPHandle &h) override;
 
-    void _clear() override {
-      ceph_assert(_empty());
-    }
-
-    bool _empty() override {
-      return m->q.empty();
+    void _discard(Item *i) override {
+      i->job->discard_one();
+      delete i;
     }
   } wq;
 
 public:
-  ParallelPGMapper(CephContext *cct, ThreadPool *tp)
+  ParallelPGMapper(CephContext *cct, WorkStealingThreadPool *tp)
     : cct(cct),
       wq(this, tp) {}
 
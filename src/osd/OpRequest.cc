@@ -50,6 +50,20 @@ OpRequest::OpRequest(Message* req, OpTracker* tracker)
   req_src_inst = req->get_source_inst();
 }
 
+const char *OpRequest::get_stage_name(stage_t stage)
+{
+  switch (stage) {
+  case STAGE_QUEUED: return "queued";
+  case STAGE_DEQUEUED: return "dequeued";
+  case STAGE_PG_LOCKED: return "pg_locked";
+  case STAGE_SUBMITTED: return "submitted";
+  case STAGE_COMMITTED: return "committed";
+  case STAGE_REPLIED: return "replied";
+  default: break;
+  }
+  return "unknown";
+}
+
 void OpRequest::_dump(Formatter *f) const
 {
   Message *m = request;
@@ -86,6 +100,12 @@ void OpRequest::_dump(Formatter *f) const
     }
     f->close_section();
   }
+
+  f->open_object_section("stage_latencies");
+  visit_stage_latencies([f](stage_t stage, utime_t latency) {
+    f->dump_float(get_stage_name(stage), latency);
+  });
+  f->close_section();
 }
 
 void OpRequest::_dump_op_descriptor_unlocked(ostream& stream) const
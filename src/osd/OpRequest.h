@@ -14,6 +14,8 @@
 #ifndef OPREQUEST_H_
 #define OPREQUEST_H_
 
+#include <array>
+
 #include "osd/osd_op_util.h"
 #include "osd/osd_types.h"
 #include "common/TrackedOp.h"
@@ -51,6 +53,18 @@ public:
     return op_info.get_classes();
   }
 
+  /// the stages of a client op, timed whether the op is tracked or not
+  enum stage_t : uint8_t {
+    STAGE_QUEUED = 0,  ///< queued for its pg
+    STAGE_DEQUEUED,    ///< dequeued by an op worker
+    STAGE_PG_LOCKED,   ///< processing started, with its pg locked
+    STAGE_SUBMITTED,   ///< its transaction was submitted
+    STAGE_COMMITTED,   ///< committed on all the replicas
+    STAGE_REPLIED,     ///< replied to the client
+    STAGE_MAX
+  };
+  static const char *get_stage_name(stage_t stage);
+
   void _dump(ceph::Formatter *f) const override;
 
   bool has_feature(uint64_t f) const {
@@ -64,6 +78,8 @@ private:
   uint8_t hit_flag_points;
   uint8_t latest_flag_point;
   utime_t dequeued_time;
+  /// when each stage was last reached, if it was. protected by lock
+  std::array<utime_t, STAGE_MAX> stage_stamps;
   static const uint8_t flag_queued_for_pg=1 << 0;
   static const uint8_t flag_reached_pg =  1 << 1;
   static const uint8_t flag_delayed =     1 << 2;
@@ -147,9 +163,11 @@ public:
   }
 
   void mark_queued_for_pg() {
+    mark_stage(STAGE_QUEUED);
     mark_flag_point(flag_queued_for_pg, "queued_for_pg");
   }
   void mark_reached_pg() {
+    mark_stage(STAGE_PG_LOCKED);
     mark_flag_point(flag_reached_pg, "reached_pg");
   }
   void mark_delayed(const std::string& s) {
@@ -162,9 +180,42 @@ public:
     mark_flag_point_string(flag_sub_op_sent, s);
   }
   void mark_commit_sent() {
+    mark_stage(STAGE_REPLIED);
     mark_flag_point(flag_commit_sent, "commit_sent");
   }
 
+  /// a requeued op keeps the stamps of its last pass through the stages
+  void mark_stage(stage_t stage, utime_t stamp = ceph_clock_now()) {
+    std::lock_guard l(lock);
+    stage_stamps[stage] = stamp;
+  }
+  /// zero if the stage was not reached
+  utime_t get_stage_stamp(stage_t stage) const {
+    std::lock_guard l(lock);
+    return stage_stamps[stage];
+  }
+  /**
+   * call f(stage, latency) for each stage reached, the latency being the
+   * time since the op was received or since the previous stage reached
+   */
+  template <typename Func>
+  void visit_stage_latencies(Func&& f) const {
+    std::array<utime_t, STAGE_MAX> stamps;
+    {
+      std::lock_guard l(lock);
+      stamps = stage_stamps;
+    }
+    utime_t prev = request->get_recv_stamp();
+    for (uint8_t i = 0; i < STAGE_MAX; i++) {
+      const utime_t stamp = stamps[i];
+      if (stamp.is_zero()) {
+	continue;
+      }
+      f(static_cast<stage_t>(i), stamp > prev ? stamp - prev : utime_t());
+      prev = stamp;
+    }
+  }
+
   utime_t get_dequeued_time() const {
     return dequeued_time;
   }
@@ -4308,8 +4308,10 @@ void PrimaryLogPG::execute_ctx(OpContext *ctx)
   // Can capture the ctx by pointer, it's owned by the repop
   ctx->register_on_commit(
     [m, ctx, this](){
-      if (ctx->op)
+      if (ctx->op) {
+	ctx->op->mark_stage(OpRequest::STAGE_COMMITTED);
 	log_op_stats(*ctx->op, ctx->bytes_written, ctx->bytes_read);
+      }
 
       if (m && !ctx->sent_reply) {
 	MOSDOpReply *reply = ctx->reply;
@@ -4319,6 +4321,7 @@ void PrimaryLogPG::execute_ctx(OpContext *ctx)
 	osd->send_message_osd_client(reply, m->get_connection());
 	ctx->sent_reply = true;
 	ctx->op->mark_commit_sent();
+	log_op_stage_stats(*ctx->op, ctx->bytes_written, ctx->bytes_read);
       }
     });
   ctx->register_on_success(
@@ -4413,6 +4416,26 @@ void PrimaryLogPG::log_op_stats(const OpRequest& op,
   }
 }
 
+void PrimaryLogPG::log_op_stage_stats(const OpRequest& op,
+				      const uint64_t inb,
+				      const uint64_t outb)
+{
+  static constexpr std::array<std::pair<int, int>, OpRequest::STAGE_MAX>
+    stage_counters = {{
+      {l_osd_op_stage_queued_lat, l_osd_op_stage_queued_lat_hist},
+      {l_osd_op_stage_dequeued_lat, l_osd_op_stage_dequeued_lat_hist},
+      {l_osd_op_stage_pg_locked_lat, l_osd_op_stage_pg_locked_lat_hist},
+      {l_osd_op_stage_submitted_lat, l_osd_op_stage_submitted_lat_hist},
+      {l_osd_op_stage_committed_lat, l_osd_op_stage_committed_lat_hist},
+      {l_osd_op_stage_replied_lat, l_osd_op_stage_replied_lat_hist},
+    }};
+  op.visit_stage_latencies([&](OpRequest::stage_t stage, utime_t latency) {
+    auto [lat, hist] = stage_counters[stage];
+    osd->logger->tinc(lat, latency);
+    osd->logger->hinc(hist, latency.to_nsec(), inb + outb);
+  });
+}
+
 void PrimaryLogPG::set_dynamic_perf_stats_queries(
     const std::list<OSDPerfMetricQuery> &queries)
 {
@@ -9097,6 +9120,10 @@ void PrimaryLogPG::complete_read_ctx(int result, OpContext *ctx)
   reply->set_result(result);
   reply->add_flags(CEPH_OSD_FLAG_ACK | CEPH_OSD_FLAG_ONDISK);
   osd->send_message_osd_client(reply, m->get_connection());
+  if (result >= 0 && !ctx->ignore_log_op_stats) {
+    ctx->op->mark_stage(OpRequest::STAGE_REPLIED);
+    log_op_stage_stats(*ctx->op, ctx->bytes_written, ctx->bytes_read);
+  }
   close_op_ctx(ctx);
 }
 
@@ -11401,6 +11428,9 @@ void PrimaryLogPG::issue_repop(RepGather *repop, OpContext *ctx)
     soid,
     ctx->log,
     ctx->at_version);
+  if (ctx->op) {
+    ctx->op->mark_stage(OpRequest::STAGE_SUBMITTED);
+  }
   pgbackend->submit_transaction(
     soid,
     ctx->delta_stats,
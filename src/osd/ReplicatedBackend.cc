@@ -934,6 +934,21 @@ void ReplicatedBackend::do_push_reply(OpRequestRef op)
   send_pushes(m->get_priority(), _replies);
 }
 
+/// copy the small buffers of an encoded transaction together, so that the
+/// messages to the replicas reference as few buffers as possible
+static bufferlist compact_encoded_transaction(const bufferlist& bl)
+{
+  bufferlist compacted;
+  for (const auto& p : bl.buffers()) {
+    if (p.length() < CEPH_PAGE_SIZE) {
+      compacted.append(p.c_str(), p.length());
+    } else {
+      compacted.append(p);
+    }
+  }
+  return compacted;
+}
+
 Message * ReplicatedBackend::generate_subop(
   const hobject_t &soid,
   const eversion_t &at_version,
@@ -945,7 +960,8 @@ Message * ReplicatedBackend::generate_subop(
   hobject_t discard_temp_oid,
   const bufferlist &log_entries,
   std::optional<pg_hit_set_history_t> &hset_hist,
-  ObjectStore::Transaction &op_t,
+  const bufferlist &encoded_t,
+  uint32_t data_off,
   pg_shard_t peer,
   const pg_info_t &pinfo)
 {
@@ -959,14 +975,10 @@ Message * ReplicatedBackend::generate_subop(
     parent->get_last_peering_reset_epoch(),
     tid, at_version);
 
-  // ship resulting transaction, log entries, and pg_stats
-  if (!parent->should_send_op(peer, soid)) {
-    ObjectStore::Transaction t;
-    encode(t, wr->get_data());
-  } else {
-    encode(op_t, wr->get_data());
-    wr->get_header().data_off = op_t.get_data_alignment();
-  }
+  // ship resulting transaction, log entries, and pg_stats. the encoded
+  // transaction is shared by the messages to all the replicas
+  wr->set_data(encoded_t);
+  wr->get_header().data_off = data_off;
 
   wr->logbl = log_entries;
 
@@ -1019,10 +1031,27 @@ void ReplicatedBackend::issue_op(
     bufferlist logs;
     encode(log_entries, logs);
 
+    // encode the transaction once, the messages only hold references to
+    // its buffers
+    auto start = ceph::mono_clock::now();
+    bufferlist encoded_t;
+    encode(op_t, encoded_t);
+    encoded_t = compact_encoded_transaction(encoded_t);
+    uint32_t data_off = op_t.get_data_alignment();
+    get_parent()->get_logger()->tinc(l_osd_sop_w_encode_lat,
+				     ceph::mono_clock::now() - start);
+    bufferlist encoded_empty_t;
+
     for (const auto& shard : get_parent()->get_acting_recovery_backfill_shards()) {
       if (shard == parent->whoami_shard()) continue;
       const pg_info_t &pinfo = parent->get_shard_info().find(shard)->second;
 
+      bool send_op = parent->should_send_op(shard, soid);
+      if (!send_op && encoded_empty_t.length() == 0) {
+	ObjectStore::Transaction t;
+	encode(t, encoded_empty_t);
+      }
+
       Message *wr;
       wr = generate_subop(
 	  soid,
@@ -1035,7 +1064,8 @@ void ReplicatedBackend::issue_op(
 	  discard_temp_oid,
 	  logs,
 	  hset_hist,
-	  op_t,
+	  send_op ? encoded_t : encoded_empty_t,
+	  send_op ? data_off : 0,
 	  shard,
 	  pinfo);
       if (op->op && op->op->pg_trace)
@@ -17,6 +17,16 @@ PerfCounters *build_osd_logger(CephContext *cct) {
     32,                              ///< Enough to cover much longer than slow requests
   };
 
+  // Latency axis configuration for op stage histograms, values are in
+  // nanoseconds
+  PerfHistogramCommon::axis_config_d op_stage_hist_x_axis_config{
+    "Latency (usec)",
+    PerfHistogramCommon::SCALE_LOG2, ///< Latency in logarithmic scale
+    0,                               ///< Start at 0
+    1000,                            ///< Quantization unit is 1usec
+    32,                              ///< Enough to cover slow requests
+  };
+
   // Op size axis configuration for op histograms, values are in bytes
   PerfHistogramCommon::axis_config_d op_hist_y_axis_config{
     "Request size (bytes)",
@@ -116,6 +126,48 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_time_avg(
     l_osd_op_rw_prepare_lat, "op_rw_prepare_latency",
     "Latency of read-modify-write operations (excluding queue time and wait for finished)");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_queued_lat, "op_stage_queued_latency",
+    "Latency of client operations from being received to being queued for their PG");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_queued_lat_hist, "op_stage_queued_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_queued_latency + data read and written");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_dequeued_lat, "op_stage_dequeued_latency",
+    "Latency of client operations in the op queue");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_dequeued_lat_hist, "op_stage_dequeued_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_dequeued_latency + data read and written");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_pg_locked_lat, "op_stage_pg_locked_latency",
+    "Latency of client operations from being dequeued to having their PG locked");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_pg_locked_lat_hist, "op_stage_pg_locked_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_pg_locked_latency + data read and written");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_submitted_lat, "op_stage_submitted_latency",
+    "Latency of client operations from having their PG locked to submitting their transaction");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_submitted_lat_hist, "op_stage_submitted_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_submitted_latency + data read and written");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_committed_lat, "op_stage_committed_latency",
+    "Latency of client operations from submitting their transaction to committing on all replicas");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_committed_lat_hist, "op_stage_committed_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_committed_latency + data read and written");
+  osd_plb.add_time_avg(
+    l_osd_op_stage_replied_lat, "op_stage_replied_latency",
+    "Latency of client operations from their previous stage to replying");
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_stage_replied_lat_hist, "op_stage_replied_latency_histogram",
+    op_stage_hist_x_axis_config, op_hist_y_axis_config,
+    "Histogram of op_stage_replied_latency + data read and written");
 
   // Now we move on to some more obscure stats, revert to assuming things
   // are low priority unless otherwise specified.
@@ -137,6 +189,9 @@ PerfCounters *build_osd_logger(CephContext *cct) {
     l_osd_sop_w_inb, "subop_w_in_bytes", "Replicated written data size", NULL, 0, unit_t(UNIT_BYTES));
   osd_plb.add_time_avg(
     l_osd_sop_w_lat, "subop_w_latency", "Replicated writes latency");
+  osd_plb.add_time_avg(
+    l_osd_sop_w_encode_lat, "subop_w_encode_latency",
+    "Time spent encoding the transaction of a replicated write");
   osd_plb.add_u64_counter(
     l_osd_sop_pull, "subop_pull", "Suboperations pull requests");
   osd_plb.add_time_avg(
@@ -188,6 +243,23 @@ PerfCounters *build_osd_logger(CephContext *cct) {
     PerfCountersBuilder::PRIO_USEFUL);
   osd_plb.add_u64(
     l_osd_hb_to, "heartbeat_to_peers", "Heartbeat (ping) peers we send to");
+  osd_plb.add_u64(
+    l_osd_hb_to_hosts, "heartbeat_to_hosts",
+    "Hosts of the heartbeat peers we send to");
+  osd_plb.add_u64_counter(
+    l_osd_hb_ping_sent, "heartbeat_pings_sent", "Heartbeat pings sent");
+  osd_plb.add_u64_counter(
+    l_osd_hb_ping_deferred, "heartbeat_pings_deferred",
+    "Heartbeat pings not sent as the peer was pinged recently enough");
+  osd_plb.add_u64_counter(
+    l_osd_hb_suspect, "heartbeat_suspects",
+    "Heartbeat peers suspected because of a late reply");
+  osd_plb.add_time_avg(
+    l_osd_hb_cpu_time, "heartbeat_cpu_time",
+    "CPU time spent sending heartbeats");
+  osd_plb.add_time_avg(
+    l_osd_hb_ping_cpu_time, "heartbeat_ping_cpu_time",
+    "CPU time spent handling heartbeat messages");
   osd_plb.add_u64_counter(l_osd_map, "map_messages", "OSD map messages");
   osd_plb.add_u64_counter(l_osd_mape, "map_message_epochs", "OSD map epochs");
   osd_plb.add_u64_counter(
@@ -319,3 +391,23 @@ PerfCounters *build_recoverystate_perf(CephContext *cct) {
 
   return rs_perf.create_perf_counters();
 }
+
+PerfCounters *build_numa_buffers_perf(CephContext *cct, int node) {
+  PerfCountersBuilder b(cct, "numa_buffers-node" + std::to_string(node),
+                        l_numa_buffers_first, l_numa_buffers_last);
+
+  b.add_u64_counter(l_numa_buffers_alloc, "alloc",
+    "Buffers allocated from the pool of the node");
+  b.add_u64_counter(l_numa_buffers_alloc_bytes, "alloc_bytes",
+    "Bytes allocated from the pool of the node", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_numa_buffers_fallback, "fallback",
+    "Buffers allocated from the heap because the pool was full");
+  b.add_u64(l_numa_buffers_in_use_bytes, "in_use_bytes",
+    "Bytes of the pool in use", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64(l_numa_buffers_mapped_bytes, "mapped_bytes",
+    "Bytes mapped for the pool", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64(l_numa_buffers_huge_page_bytes, "huge_page_bytes",
+    "Bytes of the pool backed by hugetlb pages", NULL, 0, unit_t(UNIT_BYTES));
+
+  return b.create_perf_counters();
+}
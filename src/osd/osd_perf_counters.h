@@ -36,6 +36,19 @@ enum {
   l_osd_op_rw_process_lat,
   l_osd_op_rw_prepare_lat,
 
+  l_osd_op_stage_queued_lat,
+  l_osd_op_stage_queued_lat_hist,
+  l_osd_op_stage_dequeued_lat,
+  l_osd_op_stage_dequeued_lat_hist,
+  l_osd_op_stage_pg_locked_lat,
+  l_osd_op_stage_pg_locked_lat_hist,
+  l_osd_op_stage_submitted_lat,
+  l_osd_op_stage_submitted_lat_hist,
+  l_osd_op_stage_committed_lat,
+  l_osd_op_stage_committed_lat_hist,
+  l_osd_op_stage_replied_lat,
+  l_osd_op_stage_replied_lat_hist,
+
   l_osd_op_before_queue_op_lat,
   l_osd_op_before_dequeue_op_lat,
 
@@ -45,6 +58,7 @@ enum {
   l_osd_sop_w,
   l_osd_sop_w_inb,
   l_osd_sop_w_lat,
+  l_osd_sop_w_encode_lat,
   l_osd_sop_pull,
   l_osd_sop_pull_lat,
   l_osd_sop_push,
@@ -69,6 +83,12 @@ enum {
   l_osd_pg_stray,
   l_osd_pg_removing,
   l_osd_hb_to,
+  l_osd_hb_to_hosts,
+  l_osd_hb_ping_sent,
+  l_osd_hb_ping_deferred,
+  l_osd_hb_suspect,
+  l_osd_hb_cpu_time,
+  l_osd_hb_ping_cpu_time,
   l_osd_map,
   l_osd_mape,
   l_osd_mape_dup,
@@ -161,3 +181,17 @@ enum {
 };
 
 PerfCounters *build_recoverystate_perf(CephContext *cct);
+
+// NUMA node buffer pool perf counters, see ceph::buffer::enable_numa_pools()
+enum {
+  l_numa_buffers_first = 20100,
+  l_numa_buffers_alloc,
+  l_numa_buffers_alloc_bytes,
+  l_numa_buffers_fallback,
+  l_numa_buffers_in_use_bytes,
+  l_numa_buffers_mapped_bytes,
+  l_numa_buffers_huge_page_bytes,
+  l_numa_buffers_last,
+};
+
+PerfCounters *build_numa_buffers_perf(CephContext *cct, int node);
@@ -2,6 +2,9 @@
 // vim: ts=8 sw=2 smarttab ft=cpp
 
 #include "rgw_compression.h"
+#include "rgw_perf_counters.h"
+#include "common/ceph_time.h"
+#include "common/perf_counters.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -49,7 +52,15 @@ int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
     if ((logical_offset > 0 && compressed) || // if previous part was compressed
         (logical_offset == 0)) {              // or it's the first part
       ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
+      auto start = ceph::mono_clock::now();
       int cr = compressor->compress(in, out, compressor_message);
+      if (perfcounter) {
+        perfcounter->tinc(l_rgw_compress_lat, ceph::mono_clock::now() - start);
+        perfcounter->inc(l_rgw_compress_in_b, in.length());
+        if (cr >= 0) {
+          perfcounter->inc(l_rgw_compress_out_b, out.length());
+        }
+      }
       if (cr < 0) {
         if (logical_offset > 0) {
           lderr(cct) << "Compression failed with exit code " << cr
@@ -137,11 +148,17 @@ int RGWGetObj_Decompress::handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len
       iter_in_bl.seek(ofs_in_bl);
     }
     iter_in_bl.copy(first_block->len, tmp);
+    auto start = ceph::mono_clock::now();
+    auto prev_len = out_bl.length();
     int cr = compressor->decompress(tmp, out_bl, cs_info->compressor_message);
     if (cr < 0) {
       lderr(cct) << "Decompression failed with exit code " << cr << dendl;
       return cr;
     }
+    if (perfcounter) {
+      perfcounter->tinc(l_rgw_decompress_lat, ceph::mono_clock::now() - start);
+      perfcounter->inc(l_rgw_decompress_out_b, out_bl.length() - prev_len);
+    }
     ++first_block;
     while (out_bl.length() - q_ofs >=
 	   static_cast<off_t>(cct->_conf->rgw_max_chunk_size)) {
@@ -59,6 +59,12 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64_counter(l_rgw_pubsub_push_failed, "pubsub_push_failed", "Pubsub events failed to be pushed to an endpoint");
   plb.add_u64(l_rgw_pubsub_push_pending, "pubsub_push_pending", "Pubsub events pending reply from endpoint");
   plb.add_u64_counter(l_rgw_pubsub_missing_conf, "pubsub_missing_conf", "Pubsub events could not be handled because of missing configuration");
+
+  plb.add_u64_counter(l_rgw_compress_in_b, "compress_in_b", "Size of data passed to the compressor (compress_lat over it is the cost per byte)");
+  plb.add_u64_counter(l_rgw_compress_out_b, "compress_out_b", "Size of data produced by the compressor (over compress_in_b it is the ratio achieved)");
+  plb.add_time_avg(l_rgw_compress_lat, "compress_lat", "Compression latency");
+  plb.add_u64_counter(l_rgw_decompress_out_b, "decompress_out_b", "Size of data produced by the decompressor");
+  plb.add_time_avg(l_rgw_decompress_lat, "decompress_lat", "Decompression latency");
   
   perfcounter = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perfcounter);
@@ -50,6 +50,12 @@ enum {
   l_rgw_pubsub_push_pending,
   l_rgw_pubsub_missing_conf,
 
+  l_rgw_compress_in_b,
+  l_rgw_compress_out_b,
+  l_rgw_compress_lat,
+  l_rgw_decompress_out_b,
+  l_rgw_decompress_lat,
+
   l_rgw_last,
 };
 
@@ -0,0 +1,99 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * ceph_bench_formatter -- time the formatters on the output of a large
+ * "pg dump"
+ */
+
+#include <iostream>
+#include <memory>
+
+#include "common/ceph_time.h"
+#include "common/Formatter.h"
+#include "include/buffer.h"
+#include "mon/PGMap.h"
+
+using namespace std;
+
+static void usage(const char *name) {
+  cout << name << " <pgs> [<format> ...]\n"
+       << "\t pgs: the number of pgs in the pg map.\n"
+       << "\t format: json (the default), json-pretty, xml...\n";
+}
+
+static void fill_pg_map(PGMap& pg_map, unsigned num_pgs)
+{
+  const unsigned num_pools = 8;
+  const unsigned num_osds = 100;
+  utime_t now = ceph_clock_now();
+  pg_map.version = 1234;
+  pg_map.stamp = now;
+  for (unsigned i = 0; i < num_pgs; i++) {
+    pg_t pgid(i / num_pools, i % num_pools + 1);
+    pg_stat_t& s = pg_map.pg_stat[pgid];
+    s.version = eversion_t(42, i);
+    s.reported_seq = i * 3;
+    s.reported_epoch = 42;
+    s.state = PG_STATE_ACTIVE | PG_STATE_CLEAN;
+    if (i % 10 == 0) {
+      s.state |= PG_STATE_SCRUBBING | PG_STATE_DEEP_SCRUB;
+    }
+    s.last_fresh = s.last_change = s.last_active = s.last_peered =
+      s.last_clean = s.last_unstale = s.last_undegraded =
+      s.last_fullsized = s.last_scrub_stamp = s.last_deep_scrub_stamp =
+      s.last_clean_scrub_stamp = now;
+    s.log_size = s.ondisk_log_size = 3000;
+    for (unsigned r = 0; r < 3; r++) {
+      s.up.push_back((i + r * 7) % num_osds);
+    }
+    s.acting = s.up;
+    s.up_primary = s.acting_primary = s.up[0];
+    s.stats.sum.num_bytes = uint64_t(i) << 22;
+    s.stats.sum.num_objects = i;
+    s.stats.sum.num_object_copies = 3 * i;
+    s.stats.sum.num_rd = 10 * i;
+    s.stats.sum.num_rd_kb = 400 * i;
+    s.stats.sum.num_wr = 5 * i;
+    s.stats.sum.num_wr_kb = 200 * i;
+    pg_map.pg_sum.add(s);
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  unsigned num_pgs = atoi(argv[1]);
+  vector<string> formats;
+  for (int i = 2; i < argc; i++) {
+    formats.push_back(argv[i]);
+  }
+  if (formats.empty()) {
+    formats.push_back("json");
+  }
+
+  PGMap pg_map;
+  fill_pg_map(pg_map, num_pgs);
+
+  for (auto& format : formats) {
+    unique_ptr<ceph::Formatter> f(ceph::Formatter::create(format, "", ""));
+    if (!f) {
+      cerr << "unknown format " << format << std::endl;
+      return EXIT_FAILURE;
+    }
+    auto start = ceph::mono_clock::now();
+    f->open_object_section("pg_map");
+    pg_map.dump(f.get());
+    f->close_section();
+    bufferlist bl;
+    f->flush(bl);
+    auto elapsed = ceph::to_seconds<double>(ceph::mono_clock::now() - start);
+    cout << format << ": " << num_pgs << " pgs, " << bl.length() << " bytes in "
+	 << elapsed << " s (" << bl.length() / elapsed / (1 << 20) << " MiB/s)"
+	 << std::endl;
+  }
+  return 0;
+}
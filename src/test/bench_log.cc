@@ -5,6 +5,7 @@
 #include "common/Thread.h"
 #include "common/debug.h"
 #include "common/Clock.h"
+#include "common/ceph_time.h"
 #include "common/config.h"
 #include "common/ceph_argparse.h"
 #include "global/global_init.h"
@@ -17,6 +18,7 @@ struct T : public Thread {
   int num;
   set<int> myset;
   map<int,string> mymap;
+  ceph::timespan max_lat = ceph::timespan::zero();
   explicit T(int n) : num(n) {
     myset.insert(123);
     myset.insert(456);
@@ -25,9 +27,12 @@ struct T : public Thread {
   }
 
   void *entry() override {
-    while (num-- > 0)
+    while (num-- > 0) {
+      auto start = ceph::mono_clock::now();
       generic_dout(0) << "this is a typical log line.  set "
 		      << myset << " and map " << mymap << dendl;
+      max_lat = std::max(max_lat, ceph::mono_clock::now() - start);
+    }
     return 0;
   }
 };
@@ -65,16 +70,20 @@ int main(int argc, const char **argv)
     ls.push_back(t);
   }
 
+  ceph::timespan max_lat = ceph::timespan::zero();
   for (int i=0; i<threads; i++) {
     T *t = ls.front();
     ls.pop_front();
     t->join();
+    max_lat = std::max(max_lat, t->max_lat);
     delete t;
   }
 
   utime_t t = ceph_clock_now();
   t -= start;
   cout << " flushing.. " << t << " so far ..." << std::endl;
+  cout << " submitted " << (double)threads * num / (double)t
+       << " lines/sec, max submit latency " << max_lat << std::endl;
 
   g_ceph_context->_log->flush();
 
@@ -0,0 +1,129 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * ceph_bench_mempool -- time small allocations from a mempool, with
+ * the thread cached accounting and with the accounting going straight
+ * to the shards of the pool
+ */
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common/ceph_time.h"
+#include "include/mempool.h"
+
+using namespace std;
+
+struct Item {
+  char data[32];
+};
+
+static mempool::shard_t shards[mempool::num_shards];
+
+// what pool_allocator used to do: update a shard on every call
+static void shard_alloc_free(unsigned n)
+{
+  vector<Item*> items(16);
+  for (unsigned i = 0; i < n; i++) {
+    auto& item = items[i % items.size()];
+    mempool::shard_t *shard = &shards[mempool::pool_t::pick_a_shard_int()];
+    if (item) {
+      shard->bytes -= sizeof(Item);
+      shard->items -= 1;
+      delete[] reinterpret_cast<char*>(item);
+    }
+    shard = &shards[mempool::pool_t::pick_a_shard_int()];
+    shard->bytes += sizeof(Item);
+    shard->items += 1;
+    item = reinterpret_cast<Item*>(new char[sizeof(Item)]);
+  }
+  for (auto item : items) {
+    delete[] reinterpret_cast<char*>(item);
+  }
+}
+
+static void pool_alloc_free(unsigned n)
+{
+  mempool::unittest_1::pool_allocator<Item> alloc;
+  vector<Item*> items(16);
+  for (unsigned i = 0; i < n; i++) {
+    auto& item = items[i % items.size()];
+    if (item) {
+      alloc.deallocate(item, 1);
+    }
+    item = alloc.allocate(1);
+  }
+  for (auto item : items) {
+    if (item) {
+      alloc.deallocate(item, 1);
+    }
+  }
+}
+
+// the accounting alone
+static void shard_count(unsigned n)
+{
+  for (unsigned i = 0; i < n; i++) {
+    mempool::shard_t *shard = &shards[mempool::pool_t::pick_a_shard_int()];
+    shard->bytes += sizeof(Item);
+    shard->items += 1;
+    shard = &shards[mempool::pool_t::pick_a_shard_int()];
+    shard->bytes -= sizeof(Item);
+    shard->items -= 1;
+  }
+}
+
+static void pool_count(unsigned n)
+{
+  auto& pool = mempool::get_pool(mempool::unittest_1::id);
+  for (unsigned i = 0; i < n; i++) {
+    pool.adjust_count(1, sizeof(Item));
+    pool.adjust_count(-1, -(ssize_t)sizeof(Item));
+  }
+}
+
+static double run(void (*f)(unsigned), unsigned threads, unsigned n)
+{
+  auto start = ceph::mono_clock::now();
+  vector<thread> workers;
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back(f, n);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  auto elapsed = ceph::to_seconds<double>(ceph::mono_clock::now() - start);
+  return threads * n / elapsed;
+}
+
+static void usage(const char *name) {
+  cout << name << " <threads> <allocations>\n"
+       << "\t threads: the number of threads allocating.\n"
+       << "\t allocations: the number of allocations per thread.\n";
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 3) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  unsigned threads = atoi(argv[1]);
+  unsigned n = atoi(argv[2]);
+
+  cout << threads << " threads, " << n << " allocations per thread"
+       << std::endl;
+  // the first one pays for warming up the heap
+  run(pool_alloc_free, threads, n);
+  cout << "allocate and free, shards:       "
+       << run(shard_alloc_free, threads, n) << " /s" << std::endl;
+  cout << "allocate and free, thread cache: "
+       << run(pool_alloc_free, threads, n) << " /s" << std::endl;
+  cout << "accounting only, shards:         "
+       << run(shard_count, threads, n) << " /s" << std::endl;
+  cout << "accounting only, thread cache:   "
+       << run(pool_count, threads, n) << " /s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,133 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * ceph_bench_workqueue -- compare ThreadPool and WorkStealingThreadPool
+ * with many producers queueing small items
+ */
+
+#include <deque>
+#include <iostream>
+#include <thread>
+
+#include "common/ceph_argparse.h"
+#include "common/ceph_time.h"
+#include "common/WorkQueue.h"
+#include "global/global_init.h"
+
+using namespace std;
+
+struct Item {
+  std::atomic<uint64_t> *done;
+};
+
+// the typical ThreadPool user: a deque protected by the pool lock
+class LockedWQ : public ThreadPool::WorkQueue<Item> {
+  std::deque<Item*> items;
+public:
+  explicit LockedWQ(ThreadPool *tp)
+    : ThreadPool::WorkQueue<Item>("bench_wq", ceph::make_timespan(60),
+				  ceph::make_timespan(0), tp) {}
+  bool _enqueue(Item *i) override {
+    items.push_back(i);
+    return true;
+  }
+  void _dequeue(Item *i) override {
+    ceph_abort();
+  }
+  bool _empty() override {
+    return items.empty();
+  }
+  Item *_dequeue() override {
+    if (items.empty()) {
+      return nullptr;
+    }
+    Item *i = items.front();
+    items.pop_front();
+    return i;
+  }
+  void _process(Item *i, ThreadPool::TPHandle &) override {
+    ++*i->done;
+  }
+  void _clear() override {
+    items.clear();
+  }
+};
+
+class StealingWQ : public WorkStealingThreadPool::WorkQueue<Item> {
+public:
+  explicit StealingWQ(WorkStealingThreadPool *tp)
+    : WorkStealingThreadPool::WorkQueue<Item>("bench_wq",
+					       ceph::make_timespan(60),
+					       ceph::make_timespan(0), tp) {}
+  void _process(Item *i, ThreadPool::TPHandle &) override {
+    ++*i->done;
+  }
+};
+
+template <typename WQ>
+static double run(WQ& wq, unsigned producers, unsigned items)
+{
+  std::atomic<uint64_t> done = {0};
+  Item item{&done};
+  auto start = ceph::mono_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < producers; i++) {
+    threads.emplace_back([&] {
+      for (unsigned j = 0; j < items; j++) {
+	wq.queue(&item);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  wq.drain();
+  auto elapsed = ceph::to_seconds<double>(ceph::mono_clock::now() - start);
+  ceph_assert(done == uint64_t(producers) * items);
+  return done / elapsed;
+}
+
+static void usage(const char *name) {
+  cout << name << " <threads> <producers> <items>\n"
+       << "\t threads: the number of threads in the pool.\n"
+       << "\t producers: the number of threads queueing items.\n"
+       << "\t items: the number of items queued by each producer.\n";
+}
+
+int main(int argc, const char **argv)
+{
+  if (argc < 4) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  unsigned threads = atoi(argv[1]);
+  unsigned producers = atoi(argv[2]);
+  unsigned items = atoi(argv[3]);
+
+  auto args = argv_to_vec(argc, argv);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  cout << threads << " threads, " << producers << " producers, "
+       << items << " items per producer" << std::endl;
+  {
+    ThreadPool tp(g_ceph_context, "bench_tp", "tp_bench", threads);
+    LockedWQ wq(&tp);
+    tp.start();
+    double rate = run(wq, producers, items);
+    tp.stop();
+    cout << "ThreadPool:             " << rate << " items/s" << std::endl;
+  }
+  {
+    WorkStealingThreadPool tp(g_ceph_context, "bench_tp", "tp_bench", threads);
+    StealingWQ wq(&tp);
+    tp.start();
+    double rate = run(wq, producers, items);
+    tp.stop();
+    cout << "WorkStealingThreadPool: " << rate << " items/s" << std::endl;
+  }
+  return 0;
+}
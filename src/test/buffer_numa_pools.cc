@@ -0,0 +1,65 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+// the numa pools cannot be disabled once enabled, so they are tested in
+// their own process rather than along with the rest of unittest_bufferlist
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+
+#include <vector>
+
+#include "include/buffer.h"
+#include "include/page.h"
+
+#include "gtest/gtest.h"
+
+using namespace ceph;
+
+TEST(BufferRaw, numa_pools) {
+#if defined(__linux__)
+  EXPECT_EQ(0, buffer::get_num_numa_pools());
+  EXPECT_EQ(-EINVAL, buffer::enable_numa_pools({}, 8 << 20, false));
+  // pretend all the cpus belong to node 0
+  std::vector<int> cpu_nodes(CPU_SETSIZE, 0);
+  ASSERT_EQ(0, buffer::enable_numa_pools(cpu_nodes, 8 << 20, false));
+  EXPECT_EQ(-EEXIST, buffer::enable_numa_pools(cpu_nodes, 8 << 20, false));
+  EXPECT_EQ(1, buffer::get_num_numa_pools());
+  {
+    bufferptr small(buffer::create_page_aligned(100));
+    bufferptr page(buffer::create_page_aligned(CEPH_PAGE_SIZE));
+    bufferptr big(buffer::create_aligned(300000, 4096));
+    for (auto p : {&small, &page, &big}) {
+      EXPECT_TRUE(p->is_aligned(CEPH_PAGE_SIZE));
+      memset(p->c_str(), 1, p->length());
+    }
+    auto stats = buffer::get_numa_pool_stats(0);
+    EXPECT_EQ(3u, stats.allocs);
+    EXPECT_EQ(100u + CEPH_PAGE_SIZE + 300000u, stats.alloc_bytes);
+    EXPECT_EQ(2u * CEPH_PAGE_SIZE + (512u << 10), stats.in_use_bytes);
+    EXPECT_EQ(0u, stats.fallbacks);
+
+    bufferptr clone(big.clone());
+    EXPECT_EQ(0, memcmp(clone.c_str(), big.c_str(), big.length()));
+    EXPECT_EQ(4u, buffer::get_numa_pool_stats(0).allocs);
+
+    // too large for the pools
+    bufferptr huge(buffer::create_page_aligned(4 << 20));
+    EXPECT_EQ(4u, buffer::get_numa_pool_stats(0).allocs);
+  }
+  EXPECT_EQ(0u, buffer::get_numa_pool_stats(0).in_use_bytes);
+  {
+    // exhaust the pool
+    std::vector<bufferptr> bufs;
+    for (int i = 0; i < 9; ++i) {
+      bufs.emplace_back(buffer::create_page_aligned(1 << 20));
+    }
+    auto stats = buffer::get_numa_pool_stats(0);
+    EXPECT_EQ(8u << 20, stats.mapped_bytes);
+    EXPECT_LT(0u, stats.fallbacks);
+  }
+#else
+  EXPECT_EQ(-EOPNOTSUPP, buffer::enable_numa_pools({0}, 8 << 20, false));
+#endif
+}
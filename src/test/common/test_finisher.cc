@@ -0,0 +1,42 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "common/ceph_context.h"
+#include "common/Finisher.h"
+
+TEST(ShardedFinisher, OrderPerKey)
+{
+  CephContext *cct = (new CephContext(CEPH_ENTITY_TYPE_CLIENT))->get();
+  {
+    ShardedFinisher finisher(cct, "test_finisher", "tfin", 4);
+    ASSERT_EQ(4u, finisher.get_num_shards());
+    finisher.start();
+
+    const unsigned num_keys = 16, num_contexts = 1000;
+    ceph::mutex lock = ceph::make_mutex("test_finisher::lock");
+    std::map<uint64_t, std::vector<unsigned>> completed;
+    for (unsigned i = 0; i < num_contexts; i++) {
+      for (uint64_t key = 0; key < num_keys; key++) {
+	finisher.queue(key, new LambdaContext([&, key, i](int r) {
+	  std::lock_guard l(lock);
+	  completed[key].push_back(i);
+	}));
+      }
+    }
+    finisher.wait_for_empty();
+    finisher.stop();
+
+    ASSERT_EQ(num_keys, completed.size());
+    for (auto& [key, seq] : completed) {
+      ASSERT_EQ(num_contexts, seq.size());
+      for (unsigned i = 0; i < num_contexts; i++) {
+	ASSERT_EQ(i, seq[i]);
+      }
+    }
+  }
+  cct->put();
+}
@@ -0,0 +1,258 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+
+#include "common/ceph_json.h"
+#include "common/condition_variable_debug.h"
+#include "common/mutex_debug.h"
+#include "common/shared_mutex_debug.h"
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+struct bucket_t {
+  uint64_t upper_bound_ns = 0;
+  uint64_t count = 0;
+  void decode_json(JSONObj *obj) {
+    JSONDecoder::decode_json("upper_bound_ns", upper_bound_ns, obj);
+    JSONDecoder::decode_json("count", count, obj);
+  }
+};
+
+struct lock_t {
+  std::string name;
+  uint64_t sampled = 0;
+  uint64_t contended = 0;
+  uint64_t wait_ns = 0;
+  uint64_t hold_ns = 0;
+  std::vector<bucket_t> wait_histogram;
+  std::vector<bucket_t> hold_histogram;
+  void decode_json(JSONObj *obj) {
+    JSONDecoder::decode_json("name", name, obj);
+    JSONDecoder::decode_json("sampled", sampled, obj);
+    JSONDecoder::decode_json("contended", contended, obj);
+    JSONDecoder::decode_json("wait_ns", wait_ns, obj);
+    JSONDecoder::decode_json("hold_ns", hold_ns, obj);
+    JSONDecoder::decode_json("wait_histogram", wait_histogram, obj);
+    JSONDecoder::decode_json("hold_histogram", hold_histogram, obj);
+  }
+};
+
+uint64_t total(const std::vector<bucket_t>& hist)
+{
+  uint64_t n = 0;
+  for (auto& b : hist) {
+    n += b.count;
+  }
+  return n;
+}
+
+// the profile of the locks named @p name, as dumped by the admin socket
+lock_t dump_lock(const std::string& name)
+{
+  JSONFormatter f;
+  f.open_object_section("lock_contention");
+  ceph::lock_contention_dump(&f);
+  f.close_section();
+  std::ostringstream ss;
+  f.flush(ss);
+
+  JSONParser parser;
+  EXPECT_TRUE(parser.parse(ss.str().c_str(), ss.str().size()));
+  std::vector<lock_t> locks;
+  JSONDecoder::decode_json("locks", locks, &parser);
+  for (auto& l : locks) {
+    if (l.name == name) {
+      return l;
+    }
+  }
+  return lock_t{name};
+}
+
+// the profiles are shared by all the locks of the same name, so each test
+// uses its own names and starts from an empty profile
+class LockContention : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ceph::lock_contention_reset();
+  }
+  void TearDown() override {
+    ceph::lock_contention_set_sample(0);
+  }
+};
+
+} // anonymous namespace
+
+TEST_F(LockContention, Disabled)
+{
+  ceph::lock_contention_set_sample(0);
+  ceph::mutex_debug m("LockContention::Disabled");
+  for (int i = 0; i < 10; i++) {
+    std::lock_guard l(m);
+  }
+  EXPECT_EQ(0u, dump_lock("LockContention::Disabled").sampled);
+}
+
+TEST_F(LockContention, Uncontended)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_debug m("LockContention::Uncontended");
+  for (int i = 0; i < 10; i++) {
+    std::lock_guard l(m);
+  }
+  auto l = dump_lock("LockContention::Uncontended");
+  EXPECT_EQ(10u, l.sampled);
+  EXPECT_EQ(0u, l.contended);
+  EXPECT_EQ(0u, l.wait_ns);
+  EXPECT_TRUE(l.wait_histogram.empty());
+  EXPECT_EQ(10u, total(l.hold_histogram));
+}
+
+TEST_F(LockContention, SampleEvery)
+{
+  ceph::lock_contention_set_sample(4);
+  // the countdown is per thread, so start from a fresh one
+  std::thread([] {
+    ceph::mutex_debug m("LockContention::SampleEvery");
+    for (int i = 0; i < 8; i++) {
+      std::lock_guard l(m);
+    }
+  }).join();
+  auto l = dump_lock("LockContention::SampleEvery");
+  EXPECT_EQ(2u, l.sampled);
+  EXPECT_EQ(2u, total(l.hold_histogram));
+}
+
+TEST_F(LockContention, Contended)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_debug m("LockContention::Contended");
+  std::unique_lock holder(m);
+  std::thread waiter([&m] {
+    std::lock_guard l(m);
+  });
+  std::this_thread::sleep_for(20ms);
+  holder.unlock();
+  waiter.join();
+
+  auto l = dump_lock("LockContention::Contended");
+  EXPECT_EQ(2u, l.sampled);
+  EXPECT_EQ(1u, l.contended);
+  EXPECT_LE(uint64_t(std::chrono::nanoseconds(10ms).count()), l.wait_ns);
+  ASSERT_EQ(1u, l.wait_histogram.size());
+  EXPECT_EQ(1u, l.wait_histogram[0].count);
+  EXPECT_LT(l.wait_ns, l.wait_histogram[0].upper_bound_ns);
+  // the holder slept with the lock
+  EXPECT_LE(uint64_t(std::chrono::nanoseconds(10ms).count()), l.hold_ns);
+  EXPECT_EQ(2u, total(l.hold_histogram));
+}
+
+TEST_F(LockContention, Recursive)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_recursive_debug m("LockContention::Recursive");
+  m.lock();
+  m.lock();
+  m.unlock();
+  m.unlock();
+  auto l = dump_lock("LockContention::Recursive");
+  EXPECT_EQ(2u, l.sampled);
+  // only the outermost acquisition is held
+  EXPECT_EQ(1u, total(l.hold_histogram));
+}
+
+TEST_F(LockContention, ConditionVariable)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_debug m("LockContention::ConditionVariable");
+  ceph::condition_variable_debug cond;
+  std::unique_lock l(m);
+  std::this_thread::sleep_for(1ms);
+  // the wait releases the lock, which ends the sampled hold
+  cond.wait_for(l, 50ms);
+  auto p = dump_lock("LockContention::ConditionVariable");
+  EXPECT_EQ(1u, p.sampled);
+  EXPECT_EQ(1u, total(p.hold_histogram));
+  EXPECT_LE(uint64_t(std::chrono::nanoseconds(1ms).count()), p.hold_ns);
+  EXPECT_GT(uint64_t(std::chrono::nanoseconds(50ms).count()), p.hold_ns);
+  // and the lock retaken by the wait is not sampled
+  l.unlock();
+  p = dump_lock("LockContention::ConditionVariable");
+  EXPECT_EQ(1u, total(p.hold_histogram));
+}
+
+TEST_F(LockContention, Shared)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::shared_mutex_debug m("LockContention::Shared");
+  {
+    std::shared_lock l(m);
+  }
+  {
+    std::unique_lock l(m);
+  }
+  auto l = dump_lock("LockContention::Shared");
+  EXPECT_EQ(2u, l.sampled);
+  // the readers only time their wait
+  EXPECT_EQ(1u, total(l.hold_histogram));
+}
+
+TEST_F(LockContention, Reset)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_debug m("LockContention::Reset");
+  {
+    std::lock_guard l(m);
+  }
+  ASSERT_EQ(1u, dump_lock("LockContention::Reset").sampled);
+  ceph::lock_contention_reset();
+  auto l = dump_lock("LockContention::Reset");
+  EXPECT_EQ(0u, l.sampled);
+  EXPECT_EQ(0u, l.hold_ns);
+  EXPECT_TRUE(l.hold_histogram.empty());
+  // the lock is still profiled after a reset
+  {
+    std::lock_guard l(m);
+  }
+  EXPECT_EQ(1u, dump_lock("LockContention::Reset").sampled);
+}
+
+TEST_F(LockContention, MostContendedFirst)
+{
+  ceph::lock_contention_set_sample(1);
+  ceph::mutex_debug m("LockContention::MostContendedFirst");
+  std::unique_lock holder(m);
+  std::thread waiter([&m] {
+    std::lock_guard l(m);
+  });
+  std::this_thread::sleep_for(10ms);
+  holder.unlock();
+  waiter.join();
+
+  JSONFormatter f;
+  f.open_object_section("lock_contention");
+  ceph::lock_contention_dump(&f);
+  f.close_section();
+  std::ostringstream ss;
+  f.flush(ss);
+  JSONParser parser;
+  ASSERT_TRUE(parser.parse(ss.str().c_str(), ss.str().size()));
+  unsigned sample = 0;
+  JSONDecoder::decode_json("sample", sample, &parser);
+  EXPECT_EQ(1u, sample);
+  std::vector<lock_t> locks;
+  JSONDecoder::decode_json("locks", locks, &parser);
+  ASSERT_FALSE(locks.empty());
+  EXPECT_EQ("LockContention::MostContendedFirst", locks[0].name);
+  for (size_t i = 1; i < locks.size(); i++) {
+    EXPECT_GE(locks[i - 1].wait_ns, locks[i].wait_ns);
+  }
+}
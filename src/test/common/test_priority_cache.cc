@@ -0,0 +1,248 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <array>
+#include <memory>
+#include <numeric>
+
+#include "common/PriorityCache.h"
+#include "global/global_context.h"
+
+#include "gtest/gtest.h"
+
+using PriorityCache::Priority;
+
+namespace {
+
+constexpr int64_t total = 1ll << 30;
+
+// a cache which asks for a fixed number of bytes at each priority
+class FakeCache : public PriorityCache::PriCache {
+  std::string name;
+  double ratio;
+  std::array<int64_t, Priority::LAST + 1> bytes = {};
+  int64_t committed = 0;
+public:
+  std::array<int64_t, Priority::LAST + 1> wants = {};
+
+  FakeCache(const std::string& name, double ratio)
+    : name(name), ratio(ratio) {}
+
+  int64_t request_cache_bytes(Priority pri, uint64_t) const override {
+    return std::max<int64_t>(wants[pri] - bytes[pri], 0);
+  }
+  int64_t get_cache_bytes(Priority pri) const override {
+    return bytes[pri];
+  }
+  int64_t get_cache_bytes() const override {
+    return std::accumulate(bytes.begin(), bytes.end(), int64_t(0));
+  }
+  void set_cache_bytes(Priority pri, int64_t b) override {
+    bytes[pri] = b;
+  }
+  void add_cache_bytes(Priority pri, int64_t b) override {
+    bytes[pri] += b;
+  }
+  int64_t commit_cache_size(uint64_t) override {
+    committed = get_cache_bytes();
+    return committed;
+  }
+  int64_t get_committed_size() const override {
+    return committed;
+  }
+  double get_cache_ratio() const override {
+    return ratio;
+  }
+  void set_cache_ratio(double r) override {
+    ratio = r;
+  }
+  std::string get_cache_name() const override {
+    return name;
+  }
+  void shift_bins() override {}
+  void import_bins(const std::vector<uint64_t>&) override {}
+  void set_bins(Priority, uint64_t) override {}
+  uint64_t get_bins(Priority) const override {
+    return 0;
+  }
+};
+
+class PriorityCacheGroups : public ::testing::Test {
+protected:
+  // with min == max, the memory for caches does not depend on the heap
+  PriorityCache::Manager mgr{g_ceph_context, total, total, total, false,
+			     "test_priority_cache"};
+
+  std::shared_ptr<FakeCache> add_cache(const std::string& name, double ratio,
+				       const std::string& group = "") {
+    auto c = std::make_shared<FakeCache>(name, ratio);
+    mgr.insert(name, c, false, group);
+    return c;
+  }
+  void TearDown() override {
+    mgr.clear();
+  }
+};
+
+} // anonymous namespace
+
+TEST_F(PriorityCacheGroups, AddGroup)
+{
+  EXPECT_EQ(0, mgr.add_group("a", 0.2, 0.5));
+  EXPECT_EQ(-EEXIST, mgr.add_group("a", 0.1, 0.5));
+  add_cache("c", 1.0);
+  EXPECT_EQ(-EEXIST, mgr.add_group("c", 0.1, 0.5));
+  EXPECT_EQ(-EINVAL, mgr.add_group("b", 0.5, 0.4));
+  EXPECT_EQ(-EINVAL, mgr.add_group("b", -0.1, 0.4));
+  EXPECT_EQ(-EINVAL, mgr.add_group("b", 0.1, 1.1));
+  EXPECT_EQ(-ENOENT, mgr.add_group("b", 0.1, 0.5, "nothing"));
+  // the top level min shares add up to at most 1
+  EXPECT_EQ(-EINVAL, mgr.add_group("b", 0.9, 1.0));
+  EXPECT_EQ(0, mgr.add_group("b", 0.8, 1.0));
+  // and the min shares of the children to at most the one of the parent
+  EXPECT_EQ(-EINVAL, mgr.add_group("a1", 0.3, 0.5, "a"));
+  EXPECT_EQ(0, mgr.add_group("a1", 0.1, 0.5, "a"));
+  EXPECT_EQ(-EINVAL, mgr.add_group("a2", 0.15, 0.5, "a"));
+  EXPECT_EQ(0, mgr.add_group("a2", 0.1, 1.0, "a"));
+}
+
+TEST_F(PriorityCacheGroups, SetGroupRatios)
+{
+  EXPECT_EQ(-ENOENT, mgr.set_group_ratios("a", 0.1, 0.5));
+  ASSERT_EQ(0, mgr.add_group("a", 0.4, 0.5));
+  ASSERT_EQ(0, mgr.add_group("a1", 0.3, 0.5, "a"));
+  ASSERT_EQ(0, mgr.add_group("b", 0.5, 1.0));
+  EXPECT_EQ(-EINVAL, mgr.set_group_ratios("a", 0.4, 0.3));
+  // below the min shares of the children
+  EXPECT_EQ(-EINVAL, mgr.set_group_ratios("a", 0.2, 0.5));
+  // above the room left by the siblings
+  EXPECT_EQ(-EINVAL, mgr.set_group_ratios("a", 0.6, 0.8));
+  EXPECT_EQ(-EINVAL, mgr.set_group_ratios("a1", 0.5, 0.5));
+  EXPECT_EQ(0, mgr.set_group_ratios("a", 0.3, 0.8));
+  EXPECT_EQ(0, mgr.set_group_ratios("a1", 0.2, 0.2));
+  EXPECT_EQ(0, mgr.set_group_ratios("b", 0.7, 0.7));
+}
+
+TEST_F(PriorityCacheGroups, MaxShare)
+{
+  ASSERT_EQ(0, mgr.add_group("capped", 0, 0.25));
+  auto greedy = add_cache("greedy", 0.9, "capped");
+  auto other = add_cache("other", 0.1);
+  greedy->wants[Priority::PRI0] = total;
+  greedy->wants[Priority::PRI1] = total;
+  other->wants[Priority::PRI1] = total;
+  mgr.balance();
+  EXPECT_EQ(total / 4, greedy->get_cache_bytes(Priority::PRI0));
+  EXPECT_EQ(0, greedy->get_cache_bytes(Priority::PRI1));
+  EXPECT_EQ(total / 4, greedy->get_cache_bytes());
+  // the rest is left to the other cache
+  EXPECT_EQ(total - total / 4, other->get_cache_bytes(Priority::PRI1));
+}
+
+TEST_F(PriorityCacheGroups, MaxShareAtLastPriority)
+{
+  // the memory left at the last priority is split by ratio, except for
+  // what exceeds the max share of a group
+  ASSERT_EQ(0, mgr.add_group("capped", 0, 0.25));
+  auto greedy = add_cache("greedy", 0.5, "capped");
+  auto other = add_cache("other", 0.5);
+  greedy->wants[Priority::PRI0] = total / 8;
+  mgr.balance();
+  EXPECT_EQ(total / 8, greedy->get_cache_bytes(Priority::PRI0));
+  EXPECT_EQ(total / 8, greedy->get_cache_bytes(Priority::LAST));
+  EXPECT_EQ(total / 4, greedy->get_cache_bytes());
+  EXPECT_LE(other->get_cache_bytes(), total - total / 4);
+  EXPECT_GT(other->get_cache_bytes(), 0);
+}
+
+TEST_F(PriorityCacheGroups, NestedMaxShare)
+{
+  // the max share of a parent caps the groups under it
+  ASSERT_EQ(0, mgr.add_group("parent", 0, 0.5));
+  ASSERT_EQ(0, mgr.add_group("child", 0, 1.0, "parent"));
+  auto a = add_cache("a", 0.4, "child");
+  auto b = add_cache("b", 0.4, "parent");
+  auto other = add_cache("other", 0.2);
+  for (auto c : {a, b, other}) {
+    c->wants[Priority::PRI0] = total;
+  }
+  mgr.balance();
+  EXPECT_LE(a->get_cache_bytes() + b->get_cache_bytes(), total / 2);
+  EXPECT_GE(a->get_cache_bytes() + b->get_cache_bytes(), total / 2 - 4);
+  EXPECT_GE(other->get_cache_bytes(), total / 2 - 4);
+}
+
+TEST_F(PriorityCacheGroups, MinShare)
+{
+  // without its group, the small cache would only get what the big one
+  // leaves at the higher priorities, i.e. nothing
+  ASSERT_EQ(0, mgr.add_group("guaranteed", 0.3, 1.0));
+  auto big = add_cache("big", 0.99);
+  auto small = add_cache("small", 0.01, "guaranteed");
+  big->wants[Priority::PRI0] = total;
+  small->wants[Priority::PRI1] = total * 3 / 10;
+  mgr.balance();
+  EXPECT_EQ(static_cast<int64_t>(total * 0.3),
+	    small->get_cache_bytes(Priority::PRI1));
+  EXPECT_EQ(total - static_cast<int64_t>(total * 0.3),
+	    big->get_cache_bytes(Priority::PRI0));
+}
+
+TEST_F(PriorityCacheGroups, NestedMinShare)
+{
+  // a child draws from its own min share, then from the one its parent
+  // kept for itself
+  ASSERT_EQ(0, mgr.add_group("parent", 0.4, 1.0));
+  ASSERT_EQ(0, mgr.add_group("child", 0.2, 1.0, "parent"));
+  auto big = add_cache("big", 0.99);
+  auto small = add_cache("small", 0.01, "child");
+  big->wants[Priority::PRI0] = total;
+  small->wants[Priority::PRI1] = total;
+  mgr.balance();
+  auto min_bytes = static_cast<int64_t>(total * 0.2) +
+    (static_cast<int64_t>(total * 0.4) - static_cast<int64_t>(total * 0.2));
+  EXPECT_EQ(min_bytes, small->get_cache_bytes(Priority::PRI1));
+  EXPECT_EQ(total - min_bytes, big->get_cache_bytes(Priority::PRI0));
+}
+
+TEST_F(PriorityCacheGroups, MinShareReleased)
+{
+  // an idle group gives its min share away at the last priority
+  ASSERT_EQ(0, mgr.add_group("idle", 0.5, 1.0));
+  add_cache("unused", 0, "idle");
+  auto busy = add_cache("busy", 1.0);
+  busy->wants[Priority::PRI0] = total;
+  mgr.balance();
+  EXPECT_EQ(total / 2, busy->get_cache_bytes(Priority::PRI0));
+  EXPECT_EQ(total / 2, busy->get_cache_bytes(Priority::LAST));
+  EXPECT_EQ(total, busy->get_cache_bytes());
+}
+
+TEST_F(PriorityCacheGroups, MinShareCappedByMaxShare)
+{
+  // a group is not set aside more than its max share
+  ASSERT_EQ(0, mgr.add_group("g", 0.5, 0.5));
+  auto c = add_cache("c", 0.5, "g");
+  auto other = add_cache("other", 0.5);
+  c->wants[Priority::PRI0] = total;
+  other->wants[Priority::PRI0] = total;
+  mgr.balance();
+  EXPECT_EQ(total / 2, c->get_cache_bytes());
+  EXPECT_EQ(total / 2, other->get_cache_bytes());
+}
+
+TEST_F(PriorityCacheGroups, Rebalance)
+{
+  // the shares are recomputed at each balance
+  ASSERT_EQ(0, mgr.add_group("capped", 0, 0.25));
+  auto greedy = add_cache("greedy", 0.9, "capped");
+  add_cache("other", 0.1);
+  greedy->wants[Priority::PRI0] = total;
+  mgr.balance();
+  EXPECT_EQ(total / 4, greedy->get_cache_bytes(Priority::PRI0));
+  ASSERT_EQ(0, mgr.set_group_ratios("capped", 0, 0.5));
+  mgr.balance();
+  EXPECT_EQ(total / 2, greedy->get_cache_bytes(Priority::PRI0));
+  mgr.erase("greedy");
+  ASSERT_EQ(0, mgr.add_group("greedy", 0, 1.0));
+}
@@ -0,0 +1,99 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <sys/time.h>
+
+#include <sstream>
+#include <tuple>
+
+#include "gtest/gtest.h"
+#include "common/ceph_time.h"
+#include "common/Formatter.h"
+#include "common/sampling_profiler.h"
+
+using ceph::SamplingProfiler;
+
+static volatile uint64_t sink;
+
+static void burn_cpu(ceph::timespan duration)
+{
+  auto start = ceph::mono_clock::now();
+  while (ceph::mono_clock::now() - start < duration) {
+    for (unsigned i = 0; i < 10000; i++) {
+      sink = sink * 31 + i;
+    }
+  }
+}
+
+TEST(SamplingProfiler, StartStop)
+{
+  auto& profiler = SamplingProfiler::instance();
+  std::ostringstream ss;
+  ASSERT_EQ(-EINVAL, profiler.start(0, ss));
+  ASSERT_EQ(-EINVAL, profiler.stop(ss));
+  ASSERT_EQ(0, profiler.start(SamplingProfiler::DEFAULT_FREQUENCY, ss));
+  ASSERT_TRUE(profiler.is_running());
+  ASSERT_EQ(-EBUSY, profiler.start(SamplingProfiler::DEFAULT_FREQUENCY, ss));
+  ASSERT_EQ(-EBUSY, profiler.reset(ss));
+  ASSERT_EQ(0, profiler.stop(ss));
+  ASSERT_FALSE(profiler.is_running());
+  ASSERT_EQ(0, profiler.reset(ss));
+}
+
+TEST(SamplingProfiler, Frequency)
+{
+  auto& profiler = SamplingProfiler::instance();
+  std::ostringstream ss;
+  ASSERT_EQ(-EINVAL, profiler.start(1001, ss));
+  // (hz, sec, usec) of the timer interval
+  const std::tuple<unsigned, time_t, suseconds_t> intervals[] = {
+    {1, 1, 0},
+    {3, 0, 333333},
+    {1000, 0, 1000},
+  };
+  for (auto& [hz, sec, usec] : intervals) {
+    ASSERT_EQ(0, profiler.start(hz, ss)) << "hz=" << hz << ": " << ss.str();
+    struct itimerval timer;
+    ASSERT_EQ(0, getitimer(ITIMER_PROF, &timer));
+    ASSERT_EQ(sec, timer.it_interval.tv_sec) << "hz=" << hz;
+    ASSERT_EQ(usec, timer.it_interval.tv_usec) << "hz=" << hz;
+    ASSERT_EQ(0, profiler.stop(ss));
+  }
+  ASSERT_EQ(0, profiler.reset(ss));
+}
+
+TEST(SamplingProfiler, Collapsed)
+{
+  auto& profiler = SamplingProfiler::instance();
+  std::ostringstream ss;
+  ASSERT_EQ(0, profiler.reset(ss));
+  ASSERT_EQ(0, profiler.start(1000, ss));
+  burn_cpu(std::chrono::milliseconds(500));
+  ASSERT_EQ(0, profiler.stop(ss));
+
+  std::unique_ptr<ceph::Formatter> f(ceph::Formatter::create("json"));
+  f->open_object_section("status");
+  profiler.dump_status(f.get());
+  f->close_section();
+  std::ostringstream status;
+  f->flush(status);
+  ASSERT_NE(std::string::npos, status.str().find("\"running\":false"));
+
+  std::ostringstream out;
+  profiler.dump_collapsed(out);
+  ASSERT_FALSE(out.str().empty());
+  uint64_t total = 0;
+  std::istringstream lines(out.str());
+  for (std::string line; std::getline(lines, line); ) {
+    // "frame;frame;...;frame count"
+    auto space = line.rfind(' ');
+    ASSERT_NE(std::string::npos, space);
+    total += std::stoull(line.substr(space + 1));
+  }
+  ASSERT_GT(total, 0u);
+
+  ASSERT_EQ(0, profiler.reset(ss));
+  std::ostringstream empty;
+  profiler.dump_collapsed(empty);
+  ASSERT_TRUE(empty.str().empty());
+}
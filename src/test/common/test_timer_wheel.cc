@@ -0,0 +1,243 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "common/TimerWheel.h"
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+using ceph::mono_clock;
+using event_t = TimerWheel::event_t;
+
+namespace {
+
+// the wheel never reads the clock, so the tests run on a made up one
+class TimerWheelTest : public ::testing::Test {
+protected:
+  TimerWheel wheel;
+  std::list<event_t> events;
+  // the start of a slot, far from the start of the wheel
+  mono_clock::time_point t0 = mono_clock::time_point(1000 * TimerWheel::tick);
+
+  event_t& add(mono_clock::time_point when, mono_clock::time_point now) {
+    auto& e = events.emplace_back(nullptr, when);
+    wheel.schedule(e, now);
+    return e;
+  }
+  // fire the events due by now, as the timer thread does
+  std::vector<event_t*> fire(mono_clock::time_point now) {
+    std::vector<event_t*> fired;
+    while (auto e = wheel.next_due(now)) {
+      wheel.unschedule(*e);
+      fired.push_back(e);
+    }
+    return fired;
+  }
+};
+
+} // anonymous namespace
+
+TEST_F(TimerWheelTest, Empty)
+{
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(mono_clock::time_point::max(), wheel.next_event());
+  EXPECT_EQ(nullptr, wheel.next_due(t0));
+}
+
+TEST_F(TimerWheelTest, ExactTime)
+{
+  auto& e = add(t0 + 1s + 3ms, t0);
+  EXPECT_FALSE(e.overflow);
+  EXPECT_EQ(e.when, wheel.next_event());
+  // the slot of the event is not enough, it fires at its time
+  EXPECT_TRUE(fire(e.when - 1ns).empty());
+  EXPECT_EQ(std::vector<event_t*>{&e}, fire(e.when));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, OrderWithinSlot)
+{
+  // all in the same slot, added out of order
+  auto& c = add(t0 + 100ms + 9ms, t0);
+  auto& a = add(t0 + 100ms + 1ms, t0);
+  auto& b = add(t0 + 100ms + 5ms, t0);
+  ASSERT_EQ(a.slot, b.slot);
+  ASSERT_EQ(a.slot, c.slot);
+  EXPECT_EQ(a.when, wheel.next_event());
+  EXPECT_EQ((std::vector<event_t*>{&a, &b}), fire(b.when));
+  // the slot is in order now; a new event still lands in its place
+  auto& d = add(t0 + 100ms + 7ms, b.when);
+  auto& f = add(t0 + 100ms + 10ms, b.when);
+  EXPECT_EQ(d.when, wheel.next_event());
+  EXPECT_EQ((std::vector<event_t*>{&d, &c, &f}), fire(f.when));
+}
+
+TEST_F(TimerWheelTest, SameTime)
+{
+  std::vector<event_t*> expected;
+  for (int i = 0; i < 5; i++) {
+    expected.push_back(&add(t0 + 50ms, t0));
+  }
+  auto& early = add(t0 + 48ms, t0);
+  expected.insert(expected.begin(), &early);
+  // sort the slot, then add to it
+  EXPECT_EQ(early.when, wheel.next_event());
+  for (int i = 0; i < 3; i++) {
+    expected.push_back(&add(t0 + 50ms, t0));
+  }
+  EXPECT_EQ(expected, fire(t0 + 50ms));
+}
+
+TEST_F(TimerWheelTest, Overflow)
+{
+  const auto span = TimerWheel::num_slots * TimerWheel::tick;
+  auto& far = add(t0 + span + 10s, t0);
+  auto& near = add(t0 + 1s, t0);
+  EXPECT_TRUE(far.overflow);
+  EXPECT_FALSE(near.overflow);
+  EXPECT_EQ(near.when, wheel.next_event());
+  EXPECT_EQ(std::vector<event_t*>{&near}, fire(near.when));
+  // the wheel is empty, the overflow is next
+  EXPECT_EQ(far.when, wheel.next_event());
+  EXPECT_TRUE(fire(t0 + span).empty());
+  // the wheel now covers the event
+  EXPECT_FALSE(far.overflow);
+  auto& after = add(far.when + 1ms, t0 + span);
+  auto& same = add(far.when, t0 + span);
+  EXPECT_EQ(far.when, wheel.next_event());
+  EXPECT_TRUE(fire(far.when - 1ns).empty());
+  EXPECT_EQ((std::vector<event_t*>{&far, &same, &after}), fire(after.when));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, OverflowSameTime)
+{
+  const auto when = t0 + 100s;
+  auto& a = add(when, t0);
+  auto& b = add(when, t0);
+  auto& c = add(when, t0);
+  EXPECT_TRUE(a.overflow && b.overflow && c.overflow);
+  EXPECT_EQ((std::vector<event_t*>{&a, &b, &c}), fire(when));
+}
+
+TEST_F(TimerWheelTest, CancelOverflow)
+{
+  auto& a = add(t0 + 100s, t0);
+  auto& b = add(t0 + 200s, t0);
+  auto& c = add(t0 + 1s, t0);
+  ASSERT_TRUE(a.overflow);
+  wheel.unschedule(a);
+  EXPECT_EQ(c.when, wheel.next_event());
+  wheel.unschedule(c);
+  EXPECT_EQ(b.when, wheel.next_event());
+  EXPECT_TRUE(fire(t0 + 150s).empty());
+  // b was pulled into the wheel by now
+  EXPECT_FALSE(b.overflow);
+  wheel.unschedule(b);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(mono_clock::time_point::max(), wheel.next_event());
+  EXPECT_TRUE(fire(t0 + 300s).empty());
+}
+
+TEST_F(TimerWheelTest, Cancel)
+{
+  auto& a = add(t0 + 10ms, t0);
+  auto& b = add(t0 + 10ms, t0);
+  auto& c = add(t0 + 20ms, t0);
+  EXPECT_EQ(a.when, wheel.next_event());
+  wheel.unschedule(a);
+  EXPECT_EQ(b.when, wheel.next_event());
+  wheel.unschedule(b);
+  EXPECT_EQ(c.when, wheel.next_event());
+  EXPECT_EQ(std::vector<event_t*>{&c}, fire(c.when));
+}
+
+TEST_F(TimerWheelTest, LongIdle)
+{
+  // the timer thread overslept, and finds the events late
+  auto& a = add(t0 + 2s, t0);
+  auto& b = add(t0 + 1s, t0);
+  auto& far = add(t0 + 300s, t0);
+  auto late = t0 + 1h;
+  EXPECT_EQ((std::vector<event_t*>{&b, &a, &far}), fire(late));
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(TimerWheel::tick_of(late), wheel.get_cursor());
+
+  // the cursor lags behind the clock while the wheel is empty; the new
+  // events are placed from now, not from the cursor
+  auto now = late + 10min;
+  auto& c = add(now + 100ms, now);
+  EXPECT_FALSE(c.overflow);
+  EXPECT_EQ(TimerWheel::tick_of(now), wheel.get_cursor());
+  auto& d = add(now + TimerWheel::num_slots * TimerWheel::tick, now);
+  EXPECT_TRUE(d.overflow);
+  EXPECT_EQ(std::vector<event_t*>{&c}, fire(c.when));
+  EXPECT_EQ(std::vector<event_t*>{&d}, fire(d.when));
+}
+
+TEST_F(TimerWheelTest, Overdue)
+{
+  add(t0 + 1s, t0);
+  fire(t0 + 1s);
+  // an event in the past goes to the slot of the cursor, and fires first
+  auto& late = add(t0, t0 + 1s);
+  auto& now = add(t0 + 1s, t0 + 1s);
+  EXPECT_EQ(late.slot, now.slot);
+  EXPECT_EQ((std::vector<event_t*>{&late, &now}), fire(t0 + 1s));
+}
+
+TEST_F(TimerWheelTest, WrapAround)
+{
+  // start a few slots before the end of the wheel
+  const uint64_t start = 10 * TimerWheel::num_slots - 3;
+  const auto base = mono_clock::time_point(start * TimerWheel::tick);
+  std::vector<event_t*> expected;
+  // across the last words of the bitmap and back to the first ones
+  for (uint64_t i : {130, 70, 5, 2, 1, 0}) {
+    expected.insert(expected.begin(),
+		    &add(base + i * TimerWheel::tick, base));
+  }
+  EXPECT_EQ(TimerWheel::num_slots - 3, expected[0]->slot);
+  EXPECT_EQ(TimerWheel::num_slots - 1, expected[2]->slot);
+  EXPECT_EQ(2u, expected[3]->slot);
+  for (auto e : expected) {
+    EXPECT_EQ(e->when, wheel.next_event());
+    EXPECT_EQ(std::vector<event_t*>{e}, fire(e->when));
+  }
+  EXPECT_TRUE(wheel.empty());
+
+  // the slots before the cursor hold the last ticks of the wheel
+  auto now = base + 130 * TimerWheel::tick;
+  auto& last = add(now + (TimerWheel::num_slots - 1) * TimerWheel::tick, now);
+  auto& next = add(now + TimerWheel::tick, now);
+  EXPECT_FALSE(last.overflow);
+  EXPECT_EQ(next.when, wheel.next_event());
+  EXPECT_EQ(std::vector<event_t*>{&next}, fire(next.when));
+  EXPECT_EQ(last.when, wheel.next_event());
+  EXPECT_EQ(std::vector<event_t*>{&last}, fire(last.when));
+}
+
+TEST_F(TimerWheelTest, Many)
+{
+  // many events per slot, across the wheel and the overflow
+  std::multimap<std::pair<mono_clock::time_point, int>, event_t*> expected;
+  for (int i = 0; i < 10000; i++) {
+    auto when = t0 + std::chrono::milliseconds((i * 7919) % 100000);
+    expected.emplace(std::make_pair(when, i), &add(when, t0));
+  }
+  std::vector<event_t*> fired;
+  for (auto now = t0; !wheel.empty(); now += 5s) {
+    auto f = fire(now);
+    fired.insert(fired.end(), f.begin(), f.end());
+  }
+  ASSERT_EQ(expected.size(), fired.size());
+  auto p = expected.begin();
+  for (auto e : fired) {
+    EXPECT_EQ(p->second, e);
+    ++p;
+  }
+}
@@ -233,6 +233,28 @@ struct fltree_onode_manager_test_t
         start = list_end;
       }
       ceph_assert(oids.size() == listed_oids.size());
+
+      std::map<ghobject_t, onode_item_t*> expected;
+      for (auto tup : boost::combine(oids, items)) {
+        ghobject_t oid;
+        onode_item_t* p_item;
+        boost::tie(oid, p_item) = tup;
+        expected.emplace(oid, p_item);
+      }
+      std::size_t num_scanned = 0;
+      start = ghobject_t();
+      while (start != end) {
+        auto [scan_ret, scan_end] = with_trans_intr(t, [&](auto &t) {
+          return manager->scan_onodes(t, start, end, LIST_LIMIT);
+        }).unsafe_get0();
+        for (auto& [oid, onode] : scan_ret) {
+          ceph_assert(listed_oids[num_scanned] == oid);
+          expected.at(oid)->validate(*onode);
+          ++num_scanned;
+        }
+        start = scan_end;
+      }
+      ceph_assert(num_scanned == listed_oids.size());
     });
   }
 
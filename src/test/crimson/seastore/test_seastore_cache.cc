@@ -254,3 +254,68 @@ TEST_F(cache_test_t, test_dirty_extent)
     }
   });
 }
+
+TEST_F(cache_test_t, test_alloc_with_data)
+{
+  run_async([this] {
+    auto make_data = [](char c) {
+      auto bp = ceph::bufferptr(
+	buffer::create_page_aligned(TestBlockPhysical::SIZE));
+      memset(bp.c_str(), c, bp.length());
+      bufferlist bl;
+      bl.append(std::move(bp));
+      return bl;
+    };
+    auto copied = cache->get_data_copy_bytes();
+    auto adopted = cache->get_data_zero_copy_bytes();
+    auto t = get_transaction();
+    {
+      // nothing else refers to the buffer, it is adopted
+      auto data = make_data('a');
+      auto extent = cache->alloc_new_extent_with_data<TestBlockPhysical>(
+	*t, data);
+      ASSERT_EQ(data.c_str(), extent->get_bptr().c_str());
+      ASSERT_EQ(adopted + TestBlockPhysical::SIZE,
+		cache->get_data_zero_copy_bytes());
+      ASSERT_EQ(copied, cache->get_data_copy_bytes());
+    }
+    {
+      // the buffer is shared, say with the message, it is copied
+      auto data = make_data('b');
+      auto message = data;
+      auto extent = cache->alloc_new_extent_with_data<TestBlockPhysical>(
+	*t, data);
+      ASSERT_NE(data.c_str(), extent->get_bptr().c_str());
+      ASSERT_TRUE(extent->get_bptr().is_page_aligned());
+      ASSERT_EQ(0, memcmp(data.c_str(), extent->get_bptr().c_str(),
+			  TestBlockPhysical::SIZE));
+      // and the extent does not see the changes of the others
+      message.c_str()[0] = 'x';
+      ASSERT_EQ('b', extent->get_bptr()[0]);
+      ASSERT_EQ(adopted + TestBlockPhysical::SIZE,
+		cache->get_data_zero_copy_bytes());
+      ASSERT_EQ(copied + TestBlockPhysical::SIZE,
+		cache->get_data_copy_bytes());
+    }
+    {
+      // several buffers are copied as well
+      bufferlist data;
+      for (int i = 0; i < 2; i++) {
+	auto bp = ceph::bufferptr(
+	  buffer::create_page_aligned(TestBlockPhysical::SIZE / 2));
+	memset(bp.c_str(), 'c' + i, bp.length());
+	data.append(std::move(bp));
+      }
+      ASSERT_EQ(2u, data.get_num_buffers());
+      auto extent = cache->alloc_new_extent_with_data<TestBlockPhysical>(
+	*t, data);
+      ASSERT_EQ('c', extent->get_bptr()[0]);
+      ASSERT_EQ('d', extent->get_bptr()[TestBlockPhysical::SIZE - 1]);
+      ASSERT_EQ(adopted + TestBlockPhysical::SIZE,
+		cache->get_data_zero_copy_bytes());
+      ASSERT_EQ(copied + 2 * TestBlockPhysical::SIZE,
+		cache->get_data_copy_bytes());
+    }
+    submit_transaction(std::move(t)).get0();
+  });
+}
@@ -0,0 +1,152 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <seastar/core/later.hh>
+
+#include "test/crimson/gtest_seastar.h"
+
+#include "crimson/osd/txn_batcher.h"
+
+using crimson::osd::TxnBatcher;
+
+namespace {
+
+ceph::os::Transaction make_txn()
+{
+  ceph::os::Transaction txn;
+  txn.nop();
+  return txn;
+}
+
+hobject_t make_hoid(const std::string& name)
+{
+  return hobject_t{object_t{name}, "", CEPH_NOSNAP, 0, 1, ""};
+}
+
+}
+
+struct txn_batcher_test_t : public seastar_test_suite_t {
+  /// the number of ops of each store transaction, in submission order
+  std::vector<int> submitted;
+  /// fail the next store transactions
+  bool fail = false;
+  /// hold the next store transactions until it is set
+  std::optional<seastar::shared_promise<>> hold;
+  seastar::future<> do_transaction(ceph::os::Transaction&& txn) {
+    submitted.push_back(txn.get_num_ops());
+    if (fail) {
+      return seastar::make_exception_future<>(
+        std::runtime_error("injected"));
+    }
+    if (hold) {
+      return hold->get_shared_future();
+    }
+    return seastar::now();
+  }
+  TxnBatcher batcher{[this](ceph::os::Transaction&& txn) {
+    return do_transaction(std::move(txn));
+  }};
+
+  seastar::future<> tear_down_fut() final {
+    hold.reset();
+    return batcher.stop();
+  }
+};
+
+TEST_F(txn_batcher_test_t, no_batching)
+{
+  run_async([this] {
+    auto a = batcher.add(make_hoid("a"), make_txn(), 1);
+    auto b = batcher.add(make_hoid("b"), make_txn(), 1);
+    // submitted right away, in order
+    EXPECT_EQ(std::vector<int>({1, 1}), submitted);
+    a.get();
+    b.get();
+  });
+}
+
+TEST_F(txn_batcher_test_t, batching)
+{
+  run_async([this] {
+    std::vector<seastar::future<>> committed;
+    for (auto name : {"a", "b", "c"}) {
+      committed.push_back(batcher.add(make_hoid(name), make_txn(), 16));
+    }
+    // the batch is submitted once the task yields
+    EXPECT_TRUE(submitted.empty());
+    seastar::when_all_succeed(committed.begin(), committed.end()).get();
+    EXPECT_EQ(std::vector<int>({3}), submitted);
+  });
+}
+
+TEST_F(txn_batcher_test_t, full_batch)
+{
+  run_async([this] {
+    auto a = batcher.add(make_hoid("a"), make_txn(), 2);
+    auto b = batcher.add(make_hoid("b"), make_txn(), 2);
+    EXPECT_EQ(std::vector<int>({2}), submitted);
+    auto c = batcher.add(make_hoid("c"), make_txn(), 2);
+    a.get();
+    b.get();
+    c.get();
+    EXPECT_EQ(std::vector<int>({2, 1}), submitted);
+  });
+}
+
+TEST_F(txn_batcher_test_t, same_object)
+{
+  run_async([this] {
+    auto a1 = batcher.add(make_hoid("a"), make_txn(), 16);
+    auto b = batcher.add(make_hoid("b"), make_txn(), 16);
+    // a second write to "a" does not join the batch of the first one
+    auto a2 = batcher.add(make_hoid("a"), make_txn(), 16);
+    EXPECT_EQ(std::vector<int>({2}), submitted);
+    a1.get();
+    b.get();
+    a2.get();
+    EXPECT_EQ(std::vector<int>({2, 1}), submitted);
+  });
+}
+
+TEST_F(txn_batcher_test_t, failure)
+{
+  run_async([this] {
+    fail = true;
+    auto a = batcher.add(make_hoid("a"), make_txn(), 16);
+    auto b = batcher.add(make_hoid("b"), make_txn(), 16);
+    // the failure of the store transaction fails all of its writes
+    EXPECT_THROW(a.get(), std::runtime_error);
+    EXPECT_THROW(b.get(), std::runtime_error);
+    fail = false;
+    batcher.add(make_hoid("a"), make_txn(), 16).get();
+    EXPECT_EQ(std::vector<int>({2, 1}), submitted);
+  });
+}
+
+TEST_F(txn_batcher_test_t, stop)
+{
+  run_async([this] {
+    TxnBatcher stopping{[this](ceph::os::Transaction&& txn) {
+      return do_transaction(std::move(txn));
+    }};
+    hold.emplace();
+    auto a = stopping.add(make_hoid("a"), make_txn(), 16);
+    auto b = stopping.add(make_hoid("b"), make_txn(), 16);
+    // stop() submits the pending batch ...
+    auto stopped = stopping.stop();
+    EXPECT_EQ(std::vector<int>({2}), submitted);
+    // ... and waits until the store is done with it
+    seastar::later().get();
+    EXPECT_FALSE(stopped.available());
+    EXPECT_FALSE(a.available());
+    hold->set_value();
+    stopped.get();
+    a.get();
+    b.get();
+    EXPECT_EQ(std::vector<int>({2}), submitted);
+  });
+}
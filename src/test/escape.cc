@@ -126,3 +126,63 @@ TEST(EscapeJson, Utf8) {
   EXPECT_EQ(escape_json_attrs("\xe6\xb1\x89\xe5\xad\x97\n"), "\xe6\xb1\x89\xe5\xad\x97\\n");
   EXPECT_EQ(escape_json_stream("\xe6\xb1\x89\xe5\xad\x97\n"), "\xe6\xb1\x89\xe5\xad\x97\\n");
 }
+
+static std::string escape_json_append(std::string_view s)
+{
+  std::string out;
+  escape_json_append(s, out);
+  return out;
+}
+
+TEST(EscapeJson, Offsets) {
+  // the bytes to escape are looked for 8 or 16 at a time, so put them at
+  // the edges of these words
+  const std::pair<char, std::string> chars[] = {
+    {'"', "\\\""},
+    {'\\', "\\\\"},
+    {'\x1f', "\\u001f"},
+    {'\x7f', "\\u007f"},
+    {'\x80', "\x80"},
+    {'\xff', "\xff"},
+  };
+  for (char fill : {'a', '\xe6'}) {
+    for (size_t len : {18, 33}) {
+      for (auto& [c, escaped] : chars) {
+	for (size_t offset : {0, 7, 8, 15, 16, 17}) {
+	  std::string s(len, fill);
+	  s[offset] = c;
+	  std::string expected = std::string(offset, fill) + escaped +
+	    std::string(len - offset - 1, fill);
+	  SCOPED_TRACE(testing::Message() << "fill " << int(fill)
+		       << " len " << len << " char " << int(c)
+		       << " offset " << offset);
+	  EXPECT_EQ(expected, escape_json_append(s));
+	  EXPECT_EQ(expected, escape_json_stream(s.data(), s.size()));
+	  EXPECT_EQ(expected, escape_json_attrs(s.data(), s.size()));
+	}
+      }
+    }
+  }
+}
+
+TEST(EscapeJson, Runs) {
+  // several escapes in a word, and in consecutive words
+  std::string s(40, 'x');
+  for (size_t offset : {0, 1, 7, 8, 9, 15, 16, 23, 24, 31, 32, 39}) {
+    s[offset] = '"';
+  }
+  std::string expected;
+  for (char c : s) {
+    if (c == '"') {
+      expected += "\\\"";
+    } else {
+      expected += c;
+    }
+  }
+  EXPECT_EQ(expected, escape_json_append(s));
+  EXPECT_EQ(expected, escape_json_stream(s.data(), s.size()));
+
+  // only the end of the string is scanned a byte at a time
+  std::string tail = std::string(16, 'x') + "\t\n";
+  EXPECT_EQ(std::string(16, 'x') + "\\t\\n", escape_json_append(tail));
+}
@@ -15,6 +15,8 @@
 #include "gtest/gtest.h"
 #include "common/Formatter.h"
 #include "common/HTMLFormatter.h"
+#include "include/buffer.h"
+#include "include/page.h"
 
 #include <sstream>
 #include <string>
@@ -69,6 +71,47 @@ TEST(JsonFormatter, Empty) {
   ASSERT_EQ(oss.str(), "");
 }
 
+TEST(JsonFormatter, FlushBufferlist) {
+  // {"s":"..."} around the string
+  const size_t overhead = 8;
+  // the outputs from a page on are handed over to the bufferlist
+  const size_t page = CEPH_PAGE_SIZE;
+  for (size_t len : {page / 16, page - 1, page, page + 1, 3 * page}) {
+    SCOPED_TRACE(testing::Message() << "len " << len);
+    std::string str(len - overhead, 'x');
+    JSONFormatter fmt(false);
+    bufferlist bl;
+    bl.append("head");
+    fmt.open_object_section("foo");
+    fmt.dump_string("s", str);
+    fmt.close_section();
+    fmt.flush(bl);
+    std::string expected = "head{\"s\":\"" + str + "\"}";
+    ASSERT_EQ(expected.size(), bl.length());
+    ASSERT_EQ(expected, bl.to_str());
+
+    // the formatter is reusable after a flush, and the bufferlist does not
+    // see what comes next
+    fmt.open_object_section("bar");
+    fmt.dump_int("i", 1);
+    fmt.close_section();
+    bufferlist bl2;
+    fmt.flush(bl2);
+    ASSERT_EQ("{\"i\":1}", bl2.to_str());
+    ASSERT_EQ(expected, bl.to_str());
+  }
+}
+
+TEST(JsonFormatter, FlushBufferlistLineBreak) {
+  JSONFormatter fmt(false);
+  fmt.enable_line_break();
+  std::string str(CEPH_PAGE_SIZE, 'x');
+  fmt.dump_string("s", str);
+  bufferlist bl;
+  fmt.flush(bl);
+  ASSERT_EQ("\"" + str + "\"\n", bl.to_str());
+}
+
 TEST(XmlFormatter, Simple1) {
   ostringstream oss;
   XMLFormatter fmt(false);
@@ -91,6 +91,39 @@ TEST(KernelDevice, Ticket45337) {
   b->close();
 }
 
+#if defined(HAVE_BLUESTORE_PMEM)
+TEST(PMEMDevice, EmulatedDax) {
+  // a regular file is mapped as emulated DAX and persisted on flush
+  uint64_t size = 1048576ull * 16;
+  TempBdev bdev{ size };
+
+  std::unique_ptr<BlockDevice> b(
+    BlockDevice::create(g_ceph_context, bdev.path, NULL, NULL,
+      [](void* handle, void* aio) {}, NULL, "pmem"));
+  ASSERT_EQ(b->open(bdev.path), 0);
+  ASSERT_EQ(b->get_size(), size);
+
+  bufferlist bl;
+  string s(8192, 'p');
+  for (unsigned i = 0; i < 4096; i++) {
+    s += '0' + (i % 10);
+  }
+  bl.append(s);
+  std::unique_ptr<IOContext> ioc(new IOContext(g_ceph_context, NULL));
+  ASSERT_EQ(b->aio_write(4096, bl, ioc.get(), false), 0);
+  b->aio_submit(ioc.get());
+  ioc->aio_wait();
+  ASSERT_EQ(b->flush(), 0);
+  b->close();
+
+  ASSERT_EQ(b->open(bdev.path), 0);
+  bufferlist out;
+  ASSERT_EQ(b->read(4096, s.size(), &out, ioc.get(), false), 0);
+  ASSERT_TRUE(out.contents_equal(bl));
+  b->close();
+}
+#endif
+
 int main(int argc, char **argv) {
   auto args = argv_to_vec(argc, argv);
   map<string,string> defaults = {
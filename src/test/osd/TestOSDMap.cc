@@ -10,6 +10,7 @@
 #include "common/common_init.h"
 #include "common/ceph_argparse.h"
 #include "common/ceph_json.h"
+#include "common/Cond.h"
 
 #include <iostream>
 
@@ -201,7 +202,8 @@ public:
                        OSDMap::Incremental& pending_inc) {
     int cpu_num = 8;
     int pgs_per_chunk = 256;
-    ThreadPool tp(cct, "BUG_40104::clean_upmap_tp", "clean_upmap_tp", cpu_num);
+    WorkStealingThreadPool tp(cct, "BUG_40104::clean_upmap_tp",
+			      "clean_upmap_tp", cpu_num);
     tp.start();
     ParallelPGMapper mapper(cct, &tp);
     vector<pg_t> pgs_to_check;
@@ -603,6 +605,40 @@ TEST_F(OSDMapTest, parse_osd_id_list) {
   ASSERT_EQ(-EINVAL, osdmap.parse_osd_id_list({"-12"}, &out, &cout));
 }
 
+TEST_F(OSDMapTest, ParallelPGMapperDiscard) {
+  set_up_map();
+  struct CountingJob : public ParallelPGMapper::Job {
+    std::atomic<unsigned> processed = {0};
+    bool completed = false;
+    explicit CountingJob(const OSDMap *om) : Job(om) {}
+    void process(const vector<pg_t>& pgs) override {
+      processed += pgs.size();
+    }
+    void process(int64_t pool, unsigned ps_begin, unsigned ps_end) override {
+      processed += ps_end - ps_begin;
+    }
+    void complete() override {
+      completed = true;
+    }
+  };
+  WorkStealingThreadPool tp(g_ceph_context, "ParallelPGMapperDiscard::tp",
+			    "discard_tp", 2);
+  tp.start();
+  ParallelPGMapper mapper(g_ceph_context, &tp);
+  CountingJob job(&osdmap);
+  C_SaferCond fin;
+  // the items are still queued when the pool stops
+  tp.pause();
+  mapper.queue(&job, 1, {});
+  job.set_finish_event(&fin);
+  ASSERT_FALSE(job.is_done());
+  tp.stop();
+  ASSERT_TRUE(job.is_done());
+  ASSERT_EQ(-ECANCELED, fin.wait());
+  ASSERT_EQ(0u, job.processed);
+  ASSERT_FALSE(job.completed);
+}
+
 TEST_F(OSDMapTest, CleanPGUpmaps) {
   set_up_map();
 
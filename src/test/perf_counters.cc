@@ -255,3 +255,45 @@ TEST(PerfCounters, read_avg) {
   t2.join();
   t1.join();
 }
+
+enum {
+  TEST_PERFCOUNTERS4_ELEMENT_FIRST = 500,
+  TEST_PERFCOUNTERS4_ELEMENT_OPS,
+  TEST_PERFCOUNTERS4_ELEMENT_LAT,
+  TEST_PERFCOUNTERS4_ELEMENT_LAST,
+};
+
+TEST(PerfCounters, concurrent_inc) {
+  PerfCountersBuilder bld(g_ceph_context, "test_percounter_4",
+      TEST_PERFCOUNTERS4_ELEMENT_FIRST, TEST_PERFCOUNTERS4_ELEMENT_LAST);
+  bld.add_u64_counter(TEST_PERFCOUNTERS4_ELEMENT_OPS, "ops");
+  bld.add_time_avg(TEST_PERFCOUNTERS4_ELEMENT_LAT, "lat");
+  std::shared_ptr<PerfCounters> fake_pf(bld.create_perf_counters());
+
+  // the threads may update different shards, which are summed up on read
+  constexpr uint64_t num_threads = 8;
+  constexpr uint64_t num_incs = 10000;
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([fake_pf] {
+      for (uint64_t j = 0; j < num_incs; ++j) {
+	fake_pf->inc(TEST_PERFCOUNTERS4_ELEMENT_OPS);
+	fake_pf->tinc(TEST_PERFCOUNTERS4_ELEMENT_LAT, ceph::timespan(1));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(num_threads * num_incs,
+	    fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_OPS));
+  auto [count, sum] = fake_pf->get_tavg_ns(TEST_PERFCOUNTERS4_ELEMENT_LAT);
+  ASSERT_EQ(num_threads * num_incs, count);
+  ASSERT_EQ(num_threads * num_incs, sum);
+
+  fake_pf->set(TEST_PERFCOUNTERS4_ELEMENT_OPS, 42);
+  ASSERT_EQ(42u, fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_OPS));
+  fake_pf->reset();
+  ASSERT_EQ(0u, fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_OPS));
+  ASSERT_EQ(0u, fake_pf->get_tavg_ns(TEST_PERFCOUNTERS4_ELEMENT_LAT).first);
+}
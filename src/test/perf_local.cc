@@ -33,6 +33,7 @@
 //   as a guideline, and be sure to generate output in the same form as
 //   other tests.
 // * Create a new entry for the test in the #tests table.
+#include <thread>
 #include <vector>
 #include <sched.h>
 
@@ -49,6 +50,7 @@
 #include "common/Cycles.h"
 #include "common/Cond.h"
 #include "common/ceph_mutex.h"
+#include "common/perf_counters.h"
 #include "common/Thread.h"
 #include "common/Timer.h"
 #include "msg/async/Event.h"
@@ -903,6 +905,77 @@ double vector_push_pop()
   return Cycles::to_seconds(stop - start)/(count*3);
 }
 
+enum {
+  l_perf_local_first = 1000,
+  l_perf_local_ops,
+  l_perf_local_last,
+};
+
+static std::unique_ptr<PerfCounters> create_perf_counters()
+{
+  PerfCountersBuilder b(g_ceph_context, "perf_local",
+			l_perf_local_first, l_perf_local_last);
+  b.add_u64_counter(l_perf_local_ops, "ops");
+  return std::unique_ptr<PerfCounters>(b.create_perf_counters());
+}
+
+// Measure the cost of incrementing a perf counter
+double perf_counter_inc()
+{
+  int count = 1000000;
+  auto logger = create_perf_counters();
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    logger->inc(l_perf_local_ops);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of calling inc() from 4 threads running on different
+// cpus at the same time; returns the elapsed time divided by the number of
+// calls made by each thread.
+template <typename Inc>
+double concurrent_inc(Inc&& inc)
+{
+  const int num_threads = 4;
+  int count = 1000000;
+  std::atomic<bool> go = false;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      bind_thread_to_cpu(t);
+      while (!go) {
+	// wait for the others
+      }
+      for (int i = 0; i < count; i++) {
+	inc();
+      }
+    });
+  }
+  uint64_t start = Cycles::rdtsc();
+  go = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of incrementing an atomic int shared by 4 threads
+double atomic_int_inc_concurrent()
+{
+  std::atomic<uint64_t> value = 0;
+  return concurrent_inc([&value] { value++; });
+}
+
+// Measure the cost of incrementing a perf counter shared by 4 threads
+double perf_counter_inc_concurrent()
+{
+  auto logger = create_perf_counters();
+  return concurrent_inc([&logger] { logger->inc(l_perf_local_ops); });
+}
+
 // Measure the cost of ceph_clock_now
 double perf_ceph_clock_now()
 {
@@ -1005,6 +1078,12 @@ TestInfo tests[] = {
     "Push and pop a std::vector"},
   {"ceph_clock_now", perf_ceph_clock_now,
    "ceph_clock_now function"},
+  {"perf_counter_inc", perf_counter_inc,
+   "PerfCounters::inc"},
+  {"atomic_int_inc_mt", atomic_int_inc_concurrent,
+   "atomic_t::inc by 4 threads"},
+  {"perf_counter_inc_mt", perf_counter_inc_concurrent,
+   "PerfCounters::inc by 4 threads"},
 };
 
 /**
@@ -15,6 +15,8 @@
  */
 
 #include <stdio.h>
+#include <condition_variable>
+#include <thread>
 
 #include "global/global_init.h"
 #include "common/ceph_argparse.h"
@@ -433,6 +435,89 @@ TEST(mempool, check_shard_select)
   EXPECT_LT(missed, mempool::num_shards / 2);
 }
 
+TEST(mempool, thread_cache)
+{
+  auto& pool = mempool::get_pool(mempool::unittest_1::id);
+  size_t items = pool.allocated_items();
+  size_t bytes = pool.allocated_bytes();
+
+  // the calling thread sees its own cached counts
+  pool.adjust_count(1, 10);
+  ASSERT_EQ(items + 1, pool.allocated_items());
+  ASSERT_EQ(bytes + 10, pool.allocated_bytes());
+
+  // those of another thread show up once it is gone
+  std::thread([&pool] {
+    pool.adjust_count(2, 20);
+  }).join();
+  ASSERT_EQ(items + 3, pool.allocated_items());
+  ASSERT_EQ(bytes + 30, pool.allocated_bytes());
+
+  // or once they reach the flush threshold
+  std::mutex lock;
+  std::condition_variable cond;
+  bool done = false;
+  std::thread t([&] {
+    pool.adjust_count(mempool::flush_items, mempool::flush_bytes);
+    std::unique_lock l(lock);
+    cond.wait(l, [&done] { return done; });
+    pool.adjust_count(-mempool::flush_items, -mempool::flush_bytes);
+  });
+  while (pool.allocated_items() < items + 3 + mempool::flush_items) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(bytes + 30 + mempool::flush_bytes, pool.allocated_bytes());
+  {
+    std::lock_guard l(lock);
+    done = true;
+  }
+  cond.notify_one();
+  t.join();
+
+  pool.adjust_count(-3, -30);
+  pool.flush_thread_cache();
+  ASSERT_EQ(items, pool.allocated_items());
+  ASSERT_EQ(bytes, pool.allocated_bytes());
+}
+
+TEST(mempool, thread_cache_flush_request)
+{
+  auto& pool = mempool::get_pool(mempool::unittest_2::id);
+  size_t items = pool.allocated_items();
+
+  std::mutex lock;
+  std::condition_variable cond;
+  int step = 0;
+  auto wait_for = [&](int s) {
+    std::unique_lock l(lock);
+    cond.wait(l, [&] { return step == s; });
+  };
+  auto go = [&](int s) {
+    std::lock_guard l(lock);
+    step = s;
+    cond.notify_all();
+  };
+  std::thread t([&] {
+    pool.adjust_count(1, 10);
+    go(1);
+    wait_for(2);
+    // the next allocation honors the flush request
+    pool.adjust_count(1, 10);
+    go(3);
+    wait_for(4);
+    pool.adjust_count(-2, -20);
+  });
+  wait_for(1);
+  ASSERT_EQ(items, pool.allocated_items());
+  mempool::request_thread_cache_flush();
+  go(2);
+  wait_for(3);
+  ASSERT_EQ(items + 2, pool.allocated_items());
+  go(4);
+  t.join();
+  ASSERT_EQ(items, pool.allocated_items());
+}
+
 
 int main(int argc, char **argv)
 {
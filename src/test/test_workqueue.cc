@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 
+#include <thread>
+
 #include "common/WorkQueue.h"
 #include "common/ceph_argparse.h"
 
@@ -96,3 +98,75 @@ TEST(WorkQueue, change_timeout){
     ASSERT_EQ(ceph::make_timespan(40), wq.suicide_interval);
     tp.stop();
 }
+
+class counting_wq : public WorkStealingThreadPool::WorkQueue<int> {
+public:
+  std::atomic<int> processed = {0};
+  std::atomic<int> discarded = {0};
+  counting_wq(WorkStealingThreadPool *tp)
+    : WorkStealingThreadPool::WorkQueue<int>("counting_wq",
+					      ceph::make_timespan(10),
+					      ceph::make_timespan(0), tp) {}
+  void _process(int *item, ThreadPool::TPHandle &handle) override {
+    ++processed;
+  }
+  void _discard(int *item) override {
+    ++discarded;
+  }
+};
+
+TEST(WorkStealingThreadPool, StartStop)
+{
+  WorkStealingThreadPool tp(g_ceph_context, "foo", "tp_foo", 4);
+  ASSERT_EQ(4u, tp.get_num_threads());
+  tp.start();
+  tp.pause();
+  tp.pause_new();
+  tp.unpause();
+  tp.unpause();
+  tp.drain();
+  tp.stop();
+}
+
+TEST(WorkStealingThreadPool, Drain)
+{
+  WorkStealingThreadPool tp(g_ceph_context, "foo", "tp_foo", 4);
+  counting_wq wq(&tp);
+  tp.start();
+  int item = 0;
+  const int num_producers = 4, num_items = 10000;
+  std::vector<std::thread> producers;
+  for (int i = 0; i < num_producers; i++) {
+    producers.emplace_back([&] {
+      for (int j = 0; j < num_items; j++) {
+	wq.queue(&item);
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  wq.drain();
+  ASSERT_TRUE(wq.empty());
+  ASSERT_EQ(num_producers * num_items, wq.processed);
+  tp.stop();
+}
+
+TEST(WorkStealingThreadPool, PauseStop)
+{
+  WorkStealingThreadPool tp(g_ceph_context, "foo", "tp_foo", 2);
+  counting_wq wq(&tp);
+  tp.start();
+  tp.pause();
+  int item = 0;
+  for (int i = 0; i < 100; i++) {
+    wq.queue(&item);
+  }
+  sleep(1);
+  ASSERT_EQ(0, wq.processed);
+  ASSERT_FALSE(wq.empty());
+  tp.stop();
+  ASSERT_EQ(100, wq.discarded);
+  ASSERT_TRUE(wq.empty());
+  tp.unpause();
+}
@@ -0,0 +1,55 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * ceph-log-decode -- print the entries of a binary log (see
+ * log_binary_file) in the format of the log file
+ *
+ * USAGE
+ *
+ *     ceph-log-decode /var/log/ceph/ceph-osd.0.blog
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "log/BinaryLog.h"
+#include "log/LogClock.h"
+
+using ceph::logging::BinaryLogEntry;
+
+static void usage(const char* name)
+{
+  std::cerr << "usage: " << name << " <binary log file>" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2) {
+    usage(argv[0]);
+    return 1;
+  }
+  std::string arg = argv[1];
+  if (arg == "-h" || arg == "--help") {
+    usage(argv[0]);
+    return 0;
+  }
+
+  std::vector<BinaryLogEntry> entries;
+  int r = ceph::logging::read_binary_log(arg, &entries, &std::cerr);
+  if (r < 0) {
+    std::cerr << std::endl;
+    return 1;
+  }
+  for (const auto& e : entries) {
+    char stamp[64];
+    ceph::logging::append_time(e.stamp, stamp, sizeof(stamp));
+    std::cout << fmt::format("{} {:x} {:2d} {}\n",
+			     stamp, e.thread, e.prio, e.message);
+  }
+  std::cout.flush();
+  return std::cout ? 0 : 1;
+}